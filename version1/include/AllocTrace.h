@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace my_memorypool
+{
+
+// 分配轨迹记录器（可选）：将每次 allocate / deallocate 以定长二进制记录写入内存映射文件，
+// 供 trace_replay 按原始线程结构回放。关闭时快路径只多一次 relaxed 读。
+// 开启方式：MemoryPool::startTrace(path) 或设置环境变量 MEMPOOL_TRACE_FILE（进程启动时生效）
+class AllocTrace
+{
+public:
+    enum Op : uint8_t
+    {
+        None = 0,        // 未写入的槽位（线程预留块的尾部），回放时跳过
+        Allocate = 1,
+        Deallocate = 2,
+    };
+
+    struct Record
+    {
+        uint64_t timestamp; // 距开始记录的纳秒数
+        uint64_t object;    // 对象地址，释放后可能被复用，回放时按生命周期重新编号
+        uint64_t size;
+        uint32_t thread;    // 记录线程编号（从 1 开始）
+        uint8_t op;
+        uint8_t reserved[3];
+    };
+    static_assert(sizeof(Record) == 32, "trace record layout is part of the file format");
+
+    struct FileHeader
+    {
+        char magic[8];        // "MPTRACE1"
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t recordCount; // 文件中的槽位数（含 None）
+        uint64_t dropped;     // 容量不足丢弃的记录数
+    };
+
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t DEFAULT_CAPACITY = 16 * 1024 * 1024; // 默认最多 16M 条记录（512MB）
+
+    // 开始记录到 path（覆盖），maxRecords 为文件容量；已在记录时先结束上一次
+    static bool start(const char* path, size_t maxRecords = DEFAULT_CAPACITY);
+    // 结束记录：等正在写入的线程完成后写回文件头、截掉未用的尾部并解除映射
+    static void stop();
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    static void record(Op op, void* ptr, size_t size);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include "Common.h"
+#include "Heap.h"
+#include "Options.h"
 #include <mutex>
 #include <unordered_map>
 #include <array>
@@ -15,60 +17,153 @@ struct SpanTracker {
     std::atomic<size_t> numPages{0};
     std::atomic<size_t> blockCount{0};
     std::atomic<size_t> freeCount{0}; // 用于追踪span中还有多少块是空闲得，如果所有块都空闲，则归还span给PageCache
+    std::atomic<size_t> colourOffset{0}; // 第一个块相对 span 起始地址的着色偏移
 };
 
-class CentralCache
+template<typename Policy>
+class BasicPageCache;
+
+template<typename Policy>
+class BasicCentralCache
 {
 public:
-    static CentralCache& getInstance()
-    {
-        static CentralCache instance;
-        return instance;
-    }
+    using Traits = PolicyTraits<Policy>;
+    using PageCache = BasicPageCache<Policy>;
+
+    static constexpr size_t ALIGNMENT = Traits::ALIGNMENT;
+    static constexpr size_t FREE_LIST_SIZE = Traits::FREE_LIST_SIZE;
+    static constexpr size_t PAGE_SIZE = Traits::PAGE_SIZE;
+
+    // 由所属 Heap 创建，span 均来自该 Heap 的 PageCache
+    explicit BasicCentralCache(PageCache& pageCache);
+
+    BasicCentralCache(const BasicCentralCache&) = delete;
+    BasicCentralCache& operator=(const BasicCentralCache&) = delete;
 
     // 从中心缓存获取一定数量的内存对象
     // boot: 输出参数，返回获取到的第一个对象
     // batchNum: 输入期望获取的数量，输出实际获取的数量
     // 返回值: 获取到的对象的字节总数（用于更新统计，可选）或者返回实际获取数量
-    size_t fetchRange(void*& start, void*& end, size_t batchNum, size_t index);
+    // zeroed 非空时写入这批块是否刚从已知全 0 的 span 切出（除首字的 next 指针外均为 0）
+    size_t fetchRange(void*& start, void*& end, size_t batchNum, size_t index, bool* zeroed = nullptr);
     
     // 原接口为了兼容性先保留，或者直接删除替换
     // void* fetchRange(size_t index); 
     void returnRange(void* start, size_t size, size_t index);
 
+    // 丢弃所有自由链表与span信息（内存由 PageCache::releaseAll 整体归还）
+    void reset();
+
+    // 对每个有空闲块的 size-class 立即做一次延迟归还扫描，把完全空闲的 span 交回 PageCache（内存压力时调用）
+    void trim();
+
+    // 自由链表及未切分区域中的字节数
+    size_t freeBytes() const { return freeBytes_.load(std::memory_order_relaxed); }
+    // 已交给线程缓存的字节数（含线程缓存中空闲的块与正在使用的对象）
+    size_t threadBytes() const { return threadBytes_.load(std::memory_order_relaxed); }
+
+    // 争用统计快照（只包含有记录的 size-class），未开启 ENABLE_CENTRAL_STATS 时为空
+    std::vector<CentralClassStats> contentionStats() const;
+    void resetContentionStats();
+
 private:
-    // 初始化所有原子指针为nullptr
-    CentralCache();
+    // 每个 size-class 独占一条缓存行，避免相邻 size-class 的计数互相干扰
+    struct alignas(Policy::CACHE_LINE) ContentionCounters
+    {
+        std::atomic<uint64_t> lockAcquisitions{0};
+        std::atomic<uint64_t> lockSpins{0};
+        std::atomic<uint64_t> casFailures{0};
+        std::atomic<uint64_t> fallbackLocks{0};
+        std::atomic<uint64_t> delayReturns{0};
+        std::atomic<uint64_t> delayReturnNs{0};
+    };
+
+    // 新 span 不再一次性串成链表，而是用 [cursor, limit) 按批切分，页面在真正被使用时才触碰
+    struct CarveRegion
+    {
+        char* cursor = nullptr;
+        char* limit = nullptr;
+        SpanTracker* tracker = nullptr;
+        uint32_t nextColour = 0; // 下一个 span 使用的颜色
+        bool zeroed = false;     // 当前 span 来自已知全 0 的页：未切出的块除切分时写入的 next 指针外均为 0
+    };
+
+    // 单个 size-class 的全部状态放在一条缓存行内：补货 / 归还只碰这一行，相邻 size-class 之间不再伪共享。
+    // 首次用到该 size-class 时才从 PageCache 的页中切出，从未使用的 size-class 只占指针表中的一项
+    struct alignas(Policy::CACHE_LINE) Bucket
+    {
+        std::atomic<void*> freeList{nullptr};       // 中心缓存的自由链表
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;    // 自旋锁：保护 fetchRange 摘链与切分
+        std::atomic_flag returnBusy = ATOMIC_FLAG_INIT; // 延迟归还：每个 size-class 仅允许一个线程执行扫描
+        std::atomic<size_t> delayCount{0};           // 延迟计数
+        std::chrono::steady_clock::time_point lastReturnTime = std::chrono::steady_clock::now(); // 上次归还时间
+        CarveRegion carve;                           // 受 lock 保护
+#if ENABLE_CENTRAL_STATS
+        ContentionCounters contention;               // 统计放在紧随其后的缓存行
+#endif
+    };
+    static_assert(ENABLE_CENTRAL_STATS || sizeof(Bucket) == Policy::CACHE_LINE,
+                  "a size-class bucket must fit in one cache line");
+
+    // 关闭 ENABLE_CENTRAL_STATS 时为空函数
+    void count(Bucket& bucket, std::atomic<uint64_t> ContentionCounters::* counter, uint64_t n = 1)
+    {
+#if ENABLE_CENTRAL_STATS
+        (bucket.contention.*counter).fetch_add(n, std::memory_order_relaxed);
+#else
+        (void)bucket; (void)counter; (void)n;
+#endif
+    }
+
+    // 尚未用到的 size-class 返回 nullptr
+    Bucket* bucketFor(size_t index) const { return buckets_[index].load(std::memory_order_acquire); }
+    // 慢路径：首次用到时切出该 size-class 的桶，PageCache 申请失败时返回 nullptr
+    Bucket* ensureBucket(size_t index);
+
+    // 自旋获取 / 释放桶的锁
+    void lock(Bucket& bucket);
+    void unlock(Bucket& bucket) { bucket.lock.clear(std::memory_order_release); }
+
     // 从页缓存获取内存
     void* fetchFromPageCache(size_t size);
 
+    // 从当前 span 的未切分区域切出至多 batchNum 个块，区域用完时申请新 span（需持有桶的锁）
+    size_t carveLocked(void*& start, void*& end, size_t batchNum, size_t index, Bucket& bucket);
+
     // 获取span信息
     SpanTracker* getSpanTracker(void* blockAddr);
 
-    // 更新span的空闲计数并检查是否可以归还
-    void updateSpanFreeCount(SpanTracker* tracker, size_t newFreeBlocks, size_t indnex);
+    // 为新 span 占用一个 tracker 槽（优先复用已清空的槽），槽位用尽时返回 nullptr
+    SpanTracker* registerSpan(void* spanAddr, size_t numPages, size_t blockNum, size_t colourOffset);
+    // 清空 tracker 并把 span 归还给 PageCache
+    void releaseSpan(SpanTracker* tracker);
 
 private:
-    // 中心缓存的自由链表
-    std::array<std::atomic<void*>, FREE_LIST_SIZE> centralFreeList_;
+    PageCache& pageCache_;
 
-    // 用于同步的自旋锁
-    std::array<std::atomic_flag,FREE_LIST_SIZE> locks_;
-    // 延迟归还的并发保护：每个大小类仅允许一个线程执行归还扫描
-    std::array<std::atomic_flag,FREE_LIST_SIZE> returnBusy_;
+    // 各 size-class 的桶指针，桶在首次使用时创建，之后直到 reset 都不变
+    std::array<std::atomic<Bucket*>, FREE_LIST_SIZE> buckets_;
+    // 桶从 PageCache 的页中依次切出（页随 PageCache::releaseAll 归还），创建桶的慢路径持有该锁
+    std::mutex bucketMutex_;
+    char* bucketCursor_ = nullptr;
+    char* bucketLimit_ = nullptr;
 
     // 使用数组存储span信息，避免map的开销
-    std::array<SpanTracker, 1024> spanTrackers_;
+    std::array<SpanTracker, Traits::SPAN_TRACKER_CAPACITY> spanTrackers_;
     std::atomic<size_t> spanCount_{0};
 
+    // 按批次更新的统计（只在慢路径上修改）
+    std::atomic<size_t> freeBytes_{0};
+    std::atomic<size_t> threadBytes_{0};
+
     // 延迟归还相关成员变量
-    static const size_t MAX_DELAY_COUNT = 48; // 最大延迟计数
-    std::array<std::atomic<size_t>, FREE_LIST_SIZE> delayCounts_; // 每个大小类的延迟计数
-    std::array<std::chrono::steady_clock::time_point, FREE_LIST_SIZE> lastReturnTimes_; // 上次归还时间
-    static const std::chrono::milliseconds DELAY_INTERVAL; // 延迟间隔
+    // 最大延迟计数与延迟间隔由运行期参数 MaxDelayCount / DelayIntervalMs 决定（默认取自策略）
+    RuntimeOptions<Policy>& options_;
 
-    bool shouldPerformDelayedReturn(size_t index, size_t currentCount, std::chrono::steady_clock::time_point currentTime);
-    void performDelayReturn(size_t index);
+    bool shouldPerformDelayedReturn(Bucket& bucket, size_t currentCount, std::chrono::steady_clock::time_point currentTime);
+    void performDelayReturn(size_t index, Bucket& bucket);
 };
 
+using CentralCache = BasicCentralCache<DefaultPolicy>;
+
 }
\ No newline at end of file
@@ -2,14 +2,18 @@
 #include <cstddef>
 #include <atomic>
 #include <array>
+#include <algorithm>
+#include <cstdint>
 #include <stdlib.h>
+#include "Policy.h"
 
 // 定义对齐数和最大内存池大小
 namespace  my_memorypool
 {
-constexpr std::size_t ALIGNMENT = 8;
-constexpr std::size_t MAX_BYTES = 256 * 1024; // 256KB
-constexpr std::size_t FREE_LIST_SIZE = MAX_BYTES / ALIGNMENT; // 支持的 size-class 数 = MAX_BYTES / ALIGNMENT（例如 256KB / 8 = 32768 类）
+// 默认策略下的常量（兼容旧接口），各层内部使用各自策略的常量
+constexpr std::size_t ALIGNMENT = DefaultPolicy::ALIGNMENT;
+constexpr std::size_t MAX_BYTES = DefaultPolicy::MAX_BYTES; // 256KB
+constexpr std::size_t FREE_LIST_SIZE = PolicyTraits<DefaultPolicy>::FREE_LIST_SIZE; // 支持的 size-class 数 = MAX_BYTES / ALIGNMENT（例如 256KB / 8 = 32768 类）
 
 // 性能优先：关闭 Span 追踪（用于 benchmark 场景）
 // 关闭后将减少大量 getSpanTracker 扫描与原子操作开销，但也会禁用延迟回收机制。
@@ -18,6 +22,59 @@ constexpr std::size_t FREE_LIST_SIZE = MAX_BYTES / ALIGNMENT; // 支持的 size-
 #define ENABLE_SPAN_TRACKING 1
 #endif
 
+// 分配轨迹记录（AllocTrace）：编译期开关，开启后仍需运行期 startTrace / MEMPOOL_TRACE_FILE 才会记录
+#ifndef ENABLE_ALLOC_TRACE
+#define ENABLE_ALLOC_TRACE 1
+#endif
+
+// 分配大小直方图（SizeProfile）：编译期开关，开启后仍需运行期 startSizeProfile / MEMPOOL_SIZE_PROFILE 才会统计
+#ifndef ENABLE_SIZE_PROFILE
+#define ENABLE_SIZE_PROFILE 1
+#endif
+
+// 慢路径事件日志（SlowPathLog）：编译期开关，开启后仍需运行期 startSlowPathLog / MEMPOOL_SLOW_PATH_LOG 才会记录
+#ifndef ENABLE_SLOW_PATH_LOG
+#define ENABLE_SLOW_PATH_LOG 1
+#endif
+
+// 小对象位图 slab：编译期开关，默认关闭；开启后 size <= Policy::TINY_SLAB_MAX_BYTES 的对象走 TinySlabCache
+#ifndef ENABLE_TINY_SLABS
+#define ENABLE_TINY_SLABS 0
+#endif
+
+// CentralCache 争用统计：编译期开关，默认关闭，关闭时计数代码完全编译掉
+#ifndef ENABLE_CENTRAL_STATS
+#define ENABLE_CENTRAL_STATS 0
+#endif
+
+// 快路径辅助：分支提示、冷函数（不内联并放入冷代码段，不占用快路径的指令缓存）、预取
+#if defined(__GNUC__) || defined(__clang__)
+#define MEMPOOL_LIKELY(x) __builtin_expect(!!(x), 1)
+#define MEMPOOL_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define MEMPOOL_COLD __attribute__((cold, noinline))
+#define MEMPOOL_PREFETCH(addr) __builtin_prefetch((addr), 1, 3)
+#elif defined(_MSC_VER)
+#define MEMPOOL_LIKELY(x) (x)
+#define MEMPOOL_UNLIKELY(x) (x)
+#define MEMPOOL_COLD __declspec(noinline)
+#define MEMPOOL_PREFETCH(addr) ((void)(addr))
+#else
+#define MEMPOOL_LIKELY(x) (x)
+#define MEMPOOL_UNLIKELY(x) (x)
+#define MEMPOOL_COLD
+#define MEMPOOL_PREFETCH(addr) ((void)(addr))
+#endif
+
+// 线程缓存指针的 TLS 模型：initial-exec 按固定偏移直接访问，不经过 __tls_get_addr 或初始化检查。
+// 内存池编进以 dlopen 加载的共享库时静态 TLS 空间可能不足，此时以 -DMEMPOOL_TLS_MODEL= 编译退回默认模型
+#ifndef MEMPOOL_TLS_MODEL
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+#define MEMPOOL_TLS_MODEL __attribute__((tls_model("initial-exec")))
+#else
+#define MEMPOOL_TLS_MODEL
+#endif
+#endif
+
 // 内存块头部信息
 /*struct BlockHeader
 {
@@ -27,14 +84,52 @@ constexpr std::size_t FREE_LIST_SIZE = MAX_BYTES / ALIGNMENT; // 支持的 size-
 };
 */
 
+// 策略 size-class 表中不超过 MAX_BYTES 的最大类，更大的请求按 ALIGNMENT 步长
+template<typename Policy>
+constexpr size_t sizeClassTableBytes()
+{
+    using Table = typename Policy::SizeClasses;
+    size_t bytes = 0;
+    for(size_t i = 0; i < Table::COUNT; ++i)
+    {
+        if(Table::SIZES[i] <= Policy::MAX_BYTES) bytes = Table::SIZES[i];
+    }
+    return bytes;
+}
+
+// 按 ALIGNMENT 步长的编号 -> 所属类上界的编号，编译期展开
+template<typename Policy, size_t TableBytes>
+constexpr std::array<uint32_t, (TableBytes > 0 ? TableBytes / Policy::ALIGNMENT : 1)> sizeClassLookup()
+{
+    using Table = typename Policy::SizeClasses;
+    std::array<uint32_t, (TableBytes > 0 ? TableBytes / Policy::ALIGNMENT : 1)> lookup{};
+    size_t cls = 0;
+    for(size_t i = 0; i < TableBytes / Policy::ALIGNMENT; ++i)
+    {
+        while(Table::SIZES[cls] < (i + 1) * Policy::ALIGNMENT) ++cls;
+        lookup[i] = static_cast<uint32_t>(Table::SIZES[cls] / Policy::ALIGNMENT - 1);
+    }
+    return lookup;
+}
+
 // 内存块管理（大小）类
-class SizeClass
+// 自由链表按 ALIGNMENT 步长编号；策略带 size-class 表时，请求先向上取整到表中的类，
+// 只有各类上界对应的编号会被用到，其余编号的自由链表（按组惰性分配）不占内存
+template<typename Policy>
+class BasicSizeClass
 {
 public:
+    static constexpr size_t ALIGNMENT = Policy::ALIGNMENT;
+
     static size_t roundUp(size_t bytes)
     {
         // 向上取整到最接近的对齐边界（ALIGNMENT的倍数）
-        return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        size_t aligned = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if constexpr (Table::COUNT > 0)
+        {
+            if(aligned != 0 && aligned <= TABLE_BYTES) aligned = (CLASS_OF[aligned / ALIGNMENT - 1] + 1) * ALIGNMENT;
+        }
+        return aligned;
     }
 
     static size_t getIndex(size_t bytes)
@@ -42,8 +137,20 @@ public:
         // 确保bytes大于等于ALIGNMENT
         bytes = std::max(bytes, ALIGNMENT);
         // 向上取整后-1，计算得到对应索引
-        return (bytes + ALIGNMENT - 1) / ALIGNMENT - 1;
+        size_t index = (bytes + ALIGNMENT - 1) / ALIGNMENT - 1;
+        if constexpr (Table::COUNT > 0)
+        {
+            if(index < TABLE_BYTES / ALIGNMENT) index = CLASS_OF[index];
+        }
+        return index;
     }
+
+private:
+    using Table = typename Policy::SizeClasses;
+    static constexpr size_t TABLE_BYTES = sizeClassTableBytes<Policy>();
+    static constexpr auto CLASS_OF = sizeClassLookup<Policy, TABLE_BYTES>();
 };
 
-}
\ No newline at end of file
+using SizeClass = BasicSizeClass<DefaultPolicy>;
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "Common.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace my_memorypool
+{
+
+// 线程在某个堆上的纪元记录：处于临界区时 state = (纪元 << 1) | 1，否则为 0
+// 记录只增不删，线程退出后置 inUse = false 供新线程复用
+struct alignas(64) EpochRecord
+{
+    std::atomic<uint64_t> state{0};
+    std::atomic<bool> inUse{false};
+    EpochRecord* next = nullptr;
+};
+
+// retire 之后、确认没有读者之前的块按页分块存放，页来自所属堆的 PageCache，retire 本身不申请内存
+// 同一条链上的块都在 epoch 纪元被 retire
+template<typename Policy>
+struct LimboChunk
+{
+    struct Entry
+    {
+        void* ptr;
+        size_t size;
+    };
+    static constexpr size_t CAPACITY = (Policy::PAGE_SIZE - 3 * sizeof(uint64_t)) / sizeof(Entry);
+
+    LimboChunk* next;
+    size_t count;
+    uint64_t epoch;
+    Entry entries[CAPACITY];
+};
+
+// 纪元回收域（每个 Heap 一个）
+// 纪元 e 中 retire 的块在全局纪元到达 e + 2 后一定没有读者：推进到 e + 1 与 e + 2 都要求所有临界区内的线程已观察到前一纪元
+template<typename Policy>
+class BasicEpochDomain
+{
+public:
+    using Chunk = LimboChunk<Policy>;
+
+    BasicEpochDomain() = default;
+    ~BasicEpochDomain();
+
+    BasicEpochDomain(const BasicEpochDomain&) = delete;
+    BasicEpochDomain& operator=(const BasicEpochDomain&) = delete;
+
+    // 占用一条空闲记录，没有时新建（只在线程首次进入临界区时调用）
+    EpochRecord* acquireRecord();
+    void releaseRecord(EpochRecord* record);
+
+    uint64_t epoch() const { return global_.load(std::memory_order_seq_cst); }
+
+    // 所有临界区内的线程都已观察到当前纪元时推进一步，返回（可能推进后的）当前纪元
+    uint64_t tryAdvance();
+
+    // 退出线程留下的待回收链，由之后推进纪元的线程代为释放
+    void adopt(Chunk* chain);
+    bool hasOrphans() const { return hasOrphans_.load(std::memory_order_relaxed); }
+    // 摘下 retire 纪元 <= safeEpoch 的孤儿块，调用方负责释放块与页
+    Chunk* takeOrphans(uint64_t safeEpoch);
+
+    // 堆被 destroy：孤儿块所在的页已随 PageCache 归还
+    void dropOrphans();
+    // 堆被 destroy：各线程在旧 id 上的缓存连同其记录一起作废（此时不应有线程处于临界区）
+    void releaseRecords();
+
+private:
+    // 从 2 开始，safeEpoch = epoch - 2 不会下溢
+    std::atomic<uint64_t> global_{2};
+    std::atomic<EpochRecord*> records_{nullptr};
+
+    std::mutex orphanMutex_;
+    Chunk* orphans_ = nullptr;
+    std::atomic<bool> hasOrphans_{false};
+};
+
+}
@@ -0,0 +1,189 @@
+#pragma once
+#include "Common.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace my_memorypool
+{
+
+template<typename Policy>
+class BasicCentralCache;
+template<typename Policy>
+class BasicPageCache;
+template<typename Policy>
+class BasicThreadCache;
+template<typename Policy>
+class BasicEpochDomain;
+
+// 存活堆登记（与策略无关，所有策略共用一套 id）
+// 线程退出时据此判断所属堆是否仍存活、是否可以归还缓存
+class HeapRegistry
+{
+public:
+    static std::mutex& mutex();
+    // 以下接口需持有 mutex()
+    static uint64_t registerHeap();
+    static void unregisterHeap(uint64_t id);
+    static bool isAlive(uint64_t id);
+};
+
+// 堆内存分布（各层按批次/按 span 统计，观测用，非精确快照）
+struct HeapStats
+{
+    size_t systemBytes = 0;       // 向系统申请的地址空间
+    size_t pageFreeBytes = 0;     // PageCache 中驻留的空闲 span
+    size_t pageReleasedBytes = 0; // PageCache 中已归还物理页的空闲 span
+    size_t largeBytes = 0;        // 大对象 span（正在使用）
+    size_t centralFreeBytes = 0;  // CentralCache 自由链表中的块
+    size_t threadBytes = 0;       // 已交给线程缓存的块（线程缓存中的空闲块 + 正在使用的小对象）
+    size_t lockedBytes = 0;       // 实时模式下预先缺页并锁定的字节数
+    uint64_t budgetFailures = 0;  // 实时模式下预算耗尽导致的分配失败次数
+    size_t committedBytes = 0;    // 驻留字节数，内存上限据此计算
+    uint64_t limitFailures = 0;   // 超过硬上限导致的分配失败次数
+};
+
+// 内存压力通知：超过软上限（hard == false）或因硬上限分配失败（hard == true）后，
+// 在触发线程的慢路径上、堆自身完成裁剪之后调用；回调中可以释放内存，但不应阻塞
+struct MemoryPressure
+{
+    bool hard = false;
+    size_t committedBytes = 0;
+    size_t softLimit = 0;
+    size_t hardLimit = 0;
+};
+using PressureCallback = std::function<void(const MemoryPressure&)>;
+
+// 单个 size-class 在 CentralCache 上的争用情况（需 ENABLE_CENTRAL_STATS）
+struct CentralClassStats
+{
+    size_t blockSize = 0;
+    uint64_t lockAcquisitions = 0; // 获取 locks_[index] 的次数
+    uint64_t lockSpins = 0;        // 获取锁时 test_and_set 失败的次数（每次失败后 yield）
+    uint64_t casFailures = 0;      // 自由链表 CAS 失败次数（无锁入链失败后 yield）
+    uint64_t fallbackLocks = 0;    // CAS 重试超限后改为持锁入链的次数
+    uint64_t delayReturns = 0;     // performDelayReturn 执行次数
+    uint64_t delayReturnNs = 0;    // performDelayReturn 累计耗时
+};
+
+// 独立堆：持有自己的 CentralCache 与 PageCache，线程缓存按堆区分
+// 不同租户/子系统使用不同的 Heap，互不共享 span，可单独统计与整体释放
+template<typename Policy>
+class BasicHeap
+{
+public:
+    using CentralCache = BasicCentralCache<Policy>;
+    using PageCache = BasicPageCache<Policy>;
+
+    BasicHeap();
+    ~BasicHeap();
+
+    BasicHeap(const BasicHeap&) = delete;
+    BasicHeap& operator=(const BasicHeap&) = delete;
+
+    // 进程默认堆（MemoryPool 使用），生命周期与进程相同
+    static BasicHeap& getDefault();
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr, size_t size);
+    // 内容全为 0 的块，见 BasicThreadCache::allocateZeroed
+    void* allocateZeroed(size_t size);
+
+    // 实时模式（见 BasicPageCache::enableRealtime）：预留并锁定 budgetBytes，之后分配不再进入内核，
+    // 预算耗尽时返回 nullptr 而不是继续向系统申请；失败返回 false。destroy 后退出实时模式
+    bool enableRealtime(size_t budgetBytes);
+
+    // 为调用线程预取 count 个 size 大小的块：线程缓存保留至多归还阈值个，其余留在 CentralCache 自由链表
+    // 用于在进入延迟敏感阶段前走完慢路径；分配失败（如预算耗尽）时返回 false
+    bool reserve(size_t size, size_t count);
+
+    // 一次性归还该堆的全部内存，无需逐个释放对象；之后堆可继续使用
+    // 调用方需保证此时没有其他线程正在使用该堆，且不再访问之前分配的内存
+    // 默认堆不支持 destroy（调用无效）
+    void destroy();
+
+    // 该堆当前向系统申请的字节数
+    size_t reservedBytes() const;
+
+    // 内存上限（字节，0 表示不限制），只在 PageCache 需要向系统申请内存时检查，快路径不受影响：
+    //   软上限：归还全部空闲 span，通知各线程缓存在下次慢路径上清空，并裁剪 CentralCache、调用压力回调
+    //   硬上限：归还空闲 span 后仍超出时分配失败（返回 nullptr），触发线程裁剪后重试一次
+    void setMemoryLimit(size_t softLimit, size_t hardLimit);
+
+    // 注册压力回调，返回用于注销的 id
+    uint64_t addPressureCallback(PressureCallback callback);
+    void removePressureCallback(uint64_t id);
+
+    // 由线程缓存在取走压力标志后调用（不持有任何锁）：裁剪 CentralCache、归还空闲 span、调用回调
+    void relievePressure(bool hard);
+
+    // 把调用线程在该堆上的自由链表全部归还 CentralCache
+    void trimThreadCache();
+    // 清空调用线程的缓存，并通知其他线程在下次进入慢路径时清空；随后把完全空闲的 span 交回 PageCache
+    // 其他线程的缓存只能由其自身修改，长期不再分配的线程仍依赖退出时的归还
+    void trimAll();
+
+    // 纪元回收：供无锁结构安全释放节点。读者在 enter/exit 之间访问共享结构，
+    // 写者摘下节点后 retire，所有可能看到它的读者离开临界区后才由 retire 线程放回自己的自由链表
+    void enter();
+    void exit();
+    bool retire(void* ptr, size_t size);
+    // 尝试推进纪元并释放调用线程已安全的待回收块，返回仍在等待的块数
+    size_t reclaim();
+
+    // 每次压力事件或 trimAll 时递增，线程缓存发现变化时清空自由链表
+    uint64_t trimEpoch() const { return trimEpoch_.load(std::memory_order_relaxed); }
+
+    HeapStats stats() const;
+
+    // 有过争用记录的 size-class，按 blockSize 升序；未开启 ENABLE_CENTRAL_STATS 时为空
+    std::vector<CentralClassStats> contentionStats() const;
+    void resetContentionStats();
+
+    // 每次 destroy 后更换 id，线程缓存据此丢弃失效的自由链表
+    uint64_t id() const { return id_.load(std::memory_order_acquire); }
+
+    CentralCache& centralCache() { return *centralCache_; }
+    PageCache& pageCache() { return *pageCache_; }
+    BasicEpochDomain<Policy>& epochDomain() { return *epochDomain_; }
+
+private:
+    std::unique_ptr<PageCache> pageCache_;
+    std::unique_ptr<CentralCache> centralCache_;
+    std::unique_ptr<BasicEpochDomain<Policy>> epochDomain_;
+    std::atomic<uint64_t> id_{0};
+
+    std::atomic<uint64_t> trimEpoch_{0};
+    std::mutex callbackMutex_;
+    std::vector<std::pair<uint64_t, PressureCallback>> callbacks_;
+    uint64_t nextCallbackId_ = 1;
+    size_t softLimit_ = 0;
+    size_t hardLimit_ = 0;
+};
+
+// 纪元临界区的 RAII 封装
+template<typename Policy>
+class BasicEpochGuard
+{
+public:
+    explicit BasicEpochGuard(BasicHeap<Policy>& heap = BasicHeap<Policy>::getDefault())
+        : heap_(heap)
+    {
+        heap_.enter();
+    }
+    ~BasicEpochGuard() { heap_.exit(); }
+
+    BasicEpochGuard(const BasicEpochGuard&) = delete;
+    BasicEpochGuard& operator=(const BasicEpochGuard&) = delete;
+
+private:
+    BasicHeap<Policy>& heap_;
+};
+
+using Heap = BasicHeap<DefaultPolicy>;
+using EpochGuard = BasicEpochGuard<DefaultPolicy>;
+
+}
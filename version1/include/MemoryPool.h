@@ -1,21 +1,195 @@
 #pragma once
 #include "ThreadCache.h"
+#include "AllocTrace.h"
+#include "SizeProfile.h"
+#include "SlowPathLog.h"
 
 namespace my_memorypool
 {
 
-class MemoryPool
+// 以策略为模板参数的内存池门面，使用该策略的进程默认堆
+template<typename Policy>
+class BasicMemoryPool
 {
 public:
     static void* allocate(size_t size)
     {
-        return ThreadCache::getInstance()->allocate(size);
+        void* ptr = BasicThreadCache<Policy>::getInstance()->allocate(size);
+#if ENABLE_SIZE_PROFILE
+        if(MEMPOOL_UNLIKELY(SizeProfile::enabled())) SizeProfile::record(size);
+#endif
+#if ENABLE_ALLOC_TRACE
+        if(MEMPOOL_UNLIKELY(AllocTrace::enabled())) AllocTrace::record(AllocTrace::Allocate, ptr, size);
+#endif
+        return ptr;
+    }
+
+    // 相当于 allocate + memset 0，但新映射或已归还系统的页不再重复清零，大块清零使用非临时存储
+    static void* allocateZeroed(size_t size)
+    {
+        void* ptr = BasicThreadCache<Policy>::getInstance()->allocateZeroed(size);
+#if ENABLE_SIZE_PROFILE
+        if(MEMPOOL_UNLIKELY(SizeProfile::enabled())) SizeProfile::record(size);
+#endif
+#if ENABLE_ALLOC_TRACE
+        if(MEMPOOL_UNLIKELY(AllocTrace::enabled())) AllocTrace::record(AllocTrace::Allocate, ptr, size);
+#endif
+        return ptr;
     }
 
     static void deallocate(void* ptr, size_t size)
     {
-        ThreadCache::getInstance()->deallocate(ptr,size);
+#if ENABLE_ALLOC_TRACE
+        // 先记录再释放：地址被其他线程复用时，释放记录的时间戳一定早于新的分配记录
+        if(MEMPOOL_UNLIKELY(AllocTrace::enabled())) AllocTrace::record(AllocTrace::Deallocate, ptr, size);
+#endif
+        BasicThreadCache<Policy>::getInstance()->deallocate(ptr,size);
+    }
+
+    // 实时模式：为默认堆预留并锁定 budgetBytes，之后分配不再进入内核，预算耗尽时返回 nullptr
+    // 通常在启动阶段调用，随后在各延迟敏感线程上用 reserve 预取所需的 size-class
+    static bool enableRealtime(size_t budgetBytes)
+    {
+        return BasicHeap<Policy>::getDefault().enableRealtime(budgetBytes);
+    }
+
+    static bool reserve(size_t size, size_t count)
+    {
+        return BasicThreadCache<Policy>::getInstance()->reserve(size, count);
+    }
+
+    // 默认堆的内存上限与压力回调（见 BasicHeap::setMemoryLimit）
+    static void setMemoryLimit(size_t softLimit, size_t hardLimit)
+    {
+        BasicHeap<Policy>::getDefault().setMemoryLimit(softLimit, hardLimit);
+    }
+
+    static uint64_t addPressureCallback(PressureCallback callback)
+    {
+        return BasicHeap<Policy>::getDefault().addPressureCallback(std::move(callback));
+    }
+
+    static void removePressureCallback(uint64_t id)
+    {
+        BasicHeap<Policy>::getDefault().removePressureCallback(id);
+    }
+
+    // 调用线程的缓存全部归还；trimAll 同时通知其他线程在下次慢路径上归还（见 BasicHeap::trimAll）
+    static void trimThreadCache()
+    {
+        BasicThreadCache<Policy>::getInstance()->trim();
+    }
+
+    static void trimAll()
+    {
+        BasicHeap<Policy>::getDefault().trimAll();
+    }
+
+    // 默认堆上的纪元回收（见 BasicHeap::retire），临界区也可用 EpochGuard 包裹
+    static void enter()
+    {
+        BasicThreadCache<Policy>::getInstance()->enter();
+    }
+
+    static void exit()
+    {
+        BasicThreadCache<Policy>::getInstance()->exit();
+    }
+
+    static bool retire(void* ptr, size_t size)
+    {
+        return BasicThreadCache<Policy>::getInstance()->retire(ptr, size);
+    }
+
+    static size_t reclaim()
+    {
+        return BasicThreadCache<Policy>::getInstance()->reclaim();
+    }
+
+    // 运行期参数（首次使用时读取 MEMPOOL_* 环境变量），设置非法值时返回 false
+    static bool setOption(Option option, size_t value)
+    {
+        return RuntimeOptions<Policy>::instance().set(option, value);
+    }
+
+    static size_t getOption(Option option)
+    {
+        return RuntimeOptions<Policy>::instance().get(option);
+    }
+
+    // 默认堆的各层内存分布
+    static HeapStats stats()
+    {
+        return BasicHeap<Policy>::getDefault().stats();
+    }
+
+    // 默认堆 CentralCache 各 size-class 的加锁 / 自旋 / CAS 争用（需 ENABLE_CENTRAL_STATS）
+    static std::vector<CentralClassStats> contentionStats()
+    {
+        return BasicHeap<Policy>::getDefault().contentionStats();
+    }
+
+    static void resetContentionStats()
+    {
+        BasicHeap<Policy>::getDefault().resetContentionStats();
+    }
+
+    // 分配轨迹记录（需 ENABLE_ALLOC_TRACE），文件格式见 AllocTrace.h，用 trace_replay 回放
+    static bool startTrace(const char* path, size_t maxRecords = AllocTrace::DEFAULT_CAPACITY)
+    {
+        return AllocTrace::start(path, maxRecords);
+    }
+
+    static void stopTrace()
+    {
+        AllocTrace::stop();
+    }
+
+    // 分配大小直方图（需 ENABLE_SIZE_PROFILE），dumpSizeProfile 的输出交给 size_class_gen 生成 size-class 表
+    static bool startSizeProfile()
+    {
+        return SizeProfile::start();
+    }
+
+    static void stopSizeProfile()
+    {
+        SizeProfile::stop();
+    }
+
+    static bool dumpSizeProfile(const char* path)
+    {
+        return SizeProfile::dump(path);
+    }
+
+    // 慢路径事件日志（需 ENABLE_SLOW_PATH_LOG），各进程内所有堆共用，格式见 SlowPathLog.h
+    static void startSlowPathLog()
+    {
+        SlowPathLog::start();
+    }
+
+    static void stopSlowPathLog()
+    {
+        SlowPathLog::stop();
+    }
+
+    // 单次慢路径耗时不小于 thresholdNs 时把该线程最近的事件写到 fd（0 或 fd < 0 关闭）
+    static void setSlowPathTrigger(uint64_t thresholdNs, int fd)
+    {
+        SlowPathLog::setTrigger(thresholdNs, fd);
+    }
+
+    static std::vector<SlowPathEvent> slowPathEvents()
+    {
+        return SlowPathLog::snapshot();
+    }
+
+    static bool dumpSlowPathLog(const char* path)
+    {
+        return SlowPathLog::dump(path);
     }
 };
 
-}
\ No newline at end of file
+using MemoryPool = BasicMemoryPool<DefaultPolicy>;
+using TinyMemoryPool = BasicMemoryPool<TinyObjectPolicy>;
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "Common.h"
+#include <atomic>
+#include <array>
+
+namespace my_memorypool
+{
+
+// 运行期可调参数，首次使用时从 MEMPOOL_* 环境变量读取，之后可通过 setOption 在线修改
+enum class Option
+{
+    ReturnThreshold,    // MEMPOOL_RETURN_THRESHOLD：ThreadCache 自由链表归还阈值
+    SmallBatch,         // MEMPOOL_SMALL_BATCH：小对象一次从 CentralCache 获取的块数
+    MediumBatch,        // MEMPOOL_MEDIUM_BATCH
+    LargeBatch,         // MEMPOOL_LARGE_BATCH
+    HugeBatch,          // MEMPOOL_HUGE_BATCH
+    MaxDelayCount,      // MEMPOOL_MAX_DELAY_COUNT：CentralCache 延迟归还的计数阈值
+    DelayIntervalMs,    // MEMPOOL_DELAY_INTERVAL_MS：CentralCache 延迟归还的时间间隔
+    ScavengeRate,       // MEMPOOL_SCAVENGE_RATE：PageCache 归还系统的速率（字节/秒，0 关闭）
+    LargeObjectCutoff,  // MEMPOOL_LARGE_CUTOFF：超过该大小直接按页分配（不超过 MAX_BYTES）
+    IdleDecayMs,        // MEMPOOL_IDLE_DECAY_MS：ThreadCache 空闲衰减周期（0 关闭）
+    Count
+};
+
+// 环境变量名，如 "MEMPOOL_RETURN_THRESHOLD"
+const char* optionEnvName(Option option);
+
+// 每个策略一份运行期参数，默认值来自策略常量
+// 值以 relaxed 原子保存，快路径读取即普通整数读取
+template<typename Policy>
+class RuntimeOptions
+{
+public:
+    static RuntimeOptions& instance()
+    {
+        static RuntimeOptions options;
+        return options;
+    }
+
+    size_t get(Option option) const
+    {
+        return values_[static_cast<size_t>(option)].load(std::memory_order_relaxed);
+    }
+
+    // 参数非法时返回 false 且不修改
+    bool set(Option option, size_t value);
+
+    // 恢复策略默认值（不重新读取环境变量）
+    void reset();
+
+    size_t returnThreshold() const { return get(Option::ReturnThreshold); }
+    size_t largeObjectCutoff() const { return get(Option::LargeObjectCutoff); }
+
+    // 历史上设置过的最小 cutoff：大于它的对象释放时需确认是否按页分配
+    size_t largeLookupFloor() const { return largeLookupFloor_.load(std::memory_order_relaxed); }
+
+private:
+    RuntimeOptions();
+
+    std::array<std::atomic<size_t>, static_cast<size_t>(Option::Count)> values_;
+    std::atomic<size_t> largeLookupFloor_{0};
+};
+
+}
@@ -1,34 +1,169 @@
 #pragma once
 #include "Common.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace my_memorypool
 {
 
+// PageCache 元数据（Span 与两张 std::map 的节点）共用的定长槽。平时直接向系统堆申请、释放；
+// 实时模式下从 enableRealtime 预先映射并锁定的区域中取，释放的槽留在池中，分配与释放都不再进入 malloc
+struct SpanMetaPool
+{
+    static constexpr size_t SLOT_BYTES = 64;
+
+    SpanMetaPool() = default;
+    ~SpanMetaPool() { release(); }
+
+    SpanMetaPool(const SpanMetaPool&) = delete;
+    SpanMetaPool& operator=(const SpanMetaPool&) = delete;
+
+    void* allocate();
+    void deallocate(void* slot);
+
+    // 把 [memory, memory + bytes) 切成槽加入池中；之后释放的槽一律留在池中
+    void addRegion(void* memory, size_t bytes);
+    // 归还池中取自系统堆的槽并清空池，返回各预留区域交由调用方解除映射（需先释放全部槽）
+    std::vector<std::pair<void*, size_t>> release();
+
+    size_t freeSlots() const { return freeSlots_; }
+    size_t usedSlots() const { return usedSlots_; }
+
+private:
+    bool inRegion(void* slot) const;
+
+    void* freeList_ = nullptr;
+    size_t freeSlots_ = 0;
+    size_t usedSlots_ = 0;
+    std::vector<std::pair<void*, size_t>> regions_;
+};
 
-class PageCache
+// std::map 的节点分配器，节点逐个取自 SpanMetaPool
+template<typename T>
+struct SpanMetaAllocator
 {
-public:
-    static const size_t PAGE_SIZE = 4096; // 4K页大小
+    using value_type = T;
+
+    explicit SpanMetaAllocator(SpanMetaPool* pool) : pool(pool) {}
+    template<typename U>
+    SpanMetaAllocator(const SpanMetaAllocator<U>& other) : pool(other.pool) {}
 
-    static PageCache& getInstance()
-    {  
-        static PageCache instance;
-        return instance;
+    T* allocate(size_t n)
+    {
+        static_assert(sizeof(T) <= SpanMetaPool::SLOT_BYTES && alignof(T) <= alignof(std::max_align_t),
+                      "map nodes must fit in a metadata slot");
+        // std::map 只按单个节点申请
+        if(n != 1) return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(pool->allocate());
     }
+    void deallocate(T* ptr, size_t n)
+    {
+        if(n != 1) ::operator delete(ptr);
+        else pool->deallocate(ptr);
+    }
+
+    template<typename U>
+    bool operator==(const SpanMetaAllocator<U>& other) const { return pool == other.pool; }
+    template<typename U>
+    bool operator!=(const SpanMetaAllocator<U>& other) const { return pool != other.pool; }
+
+    SpanMetaPool* pool;
+};
+
+template<typename Policy>
+class BasicPageCache
+{
+public:
+    static constexpr size_t PAGE_SIZE = Policy::PAGE_SIZE; // 逻辑页大小（默认4K）
+
+    // 每个 Heap 持有独立的 PageCache，析构时归还全部系统内存
+    BasicPageCache() = default;
+    ~BasicPageCache();
+
+    BasicPageCache(const BasicPageCache&) = delete;
+    BasicPageCache& operator=(const BasicPageCache&) = delete;
 
     // 分配指定页数的span
-    void* allocateSpan(size_t numPages);
+    // zeroed 含义同 allocateLargeSpan
+    void* allocateSpan(size_t numPages, bool* zeroed = nullptr);
+    // 为大对象分配span（带标记，释放时可据此识别）
+    // zeroed 非空时写入该 span 的内容是否已知全为 0（新映射或归还系统后未再使用），调用方据此跳过清零
+    void* allocateLargeSpan(size_t numPages, bool* zeroed = nullptr);
 
-    // 释放指定页数的span
+    // 释放指定页数的span，numPages 须与申请时一致（Debug 构建下断言）
     void deallocateSpan(void* ptr, size_t numPages);
+    // ptr 是 allocateLargeSpan 分配的 span 时释放并返回 true，否则不做任何事
+    bool deallocateLargeSpan(void* ptr);
+
+    // 立即将空闲 span 以 MADV_DONTNEED 归还系统（保留地址空间），最多 maxBytes，返回实际归还字节数
+    size_t scavenge(size_t maxBytes);
+
+    // 一次性归还所有向系统申请的内存（不遍历对象），之后可继续使用
+    void releaseAll();
+
+    // 当前向系统申请的总字节数
+    size_t systemBytes();
+
+    // 实时模式：额外申请 budgetBytes（按页取整）并预先缺页，连同已申请的区域一起 mlock；
+    // 之后不再向系统申请内存、也不再 madvise 归还，预算耗尽时分配直接返回 nullptr 并计入 budgetFailures。
+    // span 元数据按最坏情况（每页一个 span）预先备足并锁定，每页约 3 个 64 字节的槽，之后也不再进入 malloc
+    // 映射或锁定失败（如超出 RLIMIT_MEMLOCK）时返回 false，errno 保留，不进入实时模式
+    // 可多次调用追加预算；releaseAll 后退出实时模式
+    bool enableRealtime(size_t budgetBytes);
+
+    // 内存上限，按驻留字节数（向系统申请的字节 - 已 madvise 归还的空闲 span）计算，0 表示不限制
+    // 只在需要向系统申请新内存时检查：超过软上限时先归还全部空闲 span，仍超出则置位压力标志；
+    // 超过硬上限时申请失败。压力由上层在不持有任何锁时处理（见 BasicHeap::relievePressure）
+    void setMemoryLimit(size_t softLimit, size_t hardLimit);
+    // 取走压力标志（只有一个调用方会得到 true）；慢路径上先做一次 relaxed 读取，无压力时不写缓存行
+    bool takePressure()
+    {
+        return pressure_.load(std::memory_order_relaxed) && pressure_.exchange(false, std::memory_order_acquire);
+    }
+
+    struct Stats
+    {
+        size_t systemBytes = 0;   // 向系统申请的总字节数（地址空间）
+        size_t freeBytes = 0;     // 空闲且驻留的 span
+        size_t releasedBytes = 0; // 空闲且已归还系统物理页的 span
+        size_t largeBytes = 0;    // 大对象 span
+        size_t lockedBytes = 0;   // 实时模式下已锁定的字节数
+        uint64_t budgetFailures = 0; // 实时模式下因预算耗尽而失败的 span 申请次数
+        size_t committedBytes = 0;   // 驻留字节数（内存上限据此计算）
+        uint64_t limitFailures = 0;  // 超过硬上限而失败的 span 申请次数
+    };
+    // 遍历 span 统计，仅用于观测
+    Stats stats();
 
 private:
-    PageCache() = default;
+    struct Span;
 
-    //向系统申请内存
-    void* systemAlloc(size_t numPages);
+    Span* allocateSpanLocked(size_t numPages);
+    // Span 对象取自 metaPool_
+    Span* newSpan();
+    void deleteSpan(Span* span);
+    // 实时模式：保证元数据槽足够 totalPages 页各成一个 span，失败返回 false
+    bool reserveMetaLocked(size_t totalPages);
+    // 保留 span->zeroed：归还用过的 span 时由调用方先清除
+    void deallocateSpanLocked(Span* span);
+    // 按速率周期性归还空闲超过一个周期的 span（在 deallocateSpan 慢路径中调用）
+    void maybeScavengeLocked();
+    size_t scavengeLocked(size_t maxBytes, bool idleOnly);
+    // 向系统申请 numPages 前检查内存上限
+    bool admitLocked(size_t numPages);
+    size_t committedBytesLocked() const { return (systemPages_ - releasedPages_) * PAGE_SIZE; }
+
+    //向系统申请内存，populate 时预先建立全部页表项
+    void* systemAlloc(size_t numPages, bool populate = false);
+    // 锁定物理页（同时完成缺页），失败返回 false
+    static bool lockRegion(void* ptr, size_t numPages);
+    //归还内存给系统
+    void systemFree(void* ptr, size_t numPages);
 
 private:
     struct Span
@@ -36,13 +171,40 @@ private:
         void*pageAddr; // 页起始地址
         size_t numPages; // 页数
         Span* next; // 链表指针
+        bool large = false; // 是否为大对象 span
+        bool released = false; // 空闲且物理页已归还系统
+        bool zeroed = false; // 内容已知全为 0：新映射的页，或以 MADV_DONTNEED 归还后未再使用；合并时取与
+        uint64_t freeEpoch = 0; // 进入空闲链表时的回收周期
     };
 
+    // 元数据槽，须先于两张表构造、后于它们析构
+    SpanMetaPool metaPool_;
     // 按页数管理空闲span，不同页数对应不同Span链表
-    std::map<size_t,Span*> freeSpans_;
+    std::map<size_t, Span*, std::less<size_t>, SpanMetaAllocator<std::pair<const size_t, Span*>>> freeSpans_{
+        SpanMetaAllocator<std::pair<const size_t, Span*>>(&metaPool_)};
     // 页号到Span的映射，用于回收
-    std::map<void*,Span*> spanMap_;
+    std::map<void*, Span*, std::less<void*>, SpanMetaAllocator<std::pair<void* const, Span*>>> spanMap_{
+        SpanMetaAllocator<std::pair<void* const, Span*>>(&metaPool_)};
+    // 向系统申请的原始区域（起始地址，页数），用于 releaseAll
+    std::vector<std::pair<void*, size_t>> systemRegions_;
+    size_t systemPages_ = 0;
+    // 实时模式状态：systemRegions_ 的前 lockedRegions_ 个区域已锁定
+    bool realtime_ = false;
+    size_t lockedRegions_ = 0;
+    size_t lockedPages_ = 0;
+    uint64_t budgetFailures_ = 0;
+    // 内存上限
+    size_t releasedPages_ = 0; // 空闲且已归还物理页的页数
+    size_t softLimit_ = 0;
+    size_t hardLimit_ = 0;
+    uint64_t limitFailures_ = 0;
+    std::atomic<bool> pressure_{false};
+    // 后台归还状态
+    uint64_t scavengeEpoch_ = 0;
+    std::chrono::steady_clock::time_point lastScavenge_ = std::chrono::steady_clock::now();
     std::mutex mutex_;
 };
 
-}
\ No newline at end of file
+using PageCache = BasicPageCache<DefaultPolicy>;
+
+}
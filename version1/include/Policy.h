@@ -0,0 +1,137 @@
+#pragma once
+#include <cstddef>
+
+namespace my_memorypool
+{
+
+// size-class 表：SIZES 升序且均为 ALIGNMENT 的倍数，请求大小向上取整到表中第一个不小于它的值；
+// 大于表中最大值的请求仍按 ALIGNMENT 步长分级。COUNT == 0 表示不使用表（全部按 ALIGNMENT 步长）
+struct UniformSizeClasses
+{
+    static constexpr std::size_t COUNT = 0;
+    static constexpr std::size_t SIZES[1] = {0};
+};
+
+}
+
+// 构建时可用 -DSIZE_CLASS_HEADER=<size_class_gen 生成的头文件> 让默认策略改用按实际分布生成的表
+#ifdef MEMPOOL_SIZE_CLASS_HEADER
+#include MEMPOOL_SIZE_CLASS_HEADER
+#endif
+
+namespace my_memorypool
+{
+
+// 内存池的编译期配置策略
+// 各层（ThreadCache / CentralCache / PageCache / Heap / MemoryPool）均以策略为模板参数，
+// 所有常量在编译期折叠；定制时继承 DefaultPolicy 并覆盖需要修改的常量即可
+struct DefaultPolicy
+{
+    static constexpr std::size_t ALIGNMENT = 8;            // 对齐数，也是 size-class 的步长
+    static constexpr std::size_t MAX_BYTES = 256 * 1024;   // 走缓存的最大对象（256KB），更大的直接按页分配
+    static constexpr std::size_t PAGE_SIZE = 4096;         // PageCache 的逻辑页大小
+#ifdef MEMPOOL_SIZE_CLASS_HEADER
+    using SizeClasses = ProfiledSizeClasses;               // 由 size_class_gen 根据大小分布生成
+#else
+    using SizeClasses = UniformSizeClasses;
+#endif
+
+    // CentralCache 向 PageCache 申请 span 的页数范围，以及一个 span 至少切出的对象数
+    static constexpr std::size_t SPAN_PAGES = 8;
+    static constexpr std::size_t MAX_SPAN_PAGES = 128;
+    static constexpr std::size_t MIN_SPAN_OBJECTS = 64;
+
+    // 缓存着色：同一 size-class 先后切分的 span 起始偏移依次错开 CACHE_LINE，共 CACHE_COLOURS 种，
+    // 避免按页对齐的 2 的幂大小对象总落在相同的 L1/L2 组上；偏移损失的块超过 span 的 1/32 时不着色
+    static constexpr std::size_t CACHE_LINE = 64;
+    static constexpr std::size_t CACHE_COLOURS = 8;
+
+    // ThreadCache 慢启动批量：size <= *_BATCH_BYTES 时一次取 *_BATCH 个
+    static constexpr std::size_t SMALL_BATCH_BYTES = 64;
+    static constexpr std::size_t SMALL_BATCH = 512;
+    static constexpr std::size_t MEDIUM_BATCH_BYTES = 512;
+    static constexpr std::size_t MEDIUM_BATCH = 128;
+    static constexpr std::size_t LARGE_BATCH_BYTES = 4096;
+    static constexpr std::size_t LARGE_BATCH = 32;
+    static constexpr std::size_t HUGE_BATCH = 4;
+
+    // ThreadCache 自由链表超过该长度时归还一部分给 CentralCache
+    static constexpr std::size_t RETURN_THRESHOLD = 256;
+    // ThreadCache 空闲衰减周期（0 表示关闭）：每个周期内从未被取用的块（自由链表长度的低水位）归还 CentralCache
+    static constexpr std::size_t IDLE_DECAY_MS = 1000;
+    // 纪元回收：线程累计 retire 该数量的块后尝试推进纪元，并释放已确认没有读者的块
+    static constexpr std::size_t RECLAIM_BATCH = 128;
+
+    // CentralCache 延迟归还：累计归还块数与时间间隔
+    static constexpr std::size_t MAX_DELAY_COUNT = 48;
+    static constexpr std::size_t DELAY_INTERVAL_MS = 1000;
+    static constexpr std::size_t SPAN_TRACKER_CAPACITY = 1024;
+
+    // allocateZeroed 需要清零的块不小于该值时改用非临时存储（绕过缓存），避免清零冲掉整个缓存
+    static constexpr std::size_t NONTEMPORAL_ZERO_BYTES = 1024 * 1024;
+
+    // PageCache 后台归还速率（字节/秒，0 表示关闭），空闲超过一个周期的 span 以 MADV_DONTNEED 还给系统
+    static constexpr std::size_t SCAVENGE_RATE = 16 * 1024 * 1024;
+
+    // 开启 ENABLE_TINY_SLABS 时，size <= 该值的 size-class 改用带占用位图的 slab（0 表示不使用）
+    // 每个 slab 占一个逻辑页，释放时按页对齐找到 slab 头，因此要求 PAGE_SIZE 等于系统页
+    static constexpr std::size_t TINY_SLAB_MAX_BYTES = 32;
+};
+
+// 小对象专用池：最大 16KB，64KB 逻辑页
+struct TinyObjectPolicy : DefaultPolicy
+{
+    static constexpr std::size_t MAX_BYTES = 16 * 1024;
+    static constexpr std::size_t PAGE_SIZE = 64 * 1024;
+    static constexpr std::size_t SPAN_PAGES = 1;
+    static constexpr std::size_t MAX_SPAN_PAGES = 8;
+    static constexpr std::size_t TINY_SLAB_MAX_BYTES = 0; // 64KB 逻辑页不保证 64KB 对齐
+};
+
+// size-class 表须升序且为 ALIGNMENT 的倍数
+template<typename Table>
+constexpr bool validSizeClassTable(std::size_t alignment)
+{
+    for(std::size_t i = 0; i < Table::COUNT; ++i)
+    {
+        if(Table::SIZES[i] == 0 || Table::SIZES[i] % alignment != 0) return false;
+        if(i > 0 && Table::SIZES[i] <= Table::SIZES[i - 1]) return false;
+    }
+    return true;
+}
+
+// 策略萃取：派生常量与合法性检查
+template<typename Policy>
+struct PolicyTraits : Policy
+{
+    static constexpr std::size_t FREE_LIST_SIZE = Policy::MAX_BYTES / Policy::ALIGNMENT; // 支持的 size-class 数
+
+    static_assert(Policy::ALIGNMENT >= sizeof(void*), "ALIGNMENT must hold an intrusive next pointer");
+    static_assert((Policy::ALIGNMENT & (Policy::ALIGNMENT - 1)) == 0, "ALIGNMENT must be a power of two");
+    static_assert(Policy::MAX_BYTES % Policy::ALIGNMENT == 0, "MAX_BYTES must be a multiple of ALIGNMENT");
+    static_assert((Policy::PAGE_SIZE & (Policy::PAGE_SIZE - 1)) == 0, "PAGE_SIZE must be a power of two");
+    static_assert(Policy::PAGE_SIZE % 4096 == 0, "PAGE_SIZE must be a multiple of the system page");
+    static_assert(Policy::SPAN_PAGES >= 1 && Policy::SPAN_PAGES <= Policy::MAX_SPAN_PAGES,
+                  "SPAN_PAGES must be in [1, MAX_SPAN_PAGES]");
+    static_assert(Policy::MAX_SPAN_PAGES * Policy::PAGE_SIZE >= Policy::MAX_BYTES,
+                  "the largest size class must fit in a single span");
+    static_assert(Policy::SMALL_BATCH_BYTES <= Policy::MEDIUM_BATCH_BYTES &&
+                  Policy::MEDIUM_BATCH_BYTES <= Policy::LARGE_BATCH_BYTES, "batch tiers must be ordered");
+    static_assert(Policy::SMALL_BATCH >= 1 && Policy::MEDIUM_BATCH >= 1 &&
+                  Policy::LARGE_BATCH >= 1 && Policy::HUGE_BATCH >= 1, "batch sizes must be positive");
+    static_assert(Policy::RETURN_THRESHOLD >= 1, "RETURN_THRESHOLD must be positive");
+    static_assert(Policy::RECLAIM_BATCH >= 1, "RECLAIM_BATCH must be positive");
+    static_assert((Policy::CACHE_LINE & (Policy::CACHE_LINE - 1)) == 0 && Policy::CACHE_LINE % Policy::ALIGNMENT == 0,
+                  "CACHE_LINE must be a power of two and a multiple of ALIGNMENT");
+    static_assert(Policy::CACHE_COLOURS >= 1 && (Policy::CACHE_COLOURS - 1) * Policy::CACHE_LINE < Policy::PAGE_SIZE,
+                  "colour offsets must stay within the first page of a span");
+    static_assert(Policy::SPAN_TRACKER_CAPACITY >= 1, "SPAN_TRACKER_CAPACITY must be positive");
+    static_assert(Policy::TINY_SLAB_MAX_BYTES == 0 || Policy::PAGE_SIZE == 4096,
+                  "tiny slabs are located by page alignment and need PAGE_SIZE == 4096");
+    static_assert(Policy::TINY_SLAB_MAX_BYTES % Policy::ALIGNMENT == 0 && Policy::TINY_SLAB_MAX_BYTES <= 64,
+                  "TINY_SLAB_MAX_BYTES must be a multiple of ALIGNMENT and at most 64");
+    static_assert(validSizeClassTable<typename Policy::SizeClasses>(Policy::ALIGNMENT),
+                  "SizeClasses::SIZES must be ascending multiples of ALIGNMENT");
+};
+
+}
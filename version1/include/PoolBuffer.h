@@ -0,0 +1,160 @@
+#pragma once
+#include "Common.h"
+#include "Heap.h"
+#include <atomic>
+#include <cstdint>
+#ifdef _WIN32
+struct iovec
+{
+    void* iov_base;
+    size_t iov_len;
+};
+#else
+#include <sys/uio.h>
+#endif
+
+namespace my_memorypool
+{
+
+// 引用计数的缓冲链：由若干段组成，每段引用一块共享存储中的一段连续字节
+// 存储（头部 + 负载）、段节点与链本身都从所属堆的 size-class 分配，最后一个引用释放时回到原 size-class（可在任意线程）
+// 链带引用计数：share/slice 只增加链的引用并记录视图范围（O(1)，不分配）；被共享的链只读，
+// 修改前先复制视图覆盖的段节点（O(段数)，不复制负载）；只有引用计数为 1 的存储才会被原地写入
+// 单个 BasicPoolBuffer 不是线程安全的，共享出去的副本可以交给其他线程
+// 需要分配的操作在分配失败时返回 false（或空缓冲），缓冲保持原状
+template<typename Policy>
+class BasicPoolBuffer
+{
+    // 存储头，负载紧随其后（与块本身同为 ALIGNMENT 对齐）
+    struct Storage
+    {
+        std::atomic<uint32_t> refs;
+        BasicHeap<Policy>* heap;
+        size_t capacity;
+
+        char* payload() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+public:
+    using Heap = BasicHeap<Policy>;
+
+    // 新建段的默认容量：存储头 + 负载恰好占一页（页大于最大 size-class 时取最大一档）
+    static constexpr size_t DEFAULT_SEGMENT_BYTES = std::min(Policy::PAGE_SIZE, Policy::MAX_BYTES) - sizeof(Storage);
+
+    explicit BasicPoolBuffer(Heap& heap = Heap::getDefault())
+        : heap_(&heap)
+    {}
+    ~BasicPoolBuffer() { clear(); }
+
+    BasicPoolBuffer(BasicPoolBuffer&& other) noexcept;
+    BasicPoolBuffer& operator=(BasicPoolBuffer&& other) noexcept;
+    // 复制请用 share()，显式表明共享存储
+    BasicPoolBuffer(const BasicPoolBuffer&) = delete;
+    BasicPoolBuffer& operator=(const BasicPoolBuffer&) = delete;
+
+    // 一个容量为 capacity 的空段，前部预留 headroom 字节供 prepend 原地写入
+    static BasicPoolBuffer create(size_t capacity, size_t headroom = 0, Heap& heap = Heap::getDefault());
+    static BasicPoolBuffer copyOf(const void* data, size_t len, Heap& heap = Heap::getDefault());
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // 视图覆盖的段数（视图覆盖整条链时 O(1)）
+    size_t segmentCount() const;
+
+    // 复制写入：优先使用尾段剩余空间 / 首段预留空间（仅当存储未被共享），不足时新建段
+    bool append(const void* data, size_t len);
+    bool prepend(const void* data, size_t len);
+    // 拼接另一条链，成功后 other 变为空；双方的链都未被共享时 O(1)，否则先复制被共享一方的段节点
+    bool append(BasicPoolBuffer&& other);
+    bool prepend(BasicPoolBuffer&& other);
+
+    // 共享全部数据：链引用计数 +1（O(1)），不复制段节点和负载
+    BasicPoolBuffer share() const;
+    // [offset, offset + len) 的共享视图（超出部分截断），同样 O(1)
+    BasicPoolBuffer slice(size_t offset, size_t len) const;
+
+    // 丢弃头部 / 尾部 n 个字节：独占的链整段丢弃时释放对存储的引用，被共享的链只收缩视图
+    void trimFront(size_t n);
+    void trimBack(size_t n);
+    void clear();
+
+    // 从 offset 起复制至多 len 个字节到 dst，返回实际复制的字节数
+    size_t copyTo(void* dst, size_t offset, size_t len) const;
+
+    // writev：依次填入各段的数据，返回填入的条数（至多 maxIov）
+    size_t fillIovec(iovec* iov, size_t maxIov) const;
+    // readv：在尾部准备至少 bytes 字节的可写空间（新段为默认容量），返回可写区域的 iovec 条数；
+    // 读完后用 commitRead 提交实际读到的字节数，未用到的新段随之释放；两者之间不要修改或共享缓冲
+    size_t prepareRead(size_t bytes, iovec* iov, size_t maxIov);
+    void commitRead(size_t bytes);
+
+private:
+    struct Segment
+    {
+        Storage* storage;
+        char* data;
+        size_t length;
+        Segment* next;
+    };
+
+    // 段链：被多个缓冲共享时只读，各缓冲用 [offset_, offset_ + size_) 描述自己的视图
+    struct Chain
+    {
+        std::atomic<uint32_t> refs;
+        Heap* heap;
+        Segment* head;
+        Segment* tail;
+        size_t bytes; // 各段长度之和
+        size_t count;
+    };
+
+    static Storage* newStorage(Heap& heap, size_t capacity);
+    static void releaseStorage(Storage* storage);
+    // 段节点从存储所属的堆分配，释放时不依赖缓冲本身的堆；freeSegment 同时释放对存储的引用
+    static Segment* newSegment(Storage* storage, char* data, size_t length);
+    static void freeSegment(Segment* segment);
+    static Chain* newChain(Heap& heap);
+    static void releaseChain(Chain* chain);
+    static void linkBack(Chain& chain, Segment* segment);
+    static void linkFront(Chain& chain, Segment* segment);
+    // 在独占的链上真正丢弃头部 / 尾部 n 个字节
+    static void dropFront(Chain& chain, size_t n);
+    static void dropBack(Chain& chain, size_t n);
+
+    static bool writable(const Segment* segment)
+    {
+        return segment->storage->refs.load(std::memory_order_acquire) == 1;
+    }
+    static size_t headroom(const Segment* segment)
+    {
+        return static_cast<size_t>(segment->data - segment->storage->payload());
+    }
+    static size_t tailroom(const Segment* segment)
+    {
+        return segment->storage->capacity - headroom(segment) - segment->length;
+    }
+
+    // 其他缓冲释放引用时 acq_rel，这里 acquire 之后它们对链的读取都已结束
+    bool exclusive() const
+    {
+        return chain_ && chain_->refs.load(std::memory_order_acquire) == 1;
+    }
+    // 修改前调用：保证链由本缓冲独占且视图覆盖整条链；失败时缓冲保持原状
+    bool own();
+
+    void pushBack(Segment* segment);
+    void pushFront(Segment* segment);
+
+    Heap* heap_;
+    Chain* chain_ = nullptr;
+    size_t offset_ = 0; // 视图在链中的起点
+    size_t size_ = 0;
+
+    // prepareRead 之前的尾段，以及它是否出现在返回的 iovec 中
+    Segment* readTail_ = nullptr;
+    bool readIntoTail_ = false;
+};
+
+using PoolBuffer = BasicPoolBuffer<DefaultPolicy>;
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "Common.h"
+#if defined(__linux__)
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+
+namespace my_memorypool
+{
+
+// 共享池中的块句柄：相对区域起点的字节偏移。各进程的映射地址不同，进程间只能传句柄；offset == 0 表示空
+struct SharedHandle
+{
+    uint64_t offset = 0;
+
+    explicit operator bool() const { return offset != 0; }
+};
+
+struct SharedPoolStats
+{
+    size_t regionBytes = 0;       // memfd 区域大小
+    size_t carvedBytes = 0;       // 已切分为 span 的字节数
+    size_t processes = 0;         // 当前登记的进程数
+    uint64_t recoveredBlocks = 0; // 从已退出进程回收的块数（累计）
+};
+
+// 跨进程共享池：所有元数据（区域头、各 size-class 的空闲栈与切分游标、进程表）都在 memfd 区域内，
+// 协作进程映射同一个 memfd 后即可用句柄交接块，不复制负载
+//   - 块大小按 2 的幂分级（MIN_BLOCK ~ MAX_BLOCK，含 8 字节块头），区域头大小固定，不随 size-class 数增长
+//   - 分配 / 释放走区域内的无锁栈（带标签的 64 位头，防 ABA），只有切分新 span 时持有进程间 robust 锁
+//   - 块头记录所有者进程槽：进程崩溃后 recover() 把它仍持有的块放回空闲栈；
+//     交接中的块（release 之后、adopt 之前）不属于任何进程，不会被回收
+// 区域大小在创建时固定，span 只切分不归还；超过 MAX_BLOCK - 8 字节的请求返回空句柄
+template<typename Policy>
+class BasicSharedPool
+{
+public:
+    static constexpr size_t MIN_BLOCK = 64;
+    static constexpr size_t MAX_BLOCK = Policy::MAX_BYTES;
+    static constexpr size_t BLOCK_HEADER = 8;
+    static constexpr size_t SPAN_BYTES = 4 * MAX_BLOCK;
+    static constexpr size_t MAX_PROCESSES = 64;
+
+    static constexpr size_t classCount()
+    {
+        size_t count = 1;
+        for(size_t block = MIN_BLOCK; block < MAX_BLOCK; block <<= 1) ++count;
+        return count;
+    }
+    static constexpr size_t CLASS_COUNT = classCount();
+
+    static_assert((MAX_BLOCK & (MAX_BLOCK - 1)) == 0 && MAX_BLOCK >= MIN_BLOCK,
+                  "shared pool classes need a power-of-two MAX_BYTES");
+
+    // 新建 regionBytes 大小的 memfd 区域并映射，失败返回 nullptr
+    static std::unique_ptr<BasicSharedPool> create(size_t regionBytes, const char* name = "my_memorypool");
+    // 映射其他进程创建的区域（fd 经继承或 SCM_RIGHTS 传入，所有权归返回的对象），失败返回 nullptr
+    static std::unique_ptr<BasicSharedPool> attach(int fd);
+
+    // 进程正常退出：仍归本进程所有的块与崩溃时一样被回收
+    ~BasicSharedPool();
+
+    BasicSharedPool(const BasicSharedPool&) = delete;
+    BasicSharedPool& operator=(const BasicSharedPool&) = delete;
+
+    int fd() const { return fd_; }
+
+    // fork 出的子进程继承映射与对象，需先调用一次以占用自己的进程槽；进程表已满时返回 false
+    bool afterFork();
+
+    SharedHandle allocate(size_t size);
+    // 任意进程都可释放（包括交接中的块）；与 recover() 回收同一块并发时只有一方把块放回空闲栈
+    void deallocate(SharedHandle handle);
+    size_t usableSize(SharedHandle handle) const;
+
+    // 交接：发送方 release 后把句柄交给对方，接收方 adopt 成为新的所有者（只有一个 adopt 会成功）
+    void release(SharedHandle handle);
+    bool adopt(SharedHandle handle);
+
+    void* pointer(SharedHandle handle) const { return base_ + handle.offset; }
+    SharedHandle handle(const void* ptr) const
+    {
+        return SharedHandle{static_cast<uint64_t>(static_cast<const char*>(ptr) - base_)};
+    }
+
+    // 检查进程表，回收已退出进程仍持有的块，返回回收的块数
+    // 进程以 kill(pid, 0) 判断存活：未被 wait 的僵尸子进程仍视为存活
+    size_t recover();
+
+    SharedPoolStats stats() const;
+
+private:
+    struct Region; // 区域头，布局见 SharedPool.cpp
+
+    BasicSharedPool(int fd, char* base, size_t bytes)
+        : fd_(fd)
+        , base_(base)
+        , bytes_(bytes)
+    {}
+
+    Region* region() const { return reinterpret_cast<Region*>(base_); }
+    bool claimSlot();
+    // 本进程槽位先回收已退出进程，再重试一次
+    bool claimSlotOrRecover();
+
+    uint64_t popFree(size_t index);
+    void pushFree(size_t index, uint64_t block);
+    // 从该 size-class 当前的 span 取下一个未用过的块，用完时持锁切分新 span
+    uint64_t carveBlock(size_t index);
+    // 持有区域锁时调用：把 dead[slot] 为真的进程持有的块放回空闲栈
+    size_t reclaimOwners(const bool* dead);
+
+    void lock();
+    void unlock();
+
+    int fd_;
+    char* base_;
+    size_t bytes_;
+    uint32_t owner_ = 0; // 进程槽下标 + 1
+    pid_t pid_ = 0;      // 占用槽位时的 pid，与 getpid() 不同说明处于 fork 出的子进程中
+};
+
+using SharedPool = BasicSharedPool<DefaultPolicy>;
+
+}
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Common.h"
+
+namespace my_memorypool
+{
+
+// 分配大小直方图（可选）：按 ALIGNMENT 步长统计 allocate 的请求大小，供 size_class_gen 生成 size-class 表。
+// 各线程先把大小写入本地缓冲，攒满 BUFFER_SAMPLES 个再合并到全局计数，热点大小不会在计数上争用缓存行；
+// 关闭时快路径只多一次 relaxed 读。
+// 开启方式：MemoryPool::startSizeProfile() 或设置环境变量 MEMPOOL_SIZE_PROFILE=<输出文件>（进程退出时写出）
+class SizeProfile
+{
+public:
+    static constexpr size_t GRANULE = ALIGNMENT;
+    static constexpr size_t MAX_TRACKED = MAX_BYTES;    // 更大的请求只计入 large
+    static constexpr size_t BUCKETS = MAX_TRACKED / GRANULE;
+    static constexpr size_t BUFFER_SAMPLES = 256;
+
+    struct Bucket
+    {
+        size_t bytes;   // 按 GRANULE 向上取整后的大小
+        uint64_t count;
+    };
+
+    struct Snapshot
+    {
+        std::vector<Bucket> buckets; // 只含非零项，按大小升序
+        uint64_t samples = 0;        // 含 large
+        uint64_t requestedBytes = 0; // 请求的原始字节数之和（不含 large）
+        uint64_t largeCount = 0;
+        uint64_t largeBytes = 0;
+    };
+
+    // 清空计数并开始统计；计数数组在首次 start 时才分配
+    static bool start();
+    static void stop();
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    static void record(size_t size);
+
+    // 合并调用线程缓冲中的样本（线程退出时自动合并；其他存活线程各最多还有 BUFFER_SAMPLES - 1 个未合并）
+    static void flushThread();
+
+    static Snapshot snapshot();
+
+    // 以文本格式写出（每行 "<bytes> <count>"，# 开头的行为元数据），size_class_gen 读取该格式
+    static bool dump(const char* path);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Common.h"
+
+namespace my_memorypool
+{
+
+// 慢路径事件：一次进入 CentralCache / PageCache / 系统调用的分配器工作
+struct SlowPathEvent
+{
+    enum Type : uint8_t
+    {
+        CentralFetch = 1,  // ThreadCache::fetchFromCentralCache，count 为取到的块数
+        CentralReturn = 2, // ThreadCache::returnToCentralCache，count 为归还的块数
+        SpanAlloc = 3,     // PageCache::allocateSpan / allocateLargeSpan / enableRealtime，count 为页数，wait 为等 PageCache 锁的时间
+        SystemAlloc = 4,   // PageCache::systemAlloc（mmap），count 为页数
+        DelayReturn = 5,   // CentralCache::performDelayReturn 扫描，count 为摘下的块数，wait 为等 size-class 锁的时间
+    };
+
+    static constexpr uint32_t NO_CLASS = 0xFFFFFFFF; // 页级事件不属于某个 size-class
+
+    uint64_t timestamp; // 开始时刻，距记录开始的纳秒数
+    uint64_t duration;  // 纳秒，含 wait
+    uint32_t wait;      // 纳秒，超过 4 秒时饱和
+    uint32_t sizeClass;
+    uint32_t count;
+    uint32_t thread;    // 记录线程编号（从 1 开始），线程退出后环形缓冲交给新线程时编号随之改变
+    Type type;
+
+    static const char* typeName(Type type);
+};
+
+// 慢路径事件日志（可选）：每个线程一个定长环形缓冲，只有本线程写入，读取方用逐槽序号校验，不加锁。
+// 线程第一次在记录期间进入慢路径时才分配缓冲，线程退出后缓冲（连同其中的事件）留给之后的新线程复用。
+// 触发器：事件耗时不小于阈值时把本线程缓冲中的事件写到指定 fd（不分配内存），两次触发至少间隔 TRIGGER_COOLDOWN_MS。
+// 慢路径可以嵌套（如持 PageCache 锁时的 mmap），写出推迟到本线程最外层的 SlowPathScope 结束、各层锁都已释放之后。
+// 开启方式：MemoryPool::startSlowPathLog() 或设置环境变量 MEMPOOL_SLOW_PATH_LOG=<输出文件>（进程退出时写出全部事件），
+// MEMPOOL_SLOW_PATH_THRESHOLD_US=<微秒> 同时开启写到 stderr 的触发器。关闭时各慢路径只多一次 relaxed 读
+class SlowPathLog
+{
+public:
+    static constexpr size_t RING_EVENTS = 1024; // 每个线程保留的最近事件数
+    static constexpr uint64_t TRIGGER_COOLDOWN_MS = 100;
+
+    static void start();
+    static void stop();
+
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // thresholdNs == 0 或 fd < 0 时关闭触发器
+    static void setTrigger(uint64_t thresholdNs, int fd);
+    static uint64_t triggerCount();
+
+    static uint64_t now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static void record(SlowPathEvent::Type type, uint32_t sizeClass, uint32_t count,
+                       uint64_t start, uint64_t end, uint64_t wait);
+
+    // SlowPathScope 进入 / 离开时调用，维护本线程的嵌套深度；enter 返回开始时刻，
+    // 最外层 leave 时写出期间推迟的触发
+    static uint64_t enter();
+    static void leave();
+
+    // 所有线程缓冲中的事件，按开始时刻排序
+    static std::vector<SlowPathEvent> snapshot();
+
+    // 以文本格式写出全部事件（每行一个事件，# 开头的行为表头）
+    static bool dump(int fd);
+    static bool dump(const char* path);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+// 在慢路径入口构造，离开作用域时记录一条事件；未开始记录时只做一次 relaxed 读
+class SlowPathScope
+{
+public:
+#if ENABLE_SLOW_PATH_LOG
+    SlowPathScope(SlowPathEvent::Type type, size_t sizeClass = SlowPathEvent::NO_CLASS, size_t count = 0)
+        : start_(SlowPathLog::enabled() ? SlowPathLog::enter() : 0)
+        , type_(type)
+        , sizeClass_(static_cast<uint32_t>(sizeClass))
+        , count_(static_cast<uint32_t>(count))
+    {}
+
+    ~SlowPathScope()
+    {
+        if(start_)
+        {
+            SlowPathLog::record(type_, sizeClass_, count_, start_, SlowPathLog::now(), wait_);
+            SlowPathLog::leave();
+        }
+    }
+
+    void setCount(size_t count) { count_ = static_cast<uint32_t>(count); }
+    // 在拿到锁之后调用，记下等锁的时间
+    void lockAcquired()
+    {
+        if(start_) wait_ = SlowPathLog::now() - start_;
+    }
+
+private:
+    uint64_t start_;
+    uint64_t wait_ = 0;
+    SlowPathEvent::Type type_;
+    uint32_t sizeClass_;
+    uint32_t count_;
+#else
+    explicit SlowPathScope(SlowPathEvent::Type, size_t = 0, size_t = 0) {}
+    void setCount(size_t) {}
+    void lockAcquired() {}
+#endif
+
+    SlowPathScope(const SlowPathScope&) = delete;
+    SlowPathScope& operator=(const SlowPathScope&) = delete;
+};
+
+}
@@ -1,39 +1,235 @@
 #pragma once
 #include "Common.h"
+#include "Epoch.h"
+#include "Heap.h"
+#include "Options.h"
+#include "TinySlab.h"
+#include <chrono>
 
 namespace my_memorypool
 {
 
-// 线程本地缓存
-class ThreadCache
+template<typename Policy>
+struct ThreadHeapCaches;
+
+// 线程本地缓存（每个线程、每个 Heap 各一份）
+template<typename Policy>
+class BasicThreadCache
 {
 public:
-    static ThreadCache* getInstance()
+    using Traits = PolicyTraits<Policy>;
+    using Heap = BasicHeap<Policy>;
+    using SizeClass = BasicSizeClass<Policy>;
+
+    static constexpr size_t ALIGNMENT = Traits::ALIGNMENT;
+    static constexpr size_t MAX_BYTES = Traits::MAX_BYTES;
+    static constexpr size_t FREE_LIST_SIZE = Traits::FREE_LIST_SIZE;
+    static constexpr size_t PAGE_SIZE = Traits::PAGE_SIZE;
+
+    // 默认堆的线程缓存：快路径只读一次 initial-exec 的线程本地指针，线程第一次调用时才构造
+    static BasicThreadCache* getInstance()
+    {
+        BasicThreadCache* cache = current_;
+        if(MEMPOOL_LIKELY(cache != nullptr)) return cache;
+        return createInstance();
+    }
+
+    // 指定堆的线程缓存
+    static BasicThreadCache* getInstance(Heap& heap);
+
+    ~BasicThreadCache();
+
+    // 快路径内联：命中线程本地自由链表时只做一次弹出 / 压入；size == 0、大对象、
+    // 链表为空或组尚未申请、归还中心缓存等情况都交给不内联的慢路径
+    void* allocate(size_t size)
     {
-        static thread_local ThreadCache instance;
-        return &instance;
+        // size == 0 经无符号回绕与超过 cutoff（不大于 MAX_BYTES）的请求一起落到慢路径
+        if(MEMPOOL_LIKELY(size - 1 < options_->largeObjectCutoff()))
+        {
+            size_t index = SizeClass::getIndex(size);
+#if ENABLE_TINY_SLABS
+            if(TinySlabCache<Policy>::handles(index))
+            {
+                void* ptr = slabs_.allocate(index, heap_->pageCache());
+                return MEMPOOL_LIKELY(ptr != nullptr) ? ptr : allocateSlow(size);
+            }
+#endif
+            FreeList* list = listFor(index);
+            if(MEMPOOL_LIKELY(list != nullptr && list->head != nullptr))
+            {
+                void* ptr = list->head;
+                void* next = *reinterpret_cast<void**>(ptr);
+                list->head = next;
+                // 下一次弹出要读 next 的首字，提前取进缓存
+                MEMPOOL_PREFETCH(next);
+                if(list->size > 0) list->size--;
+                if(list->size < list->lowWater) list->lowWater = list->size;
+                return ptr;
+            }
+        }
+        return allocateSlow(size);
     }
 
-    void* allocate(size_t size);
-    void deallocate(void* ptr, size_t size);
+    void deallocate(void* ptr, size_t size)
+    {
+        // 大于 largeLookupFloor 的对象可能是按页分配的，交给慢路径确认
+        if(MEMPOOL_LIKELY(size <= options_->largeLookupFloor()))
+        {
+            size_t index = SizeClass::getIndex(size);
+#if ENABLE_TINY_SLABS
+            if(TinySlabCache<Policy>::handles(index))
+            {
+                slabs_.deallocate(ptr, heap_->pageCache());
+                return;
+            }
+#endif
+            FreeList* list = listFor(index);
+            if(MEMPOOL_LIKELY(list != nullptr))
+            {
+                *reinterpret_cast<void**>(ptr) = list->head;
+                list->head = ptr;
+                list->size++;
+                if(MEMPOOL_UNLIKELY(list->size > options_->returnThreshold()))
+                {
+                    returnToCentralCache(ptr, size);
+                }
+                return;
+            }
+        }
+        deallocateSlow(ptr, size);
+    }
+
+    // 返回内容全为 0 的块：按页分配的大对象来自已知为 0 的 span 时不再清零；
+    // 小对象刚从已知为 0 的 span 切出时只清掉首字的 next 指针，自由链表中回收来的块整块清零
+    void* allocateZeroed(size_t size);
+
+    // 取出 count 个块后全部释放：超过归还阈值的部分经正常路径回到 CentralCache
+    bool reserve(size_t size, size_t count);
+
+    // 自由链表全部归还给中心缓存，slab 不受影响
+    void trim();
+
+    // 纪元回收（见 BasicEpochDomain）：enter/exit 可嵌套，最外层 exit 后才离开临界区
+    void enter();
+    void exit();
+    // 块已从共享结构中摘下、但可能仍有其他线程在临界区内读取：记入本线程的待回收链，
+    // 确认没有读者后经 deallocate 放回本线程的自由链表；无法申请待回收页时返回 false（块未被接管）
+    bool retire(void* ptr, size_t size);
+    // 尝试推进纪元并释放已安全的块，返回本线程仍在等待的块数
+    size_t reclaim();
 private:
-    ThreadCache()
+    explicit BasicThreadCache(Heap& heap)
+        : heap_(&heap)
+        , heapId_(heap.id())
+        , trimEpoch_(heap.trimEpoch())
+        , options_(&RuntimeOptions<Policy>::instance())
     {
-        // 初始化自由链表和大小统计
-        freeList_.fill(nullptr);
-        freeListSize_.fill(0);      
+        // 自由链表组在首次用到时才申请
+        groups_.fill(nullptr);
     }   
 
-    // 从中心缓存获取内存
-    void* fetchFromCentralCache(size_t index, size_t size);
+    // 本线程第一次取默认堆的线程缓存
+    MEMPOOL_COLD static BasicThreadCache* createInstance();
+
+    // 快路径未命中时的完整分配 / 释放流程
+    MEMPOOL_COLD void* allocateSlow(size_t size);
+    MEMPOOL_COLD void deallocateSlow(void* ptr, size_t size);
+
+    // 丢弃本地自由链表、待回收链等全部状态（flush 归还之后调用）
+    void discard();
+    // 将全部缓存归还给中心缓存（线程退出时）
+    void flush();
+
+    // 取走 PageCache 的压力标志并处理：先清空本线程缓存，再由堆裁剪 CentralCache、调用回调
+    // failed 表示本次申请因硬上限失败；返回 false 表示没有待处理的压力（或正在回调中）
+    bool relievePressure(bool failed);
+
+    // 超过 cutoff 的对象直接按页分配，zeroed 见 BasicPageCache::allocateLargeSpan
+    void* allocateLarge(size_t size, bool* zeroed = nullptr);
+    // 从中心缓存获取内存；zeroed 非空时若这批块刚从已知为 0 的 span 切出，
+    // 其余块放进 zeroRun_（而不是自由链表）并写入 true，返回的块除首字外均为 0
+    void* fetchFromCentralCache(size_t index, size_t size, bool* zeroed = nullptr);
+    // 从 zeroRun_ 取一个 index 类的块，没有时返回 nullptr
+    void* takeZeroRun(size_t index);
+    // zeroRun_ 中剩余的块交回中心缓存
+    void returnZeroRun();
     // 归还内存到中心缓存
-    void returnToCentralCache(void* start, size_t size);
+    MEMPOOL_COLD void returnToCentralCache(void* start, size_t size);
 
     bool shouldReturnToCentralCache(size_t index);
+
+    // 空闲衰减（在慢路径上调用）：距上次衰减超过 IdleDecayMs 时，每个 size-class 归还周期内从未被取用的块
+    void maybeDecay();
+    // 只保留自由链表头部的 keepNum 个块（最近释放、最可能还在缓存中），其余归还中心缓存
+    void shrinkList(size_t index, size_t keepNum);
+
+    using LimboChunk = typename BasicEpochDomain<Policy>::Chunk;
+    // 释放整条待回收链中的块，链上的页留一个备用、其余交回 PageCache；返回释放的块数
+    size_t freeLimbo(LimboChunk* chain);
+    // 线程退出：仍不安全的待回收链交给回收域，由其他线程代为释放
+    void orphanLimbo();
 private:
-    // 每个线程的自由链表数组
-    std::array<void*, FREE_LIST_SIZE> freeList_;
-    std::array<size_t, FREE_LIST_SIZE> freeListSize_; // 自由链表大小统计
+    // 单个 size-class 的自由链表头，长度与低水位放在同一缓存行内，快路径只碰一行
+    struct FreeList
+    {
+        void* head;
+        uint32_t size;     // 链表长度
+        uint32_t lowWater; // 本衰减周期内链表长度的最小值
+    };
+
+    // 自由链表按 size-class 分组，每组占一个逻辑页，首次用到该组时从所属堆的 PageCache 申请；
+    // 线程缓存本身只剩组指针表，创建线程时不再清零、触碰数百 KB 的线程本地存储
+    static constexpr size_t LISTS_PER_GROUP = PAGE_SIZE / sizeof(FreeList);
+    static constexpr size_t GROUP_COUNT = (FREE_LIST_SIZE + LISTS_PER_GROUP - 1) / LISTS_PER_GROUP;
+
+    // 该 size-class 所在的组尚未申请时返回 nullptr
+    FreeList* listFor(size_t index)
+    {
+        FreeList* group = groups_[index / LISTS_PER_GROUP];
+        return group ? group + index % LISTS_PER_GROUP : nullptr;
+    }
+    // 慢路径：必要时申请所在的组，失败（如触及内存上限）时返回 nullptr
+    FreeList* ensureList(size_t index);
+    // 逐个访问已申请的组中的自由链表
+    template<typename Fn>
+    void forEachList(Fn fn);
+
+    friend struct ThreadHeapCaches<Policy>;
+
+    // 默认堆线程缓存的地址；对象本身是 createInstance 中的函数内 thread_local，随线程退出析构
+    static inline thread_local BasicThreadCache* current_ MEMPOOL_TLS_MODEL = nullptr;
+
+    Heap* heap_;
+    uint64_t heapId_; // 绑定时堆的 id，与 heap_->id() 不同说明堆已被 destroy
+    uint64_t trimEpoch_; // 与 heap_->trimEpoch() 不同说明发生过内存压力，下次慢路径上清空自由链表
+    bool relieving_ = false; // 压力回调中的分配不再递归处理压力
+    RuntimeOptions<Policy>* options_; // 构造时缓存，快路径不再经过静态局部变量的初始化检查
+    std::array<FreeList*, GROUP_COUNT> groups_;
+    // allocateZeroed 补货得到的已知为 0 的一批块（除首字外）。不放进自由链表：
+    // 普通 allocate / deallocate 不会经过它们，块被写过后不可能再混进来；同一时刻只保留一个 size-class
+    struct ZeroRun
+    {
+        void* head = nullptr;
+        size_t index = 0;
+        size_t count = 0;
+    };
+    ZeroRun zeroRun_;
+    std::chrono::steady_clock::time_point lastDecay_ = std::chrono::steady_clock::now();
+
+    // 纪元回收：记录在首次 enter/retire 时向回收域领取；待回收块按 retire 时的纪元 % 3 分三条链，
+    // 同一条链上的块纪元相同，写入新纪元前该链上的旧块（至少早两个纪元）一定已经安全
+    EpochRecord* epochRecord_ = nullptr;
+    uint32_t epochNesting_ = 0;
+    std::array<LimboChunk*, 3> limbo_{};
+    LimboChunk* spareChunk_ = nullptr;
+    size_t limboCount_ = 0;
+    size_t reclaimAt_ = Policy::RECLAIM_BATCH; // limboCount_ 达到该值时尝试回收
+#if ENABLE_TINY_SLABS
+    // 最小的几个 size-class 不走自由链表，改用位图 slab
+    TinySlabCache<Policy> slabs_;
+#endif
 };
 
-}
\ No newline at end of file
+using ThreadCache = BasicThreadCache<DefaultPolicy>;
+
+}
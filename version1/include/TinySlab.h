@@ -0,0 +1,181 @@
+#pragma once
+#include "Common.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace my_memorypool
+{
+
+// 位图扫描：编译为 tzcnt/bsf 与 popcnt
+inline size_t lowestSetBit(uint64_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctzll(bits));
+#endif
+}
+
+inline size_t popCount(uint64_t bits)
+{
+#ifdef _MSC_VER
+    return static_cast<size_t>(__popcnt64(bits));
+#else
+    return static_cast<size_t>(__builtin_popcountll(bits));
+#endif
+}
+
+template<typename Policy>
+class BasicPageCache;
+
+// 小对象 slab：占一个逻辑页，页首为 slab 头，其后是等大小的块
+// 所属线程的空闲块记录在 localBits（1 = 空闲），分配时用 ctz 扫描位图找最低位的空闲块，
+// 不读取块内容，也总是优先复用低地址，存活对象更集中；
+// 其他线程释放的块先置位 remoteBits，由所属线程在本地位图耗尽时合并
+template<typename Policy>
+struct TinySlab
+{
+    static constexpr size_t SLAB_BYTES = Policy::PAGE_SIZE;
+    static constexpr size_t WORDS = SLAB_BYTES / Policy::ALIGNMENT / 64;
+    // remoteCount 最高位：所属线程已退出，最后一次远程释放负责归还 slab
+    static constexpr uint64_t ORPHANED = uint64_t(1) << 63;
+    static constexpr uint64_t COUNT_MASK = ORPHANED - 1;
+
+    // 以下字段只由所属线程读写（owner 例外：其他线程只读，用来判断是否本地释放）
+    std::atomic<const void*> owner;
+    TinySlab* prev;
+    TinySlab* next;
+    uint32_t index;
+    uint32_t blockSize;
+    uint32_t capacity;
+    uint32_t localFree;  // localBits 中置位的数量
+    uint32_t hint;       // 可能有空闲位的最小字下标
+    uint32_t reciprocal; // ceil(2^32 / blockSize)，块下标用乘法代替除法
+    uint64_t remoteMerged; // 已合并的远程释放次数
+    uint64_t orphanTarget; // 成为孤儿时，remoteCount 达到该值即全部释放
+    std::array<uint64_t, WORDS> localBits;
+
+    // 远程释放单独占缓存行，避免与所属线程的字段伪共享
+    alignas(64) std::atomic<uint64_t> remoteCount; // 远程释放完成次数（先置位再计数）
+    std::array<std::atomic<uint64_t>, WORDS> remoteBits;
+
+    static constexpr size_t headerBytes() { return (sizeof(TinySlab) + 63) & ~size_t(63); }
+
+    static TinySlab* of(void* ptr)
+    {
+        return reinterpret_cast<TinySlab*>(reinterpret_cast<uintptr_t>(ptr) & ~(uintptr_t)(SLAB_BYTES - 1));
+    }
+
+    char* blocks() { return reinterpret_cast<char*>(this) + headerBytes(); }
+
+    size_t slotOf(void* ptr)
+    {
+        uint64_t offset = static_cast<uint64_t>(static_cast<char*>(ptr) - blocks());
+        return static_cast<size_t>((offset * reciprocal) >> 32);
+    }
+};
+
+// 每个 ThreadCache 持有一份：按 size-class 维护有空闲块的 slab（partial）与已满的 slab（full）
+template<typename Policy>
+class TinySlabCache
+{
+public:
+    using Slab = TinySlab<Policy>;
+    using PageCache = BasicPageCache<Policy>;
+
+    static constexpr size_t CLASSES = Policy::TINY_SLAB_MAX_BYTES / Policy::ALIGNMENT;
+
+    static bool handles(size_t index) { return index < CLASSES; }
+
+    TinySlabCache()
+    {
+        partial_.fill(nullptr);
+        full_.fill(nullptr);
+    }
+
+    TinySlabCache(const TinySlabCache&) = delete;
+    TinySlabCache& operator=(const TinySlabCache&) = delete;
+
+    void* allocate(size_t index, PageCache& pageCache);
+    void deallocate(void* ptr, PageCache& pageCache);
+
+    // 线程退出：完全空闲的 slab 归还 PageCache，其余成为孤儿，由最后一次远程释放归还
+    void flush(PageCache& pageCache);
+    // 堆已整体释放，直接丢弃
+    void discard();
+
+private:
+    Slab* newSlab(size_t index, PageCache& pageCache);
+    // 其他线程的 slab：先置位再计数，计数完成后不再访问 slab（除非由本线程负责归还）
+    static void remoteFree(Slab* slab, size_t word, uint64_t mask, PageCache& pageCache);
+    // 本地释放使 slab 由满变为有空闲，或变为完全空闲
+    void onStateChange(Slab* slab, PageCache& pageCache);
+    // partial 为空时先在 full 中找有远程释放的 slab，没有再申请新 slab
+    Slab* refill(size_t index, PageCache& pageCache);
+    void mergeRemote(Slab* slab);
+    // 没有尚未完成计数的远程释放时才能安全归还
+    static bool remoteSettled(Slab* slab);
+
+    static void unlink(Slab*& list, Slab* slab);
+    static void pushFront(Slab*& list, Slab* slab);
+
+    std::array<Slab*, CLASSES> partial_;
+    std::array<Slab*, CLASSES> full_;
+};
+
+template<typename Policy>
+inline void* TinySlabCache<Policy>::allocate(size_t index, PageCache& pageCache)
+{
+    Slab* slab = partial_[index];
+    if(!slab)
+    {
+        slab = refill(index, pageCache);
+        if(!slab) return nullptr;
+    }
+
+    // localFree > 0 保证 hint 之后必有置位的字
+    size_t w = slab->hint;
+    while(slab->localBits[w] == 0) ++w;
+    uint64_t bits = slab->localBits[w];
+    size_t bit = lowestSetBit(bits);
+    slab->localBits[w] = bits & (bits - 1);
+    slab->hint = static_cast<uint32_t>(w);
+
+    if(--slab->localFree == 0)
+    {
+        unlink(partial_[index], slab);
+        pushFront(full_[index], slab);
+    }
+    return slab->blocks() + (w * 64 + bit) * slab->blockSize;
+}
+
+template<typename Policy>
+inline void TinySlabCache<Policy>::deallocate(void* ptr, PageCache& pageCache)
+{
+    Slab* slab = Slab::of(ptr);
+    size_t slot = slab->slotOf(ptr);
+    size_t w = slot / 64;
+    uint64_t mask = uint64_t(1) << (slot % 64);
+
+    if(slab->owner.load(std::memory_order_relaxed) != this)
+    {
+        remoteFree(slab, w, mask, pageCache);
+        return;
+    }
+
+    slab->localBits[w] |= mask;
+    if(w < slab->hint) slab->hint = static_cast<uint32_t>(w);
+    if(slab->localFree++ == 0 || slab->localFree == slab->capacity)
+    {
+        // 满 -> 有空闲，或变为完全空闲：调整链表 / 归还
+        onStateChange(slab, pageCache);
+    }
+}
+
+}
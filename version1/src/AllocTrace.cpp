@@ -0,0 +1,271 @@
+#include "../include/AllocTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace my_memorypool
+{
+
+namespace
+{
+
+// 每个线程一次预留的槽位数，减少对全局游标的竞争
+constexpr size_t CHUNK_RECORDS = 1024;
+
+// 线程的写入标志：record 期间 active = 1，stop 递增 generation 后逐个等它归零才截断文件、解除映射。
+// 每个线程只写自己的槽（独占缓存行），快路径不碰任何全局计数；线程退出后槽位留给新线程复用
+struct alignas(64) WriterSlot
+{
+    std::atomic<uint32_t> active{0};
+    std::atomic<bool> inUse{false};
+    WriterSlot* next = nullptr;
+};
+
+struct TraceState
+{
+    std::mutex mutex;
+    int fd = -1;
+    char* base = nullptr;
+    size_t capacity = 0;            // 槽位数（CHUNK_RECORDS 的整数倍）
+    std::atomic<size_t> reserved{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> generation{0}; // 每次 start/stop 递增，使线程预留块失效
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<WriterSlot*> writers{nullptr}; // 只增不删
+};
+
+TraceState& traceState()
+{
+    static TraceState* state = new TraceState;
+    return *state;
+}
+
+// 线程本地的预留块，平凡类型，可在任意线程首次访问时零开销初始化
+struct ThreadBuffer
+{
+    uint64_t generation;
+    AllocTrace::Record* cursor;
+    AllocTrace::Record* end;
+    uint32_t threadId;
+    bool slotReleased; // 线程退出时已交还写入槽，之后的 record 另领一个且不再交还
+    WriterSlot* slot;
+};
+
+thread_local ThreadBuffer tlsBuffer{};
+std::atomic<uint32_t> nextThreadId{1};
+
+// 线程退出时交还写入槽；只在领取时访问，record 的快路径不经过它的初始化检查
+struct WriterSlotOwner
+{
+    WriterSlot* slot = nullptr;
+    ~WriterSlotOwner()
+    {
+        if(!slot) return;
+        tlsBuffer.slot = nullptr;
+        tlsBuffer.slotReleased = true;
+        slot->inUse.store(false, std::memory_order_release);
+    }
+};
+
+thread_local WriterSlotOwner tlsSlotOwner;
+
+// 线程第一次 record 时领取写入槽：优先复用已退出线程留下的槽，没有时新建并挂到链表头
+WriterSlot* claimWriterSlot()
+{
+    TraceState& state = traceState();
+    WriterSlot* slot = nullptr;
+    for(WriterSlot* it = state.writers.load(std::memory_order_acquire); it && !slot; it = it->next)
+    {
+        bool expected = false;
+        if(!it->inUse.load(std::memory_order_relaxed) &&
+           it->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            slot = it;
+        }
+    }
+    if(!slot)
+    {
+        slot = new WriterSlot;
+        slot->inUse.store(true, std::memory_order_relaxed);
+        WriterSlot* head = state.writers.load(std::memory_order_relaxed);
+        do
+        {
+            slot->next = head;
+        } while(!state.writers.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+    }
+    if(!tlsBuffer.slotReleased) tlsSlotOwner.slot = slot;
+    return slot;
+}
+
+// 进程启动时根据环境变量自动开始记录
+struct TraceAutoStart
+{
+    TraceAutoStart()
+    {
+        if(const char* path = getenv("MEMPOOL_TRACE_FILE"))
+        {
+            AllocTrace::start(path);
+        }
+    }
+} traceAutoStart;
+
+}
+
+std::atomic<bool> AllocTrace::enabled_{false};
+
+bool AllocTrace::start(const char* path, size_t maxRecords)
+{
+#ifdef _WIN32
+    (void)path; (void)maxRecords;
+    return false;
+#else
+    stop();
+
+    // 进程正常退出时自动结束记录，保证文件头完整
+    static bool atExitRegistered = (std::atexit([] { AllocTrace::stop(); }) == 0);
+    (void)atExitRegistered;
+
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    size_t capacity = (maxRecords + CHUNK_RECORDS - 1) / CHUNK_RECORDS * CHUNK_RECORDS;
+    size_t bytes = sizeof(FileHeader) + capacity * sizeof(Record);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return false;
+    // 稀疏文件：未写入的槽位读出为 0（即 None）
+    if(ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(base == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, "MPTRACE1", 8);
+    header.version = VERSION;
+    header.recordSize = sizeof(Record);
+    std::memcpy(base, &header, sizeof(header));
+
+    state.fd = fd;
+    state.base = static_cast<char*>(base);
+    state.capacity = capacity;
+    state.reserved.store(0, std::memory_order_relaxed);
+    state.dropped.store(0, std::memory_order_relaxed);
+    state.startTime = std::chrono::steady_clock::now();
+    state.generation.fetch_add(1, std::memory_order_release);
+    enabled_.store(true, std::memory_order_release);
+    return true;
+#endif
+}
+
+void AllocTrace::stop()
+{
+#ifndef _WIN32
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if(state.fd < 0) return;
+
+    enabled_.store(false, std::memory_order_release);
+    state.generation.fetch_add(1, std::memory_order_seq_cst);
+    // 等待已经通过 generation 检查的写入完成（每个线程最多一条记录的时间）
+    for(WriterSlot* slot = state.writers.load(std::memory_order_acquire); slot; slot = slot->next)
+    {
+        while(slot->active.load(std::memory_order_seq_cst) != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    size_t used = std::min(state.reserved.load(std::memory_order_acquire), state.capacity);
+    FileHeader* header = reinterpret_cast<FileHeader*>(state.base);
+    header->recordCount = used;
+    header->dropped = state.dropped.load(std::memory_order_relaxed);
+
+    size_t bytes = sizeof(FileHeader) + state.capacity * sizeof(Record);
+    msync(state.base, bytes, MS_SYNC);
+    munmap(state.base, bytes);
+    // 已没有线程持有旧映射，截掉未预留的尾部
+    if(ftruncate(state.fd, static_cast<off_t>(sizeof(FileHeader) + used * sizeof(Record))) != 0)
+    {
+        // 截断失败不影响数据，文件尾部为全 0 的 None 记录
+    }
+    close(state.fd);
+    state.fd = -1;
+    state.base = nullptr;
+    state.capacity = 0;
+#endif
+}
+
+void AllocTrace::record(Op op, void* ptr, size_t size)
+{
+    TraceState& state = traceState();
+    ThreadBuffer& buffer = tlsBuffer;
+
+    // 先置本线程的写入标志再读 generation（均为 seq_cst）：与 stop 中“递增 generation 再逐个等标志归零”配对，
+    // 要么这里看到新的 generation 直接返回，要么 stop 等到这次写入结束
+    if(!buffer.slot) buffer.slot = claimWriterSlot();
+    WriterSlot& slot = *buffer.slot;
+    slot.active.store(1, std::memory_order_seq_cst);
+    struct WriterGuard
+    {
+        std::atomic<uint32_t>& active;
+        ~WriterGuard() { active.store(0, std::memory_order_release); }
+    } guard{slot.active};
+
+    uint64_t generation = state.generation.load(std::memory_order_seq_cst);
+    if(buffer.generation != generation || buffer.cursor == buffer.end)
+    {
+        buffer.generation = generation;
+        buffer.cursor = buffer.end = nullptr;
+        // acquire 与 start 中 enabled_ 的 release 配对，看到开启时 base / capacity 已经发布
+        if(!enabled_.load(std::memory_order_acquire)) return;
+        if(state.reserved.load(std::memory_order_relaxed) >= state.capacity)
+        {
+            state.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        size_t first = state.reserved.fetch_add(CHUNK_RECORDS, std::memory_order_relaxed);
+        if(first + CHUNK_RECORDS > state.capacity)
+        {
+            state.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // 读 generation 与预留之间有新的 start：这一块属于新文件但会被当作旧一轮的预留，放弃（槽位保持 None）
+        if(state.generation.load(std::memory_order_acquire) != generation)
+        {
+            state.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Record* records = reinterpret_cast<Record*>(state.base + sizeof(FileHeader));
+        buffer.cursor = records + first;
+        buffer.end = buffer.cursor + CHUNK_RECORDS;
+    }
+    if(buffer.threadId == 0)
+    {
+        buffer.threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Record* record = buffer.cursor++;
+    record->timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - state.startTime).count());
+    record->object = reinterpret_cast<uint64_t>(ptr);
+    record->size = size;
+    record->thread = buffer.threadId;
+    record->op = op;
+}
+
+}
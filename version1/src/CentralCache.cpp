@@ -1,228 +1,368 @@
 #include "../include/CentralCache.h"
+#include "../include/SlowPathLog.h"
 #include "../include/PageCache.h"
 #include <cassert>
+#include <new>
 #include <thread>
 #include <chrono>
+#include <vector>
 
 // 添加CAS策略，减少线程持有锁的时间，提高了多线程测试时的性能
 
 namespace my_memorypool
 {
 
-const std::chrono::milliseconds CentralCache::DELAY_INTERVAL{1000};
-
-// 每次从PageCache获取span大小（以页为单位）
-static const size_t SPAN_PAGES = 8;
+template<typename Policy>
+BasicCentralCache<Policy>::BasicCentralCache(PageCache& pageCache)
+    : pageCache_(pageCache)
+    , options_(RuntimeOptions<Policy>::instance())
+{
+    reset();
+}
 
-CentralCache::CentralCache()
+template<typename Policy>
+void BasicCentralCache<Policy>::reset()
 {
-    for(auto& ptr : centralFreeList_)
+    // 桶所在的页随 PageCache::releaseAll 归还，这里只丢弃指针
+    for(auto& bucket : buckets_)
     {
-        ptr.store(nullptr,std::memory_order_relaxed);
+        bucket.store(nullptr, std::memory_order_relaxed);
     }
-    for(auto& lock : locks_)
+    bucketCursor_ = nullptr;
+    bucketLimit_ = nullptr;
+    for(auto& tracker : spanTrackers_)
     {
-        lock.clear();
+        tracker.spanAddr.store(nullptr, std::memory_order_relaxed);
+        tracker.numPages.store(0, std::memory_order_relaxed);
+        tracker.blockCount.store(0, std::memory_order_relaxed);
+        tracker.freeCount.store(0, std::memory_order_relaxed);
     }
-    for(auto& flag : returnBusy_)
+    spanCount_.store(0, std::memory_order_relaxed);
+    freeBytes_.store(0, std::memory_order_relaxed);
+    threadBytes_.store(0, std::memory_order_relaxed);
+}
+
+template<typename Policy>
+typename BasicCentralCache<Policy>::Bucket* BasicCentralCache<Policy>::ensureBucket(size_t index)
+{
+    Bucket* bucket = bucketFor(index);
+    if(bucket) return bucket;
+
+    std::lock_guard<std::mutex> guard(bucketMutex_);
+    bucket = buckets_[index].load(std::memory_order_relaxed);
+    if(bucket) return bucket;
+
+    if(static_cast<size_t>(bucketLimit_ - bucketCursor_) < sizeof(Bucket))
     {
-        flag.clear();
+        // 新页按缓存行对齐（页本身按页对齐），每页可切 PAGE_SIZE / sizeof(Bucket) 个桶
+        void* page = pageCache_.allocateSpan(1);
+        if(!page) return nullptr;
+        bucketCursor_ = static_cast<char*>(page);
+        bucketLimit_ = bucketCursor_ + PAGE_SIZE;
     }
-    // 初始化延迟归还相关的成员变量
-    for(auto& count : delayCounts_)
+    bucket = new (bucketCursor_) Bucket;
+    bucketCursor_ += sizeof(Bucket);
+    buckets_[index].store(bucket, std::memory_order_release);
+    return bucket;
+}
+
+template<typename Policy>
+void BasicCentralCache<Policy>::lock(Bucket& bucket)
+{
+    count(bucket, &ContentionCounters::lockAcquisitions);
+    while(bucket.lock.test_and_set(std::memory_order_acquire))
     {
-        count.store(0, std::memory_order_relaxed);
+        count(bucket, &ContentionCounters::lockSpins);
+        std::this_thread::yield();
     }
-    for(auto& time : lastReturnTimes_)
+}
+
+template<typename Policy>
+std::vector<CentralClassStats> BasicCentralCache<Policy>::contentionStats() const
+{
+    std::vector<CentralClassStats> result;
+#if ENABLE_CENTRAL_STATS
+    for(size_t index = 0; index < FREE_LIST_SIZE; ++index)
     {
-        time = std::chrono::steady_clock::now();
+        const Bucket* bucket = bucketFor(index);
+        if(!bucket) continue;
+        const auto& c = bucket->contention;
+        CentralClassStats s;
+        s.blockSize = (index + 1) * ALIGNMENT;
+        s.lockAcquisitions = c.lockAcquisitions.load(std::memory_order_relaxed);
+        s.lockSpins = c.lockSpins.load(std::memory_order_relaxed);
+        s.casFailures = c.casFailures.load(std::memory_order_relaxed);
+        s.fallbackLocks = c.fallbackLocks.load(std::memory_order_relaxed);
+        s.delayReturns = c.delayReturns.load(std::memory_order_relaxed);
+        s.delayReturnNs = c.delayReturnNs.load(std::memory_order_relaxed);
+        if(s.lockAcquisitions || s.casFailures || s.delayReturns) result.push_back(s);
     }
-    spanCount_.store(0, std::memory_order_relaxed);
+#endif
+    return result;
+}
+
+template<typename Policy>
+void BasicCentralCache<Policy>::resetContentionStats()
+{
+#if ENABLE_CENTRAL_STATS
+    for(auto& entry : buckets_)
+    {
+        Bucket* bucket = entry.load(std::memory_order_acquire);
+        if(!bucket) continue;
+        auto& c = bucket->contention;
+        for(auto counter : {&ContentionCounters::lockAcquisitions, &ContentionCounters::lockSpins,
+                            &ContentionCounters::casFailures,
+                            &ContentionCounters::fallbackLocks, &ContentionCounters::delayReturns,
+                            &ContentionCounters::delayReturnNs})
+        {
+            (c.*counter).store(0, std::memory_order_relaxed);
+        }
+    }
+#endif
 }
 
-size_t CentralCache::fetchRange(void*& start, void*& end, size_t batchNum, size_t index)
+template<typename Policy>
+size_t BasicCentralCache<Policy>::fetchRange(void*& start, void*& end, size_t batchNum, size_t index, bool* zeroed)
 {
     // 索引检查
     if(index >= FREE_LIST_SIZE ) return 0;
 
     start = nullptr;
     end = nullptr;
-    size_t actualNum = 0;
+    if(zeroed) *zeroed = false;
+    size_t blockSize = (index + 1) * ALIGNMENT;
 
-    // 1. 尝试从 centralFreeList_ 中获取
-    while(true)
-    {
-        void* head = centralFreeList_[index].load(std::memory_order_acquire);
-        if(!head) break; // 若为空，转到 PageCache 申请
-
-        while(locks_[index].test_and_set(std::memory_order_acquire)) {
-            std::this_thread::yield(); 
-        }
+    Bucket* bucket = ensureBucket(index);
+    if(!bucket) return 0;
+    lock(*bucket);
 
-        // 双重检查
-        head = centralFreeList_[index].load(std::memory_order_relaxed);
-        if (head == nullptr) {
-            locks_[index].clear(std::memory_order_release);
-            break; // 真的没空闲了
-        }
+    // 1. 优先从中心自由链表中获取（已归还的块）
+    void* head = bucket->freeList.load(std::memory_order_acquire);
+    if(!head)
+    {
+        // 2. 自由链表为空，从当前 span 的未切分区域按需切出一批
+        size_t actualNum = carveLocked(start, end, batchNum, index, *bucket);
+        if(zeroed) *zeroed = actualNum > 0 && bucket->carve.zeroed;
+        unlock(*bucket);
+        return actualNum;
+    }
 
-        // 在锁保护下，我们可以安全地遍历
+    // 持锁时只有 returnRange 的无锁入链会并发修改链表头，且只在头部前插、不改动已有节点的链接：
+    // 从当前头部数出一批后用 CAS 摘下，失败说明期间有块推入，从新的头部重数（链表不会变空）
+    size_t actualNum;
+    void* newHead;
+    while(true)
+    {
         start = head;
         end = head;
         actualNum = 1;
-
         while (actualNum < batchNum) {
             void* next = *reinterpret_cast<void**>(end);
             if (next == nullptr) break;
             end = next;
             actualNum++;
         }
+        newHead = *reinterpret_cast<void**>(end);
+        if(bucket->freeList.compare_exchange_weak(
+                head,
+                newHead,
+                std::memory_order_acquire,
+                std::memory_order_acquire))
+        {
+            break;
+        }
+        count(*bucket, &ContentionCounters::casFailures);
+    }
 
-        // 断开链表
-        void* newHead = *reinterpret_cast<void**>(end);
-        centralFreeList_[index].store(newHead, std::memory_order_relaxed);
-        *reinterpret_cast<void**>(end) = nullptr;
-        
-        // 关键性能修正：将 SpanTracker 更新移出锁外！
-        locks_[index].clear(std::memory_order_release);
+    // 断开链表
+    *reinterpret_cast<void**>(end) = nullptr;
+
+    // 关键性能修正：将 SpanTracker 更新移出锁外！
+    unlock(*bucket);
+
+    freeBytes_.fetch_sub(actualNum * blockSize, std::memory_order_relaxed);
+    threadBytes_.fetch_add(actualNum * blockSize, std::memory_order_relaxed);
 
 #if ENABLE_SPAN_TRACKING
-        // 更新这批块所属 Span 的引用计数 
-        // 优化策略：聚合更新。因为链表中的块很可能属于同一个 Span。
-        void* curr = start;
-        SpanTracker* lastTracker = nullptr;
-        size_t batchCount = 0;
-
-        while(curr) {
-            // 优化：只有当跨页或者 Span 改变时才去更新 Tracker
-            // 这里为了简单且正确，我们用 getSpanTracker 检查，也可以比较页地址优化
-            SpanTracker* tracker = getSpanTracker(curr);
-            
-            if (tracker != lastTracker) {
-                // 提交之前的计数
-                if (lastTracker && batchCount > 0) {
-                    lastTracker->freeCount.fetch_sub(batchCount, std::memory_order_release);
-                }
-                lastTracker = tracker;
-                batchCount = 0;
-            }
-            
-            if (tracker) {
-                batchCount++;
+    // 更新这批块所属 Span 的引用计数 
+    // 优化策略：聚合更新。因为链表中的块很可能属于同一个 Span。
+    void* curr = start;
+    SpanTracker* lastTracker = nullptr;
+    size_t batchCount = 0;
+
+    while(curr) {
+        // 优化：只有当跨页或者 Span 改变时才去更新 Tracker
+        // 这里为了简单且正确，我们用 getSpanTracker 检查，也可以比较页地址优化
+        SpanTracker* tracker = getSpanTracker(curr);
+        
+        if (tracker != lastTracker) {
+            // 提交之前的计数
+            if (lastTracker && batchCount > 0) {
+                lastTracker->freeCount.fetch_sub(batchCount, std::memory_order_release);
             }
-            
-            curr = *reinterpret_cast<void**>(curr);
+            lastTracker = tracker;
+            batchCount = 0;
         }
         
-        // 提交最后一批
-        if (lastTracker && batchCount > 0) {
-            lastTracker->freeCount.fetch_sub(batchCount, std::memory_order_release);
+        if (tracker) {
+            batchCount++;
         }
+        
+        curr = *reinterpret_cast<void**>(curr);
+    }
+    
+    // 提交最后一批
+    if (lastTracker && batchCount > 0) {
+        lastTracker->freeCount.fetch_sub(batchCount, std::memory_order_release);
+    }
 #endif
 
-        return actualNum;
-    }
+    return actualNum;
+}
 
-    // 2. 如果 CentralCache 为空，向 PageCache 申请新 Span
+template<typename Policy>
+size_t BasicCentralCache<Policy>::carveLocked(void*& start, void*& end, size_t batchNum, size_t index,
+                                              Bucket& bucket)
+{
     size_t size = (index + 1) * ALIGNMENT;
+    CarveRegion& region = bucket.carve;
 
-    // 动态计算 numPages：
-    // 策略：保证至少能申请到 limit 个对象，且总大小不超过 MAX_SPAN_SIZE (例如 1MB)
-    // 这样对于小对象保持 SPAN_PAGES(8页)，对于中大对象则增加页数以减少 mmap 次数
-    size_t minObjects = 64; // 至少一次申请 64 个对象
-    size_t targetBytes = minObjects * size;
-    size_t minPages = (targetBytes + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE;
-
-    if (minPages < SPAN_PAGES) minPages = SPAN_PAGES;
-    // 上限控制，比如单次 span 最大 512KB (128页)
-    if (minPages > 128) minPages = 128;
-
-  
-    void* spanStart = nullptr;
-    size_t numPages = minPages;
-    
-    spanStart = PageCache::getInstance().allocateSpan(numPages);
-    if(!spanStart) return 0;
-    
-    // -----------------------------------------------------------
+    // 当前 span 已切完，向 PageCache 申请新 Span（持有本 size-class 的锁，PageCache 不会回调本层）
+    if(static_cast<size_t>(region.limit - region.cursor) < size)
+    {
+        // 动态计算 numPages：
+        // 策略：保证至少能申请到 limit 个对象，且总大小不超过 MAX_SPAN_SIZE (例如 1MB)
+        // 这样对于小对象保持 SPAN_PAGES(8页)，对于中大对象则增加页数以减少 mmap 次数
+        // 着色偏移会占用 span 开头的空间，计入目标大小，保证着色后仍能切出 minObjects 个
+        constexpr size_t MAX_COLOUR_OFFSET = (Policy::CACHE_COLOURS - 1) * Policy::CACHE_LINE;
+        size_t minObjects = Policy::MIN_SPAN_OBJECTS; // 至少一次申请 64 个对象
+        size_t targetBytes = minObjects * size + (size >= Policy::CACHE_LINE ? MAX_COLOUR_OFFSET : 0);
+        size_t numPages = (targetBytes + PAGE_SIZE - 1) / PAGE_SIZE;
+
+        if (numPages < Policy::SPAN_PAGES) numPages = Policy::SPAN_PAGES;
+        // 上限控制，比如单次 span 最大 512KB (128页)
+        if (numPages > Policy::MAX_SPAN_PAGES) numPages = Policy::MAX_SPAN_PAGES;
+
+        bool spanZeroed = false;
+        void* spanStart = pageCache_.allocateSpan(numPages, &spanZeroed);
+        if(!spanStart) return 0;
+
+        size_t spanBytes = numPages * PAGE_SIZE;
+        size_t blockNum = spanBytes / size;
+        if(blockNum == 0) return 0;
+
+        // 小于一个缓存行的对象本来就共享缓存行，不着色；
+        // 尾部余量不够时要牺牲块，损失超过 span 的 1/32（如每个 span 只有几个大块）时也不着色
+        size_t colourOffset = 0;
+        if(size >= Policy::CACHE_LINE && Policy::CACHE_COLOURS > 1)
+        {
+            size_t offset = (region.nextColour % Policy::CACHE_COLOURS) * Policy::CACHE_LINE;
+            size_t colouredNum = (spanBytes - offset) / size;
+            if((blockNum - colouredNum) * 32 <= blockNum)
+            {
+                colourOffset = offset;
+                blockNum = colouredNum;
+                ++region.nextColour;
+            }
+        }
 
-    // 切分新 Span
-    char* base = static_cast<char*>(spanStart);
-    size_t blockNum = (numPages * PageCache::PAGE_SIZE) / size;
+        region.zeroed = spanZeroed;
+        region.cursor = static_cast<char*>(spanStart) + colourOffset;
+        region.limit = region.cursor + blockNum * size;
+        region.tracker = registerSpan(spanStart, numPages, blockNum, colourOffset);
+        // 未切分的块同样计入中心缓存的空闲字节
+        freeBytes_.fetch_add(blockNum * size, std::memory_order_relaxed);
+    }
 
-    if (blockNum == 0) return 0;
+    // 只为交出去的这一批写入 next 指针，其余页保持未触碰
+    size_t available = static_cast<size_t>(region.limit - region.cursor) / size;
+    size_t actualNum = (batchNum < available) ? batchNum : available;
 
-    // 链接所有块
-    void* last = nullptr;
-    for(size_t i = 0; i < blockNum; ++i) {
-        void* current = base + i * size;
-        void* next = (i < blockNum - 1) ? (base + (i+1)*size) : nullptr;
-        *reinterpret_cast<void**>(current) = next;
-        if (i == blockNum - 1) last = current;
+    char* base = region.cursor;
+    for(size_t i = 0; i + 1 < actualNum; ++i)
+    {
+        *reinterpret_cast<void**>(base + i * size) = base + (i + 1) * size;
     }
-
-    // 3. 将一部分返回给 ThreadCache，剩下的放入 CentralCache
-    
-    // 我们至少能满足 min(batchNum, blockNum)
-    actualNum = (batchNum < blockNum) ? batchNum : blockNum;
-    
     start = base;
-    
-    // 找到切分点 (第 actualNum 个节点是 end)
-    end = start;
-    for (size_t i = 1; i < actualNum; ++i) {
-        end = *reinterpret_cast<void**>(end);
-    }
-    
-    void* remainStart = *reinterpret_cast<void**>(end);
-    *reinterpret_cast<void**>(end) = nullptr; // 断开
-    
-    // 如果有剩余，放入 centralFreeList_ (使用无锁 CAS)
-    if (remainStart) {
-        void* remainEnd = last;
-        while(true) {
-            void* head = centralFreeList_[index].load(std::memory_order_acquire);
-            *reinterpret_cast<void**>(remainEnd) = head;
-            if(centralFreeList_[index].compare_exchange_weak(
-                    head,
-                    remainStart,
-                    std::memory_order_release,
-                    std::memory_order_acquire))
+    end = base + (actualNum - 1) * size;
+    *reinterpret_cast<void**>(end) = nullptr;
+    region.cursor += actualNum * size;
+
+    freeBytes_.fetch_sub(actualNum * size, std::memory_order_relaxed);
+    threadBytes_.fetch_add(actualNum * size, std::memory_order_relaxed);
+#if ENABLE_SPAN_TRACKING
+    if(region.tracker) region.tracker->freeCount.fetch_sub(actualNum, std::memory_order_release);
+#endif
+    return actualNum;
+}
+
+template<typename Policy>
+SpanTracker* BasicCentralCache<Policy>::registerSpan(void* spanAddr, size_t numPages, size_t blockNum,
+                                                     size_t colourOffset)
+{
+#if ENABLE_SPAN_TRACKING
+    // 先复用已归还 span 留下的空槽，没有空槽时再追加；
+    // 槽位均以 CAS 占用，不同 size-class 并发注册时不会写到同一槽
+    while(true)
+    {
+        size_t limit = spanCount_.load(std::memory_order_relaxed);
+        if(limit > spanTrackers_.size()) limit = spanTrackers_.size();
+        size_t slot = limit;
+        for(size_t i = 0; i < limit; ++i)
+        {
+            if(spanTrackers_[i].spanAddr.load(std::memory_order_relaxed) == nullptr)
             {
+                slot = i;
                 break;
             }
-            std::this_thread::yield();
         }
+        if(slot == limit)
+        {
+            slot = spanCount_.fetch_add(1, std::memory_order_relaxed);
+            if(slot >= spanTrackers_.size())
+            {
+                // Tracker 满了，可能无法回收这块内存
+                spanCount_.store(spanTrackers_.size(), std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+
+        SpanTracker& tracker = spanTrackers_[slot];
+        void* expected = nullptr;
+        if(!tracker.spanAddr.compare_exchange_strong(expected, spanAddr, std::memory_order_acq_rel))
+        {
+            continue; // 被其他线程抢先占用
+        }
+        // numPages 最后写入：写入前该槽的地址范围为空，getSpanTracker 不会匹配到
+        tracker.blockCount.store(blockNum, std::memory_order_relaxed);
+        tracker.freeCount.store(blockNum, std::memory_order_relaxed);
+        tracker.colourOffset.store(colourOffset, std::memory_order_relaxed);
+        tracker.numPages.store(numPages, std::memory_order_release);
+        return &tracker;
     }
-    
-#if ENABLE_SPAN_TRACKING
-    // 注册 SpanTracker (略微简化原逻辑，只注册一次)
-    size_t trackerIndex = spanCount_.fetch_add(1, std::memory_order_relaxed);
-    if(trackerIndex < spanTrackers_.size())
-    {
-        spanTrackers_[trackerIndex].spanAddr.store(base, std::memory_order_release);
-        spanTrackers_[trackerIndex].numPages.store(numPages, std::memory_order_release);
-        spanTrackers_[trackerIndex].blockCount.store(blockNum, std::memory_order_release);
-        spanTrackers_[trackerIndex].freeCount.store(blockNum - actualNum, std::memory_order_release);
-    }
-    else
-    {
-        // Tracker 满了，可能无法回收这块内存
-        spanCount_.store(spanTrackers_.size(), std::memory_order_relaxed);
-    }
+#else
+    (void)spanAddr;
+    (void)numPages;
+    (void)blockNum;
+    (void)colourOffset;
+    return nullptr;
 #endif
-
-    return actualNum;
-} 
+}
 
 
-void CentralCache::returnRange(void* start, size_t size, size_t index)
+template<typename Policy>
+void BasicCentralCache<Policy>::returnRange(void* start, size_t size, size_t index)
 {
     if(!start || index >= FREE_LIST_SIZE)
     {
         return;
     }
 
+        // 块都由本层 fetchRange 交出，所属 size-class 的桶此时必然已存在
+        Bucket* bucket = bucketFor(index);
+        assert(bucket);
+        if(!bucket) return;
+
         size_t blockSize = (index + 1) * ALIGNMENT;
         size_t blockCount = size / blockSize;
 
@@ -237,13 +377,17 @@ void CentralCache::returnRange(void* start, size_t size, size_t index)
         // 强制截断链，确保以nullptr结束
         *reinterpret_cast<void**>(end) = nullptr;
 
+        // 先记账再入链，避免并发的 fetchRange 先扣减导致统计下溢
+        freeBytes_.fetch_add(endCount * blockSize, std::memory_order_relaxed);
+        threadBytes_.fetch_sub(endCount * blockSize, std::memory_order_relaxed);
+
         // 2) CAS 无锁入链
         size_t casAttempts = 0;
         while(true)
         {
-            void* head = centralFreeList_[index].load(std::memory_order_acquire);
+            void* head = bucket->freeList.load(std::memory_order_acquire);
             *reinterpret_cast<void**>(end) = head;
-            if(centralFreeList_[index].compare_exchange_weak(
+            if(bucket->freeList.compare_exchange_weak(
                     head,
                     start,
                     std::memory_order_release,
@@ -251,151 +395,237 @@ void CentralCache::returnRange(void* start, size_t size, size_t index)
             {
                 break;
             }
+            count(*bucket, &ContentionCounters::casFailures);
             std::this_thread::yield();
             if(++casAttempts > 1000000)
             {
-                // 防御性回退：持锁推入，避免CAS饥饿
-                while(locks_[index].test_and_set(std::memory_order_acquire))
+                // 防御性回退：持锁挡住 fetchRange 与延迟归还后再推入；其他线程的无锁入链仍可能并发，
+                // 因此仍用 CAS（直接 store 会覆盖掉别人刚推入的块）
+                count(*bucket, &ContentionCounters::fallbackLocks);
+                lock(*bucket);
+                void* headLocked = bucket->freeList.load(std::memory_order_acquire);
+                do
                 {
-                    std::this_thread::yield();
-                }
-                void* headLocked = centralFreeList_[index].load(std::memory_order_relaxed);
-                *reinterpret_cast<void**>(end) = headLocked;
-                centralFreeList_[index].store(start, std::memory_order_release);
-                locks_[index].clear(std::memory_order_release);
+                    *reinterpret_cast<void**>(end) = headLocked;
+                } while(!bucket->freeList.compare_exchange_weak(
+                    headLocked,
+                    start,
+                    std::memory_order_release,
+                    std::memory_order_acquire));
+                unlock(*bucket);
                 break;
             }
         }
 
 #if ENABLE_SPAN_TRACKING
         // 3) 累加延迟归还计数，达到阈值时尝试触发 Span 扫描回收
-        size_t prevCount = delayCounts_[index].fetch_add(endCount, std::memory_order_relaxed);
+        size_t prevCount = bucket->delayCount.fetch_add(endCount, std::memory_order_relaxed);
         size_t currentCount = prevCount + endCount;
         auto now = std::chrono::steady_clock::now();
-        if (shouldPerformDelayedReturn(index, currentCount, now))
+        if (shouldPerformDelayedReturn(*bucket, currentCount, now))
         {
             // atomic_flag::test_and_set 返回旧值，false=获取成功
-            if (!returnBusy_[index].test_and_set(std::memory_order_acquire))
+            if (!bucket->returnBusy.test_and_set(std::memory_order_acquire))
             {
-                performDelayReturn(index);
-                returnBusy_[index].clear(std::memory_order_release);
+#if ENABLE_CENTRAL_STATS
+                auto begin = std::chrono::steady_clock::now();
+                performDelayReturn(index, *bucket);
+                count(*bucket, &ContentionCounters::delayReturns);
+                count(*bucket, &ContentionCounters::delayReturnNs, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - begin).count());
+#else
+                performDelayReturn(index, *bucket);
+#endif
+                bucket->returnBusy.clear(std::memory_order_release);
             }
         }
 #endif
 }
 
-bool CentralCache::shouldPerformDelayedReturn(size_t index, size_t currentCount, 
+template<typename Policy>
+void BasicCentralCache<Policy>::trim()
+{
+#if ENABLE_SPAN_TRACKING
+    for(size_t index = 0; index < FREE_LIST_SIZE; ++index)
+    {
+        Bucket* bucket = bucketFor(index);
+        if(!bucket || !bucket->freeList.load(std::memory_order_relaxed)) continue;
+        // 与 returnRange 触发的扫描互斥，正在扫描的 size-class 跳过
+        if(!bucket->returnBusy.test_and_set(std::memory_order_acquire))
+        {
+            performDelayReturn(index, *bucket);
+            bucket->returnBusy.clear(std::memory_order_release);
+        }
+    }
+#endif
+}
+
+template<typename Policy>
+bool BasicCentralCache<Policy>::shouldPerformDelayedReturn(Bucket& bucket, size_t currentCount, 
         std::chrono::steady_clock::time_point currentTime)
 {
     // 更保守：同时满足计数与时间间隔，减少频繁触发
-    if(currentCount < MAX_DELAY_COUNT) return false;
-    auto lastTime = lastReturnTimes_[index];
-    return (currentTime - lastTime) >= DELAY_INTERVAL;
+    if(currentCount < options_.get(Option::MaxDelayCount)) return false;
+    auto lastTime = bucket.lastReturnTime;
+    return (currentTime - lastTime) >= std::chrono::milliseconds(options_.get(Option::DelayIntervalMs));
 }
 
-void CentralCache::performDelayReturn(size_t index)
+template<typename Policy>
+void BasicCentralCache<Policy>::performDelayReturn(size_t index, Bucket& bucket)
 {
-    // 重置延迟计数，更新最后归还时间
-    delayCounts_[index].store(0, std::memory_order_relaxed);
-    lastReturnTimes_[index] = std::chrono::steady_clock::now();
+    SlowPathScope scope(SlowPathEvent::DelayReturn, index);
 
-    // 扫描 centralFreeList_ 统计每个 span 的空闲块数
-    // 扫描不加锁，属于 best-effort 启发式统计
+    // 重置延迟计数，更新最后归还时间
+    bucket.delayCount.store(0, std::memory_order_relaxed);
+    bucket.lastReturnTime = std::chrono::steady_clock::now();
+
+    // 只在摘链时持锁：fetchRange 的数链与 CAS 都在锁内，摘下时没有线程正在遍历这条链；
+    // 之后链表归本线程独占，统计、过滤都在锁外进行，并发的 fetchRange / returnRange 只面对新的空链表
+    lock(bucket);
+    scope.lockAcquired();
+    void* list = bucket.freeList.exchange(nullptr, std::memory_order_acquire);
+    unlock(bucket);
+    if(!list) return;
+
+    // 统计每个 span 在链表中的空闲块数，同时找到链表尾部以便放回
+    constexpr size_t SCAN_BUDGET = 1000000;
     std::unordered_map<SpanTracker*, size_t> spanFreeCounts;
-    void* currentBlock = centralFreeList_[index].load(std::memory_order_relaxed);
-    size_t scanBudget = 1000000;
-
-    while(currentBlock && scanBudget--)
+    size_t scanned = 0;
+    void* tail = nullptr;
+    for(void* block = list; block; block = *reinterpret_cast<void**>(block))
     {
-        SpanTracker* tracker = getSpanTracker(currentBlock);
-        if(tracker)
+        if(scanned++ < SCAN_BUDGET)
         {
-            spanFreeCounts[tracker]++;
+            SpanTracker* tracker = getSpanTracker(block);
+            if(tracker)
+            {
+                spanFreeCounts[tracker]++;
+            }
         }
-        currentBlock = *reinterpret_cast<void**>(currentBlock);
+        tail = block;
     }
 
-    if(scanBudget == 0)
+    // 链表过长时统计不完整，放弃本轮回收，原样放回。
+    // 摘下的链表之外的块要么在线程缓存中、要么是扫描期间新推入的，都不计入：
+    // 统计到的块数等于 blockCount 时该 span 的全部块都在这条私有链表上，可以安全归还
+    std::vector<SpanTracker*> freeSpans;
+    if(scanned <= SCAN_BUDGET)
     {
-        return;
+        for(const auto& [tracker, newFreeBlocks] : spanFreeCounts)
+        {
+            // 直接更新为当前在链表中统计到的空闲块数（而非累加历史值）
+            tracker->freeCount.store(newFreeBlocks, std::memory_order_release);
+            // 所有块都已空闲的 span 可以归还；正在切分的 span 还有未切出的块，不会满足条件
+            if(newFreeBlocks == tracker->blockCount.load(std::memory_order_relaxed))
+            {
+                freeSpans.push_back(tracker);
+            }
+        }
     }
 
-    // 持锁批量处理 span 回收，避免与 fetchRange 并发修改链表
-    while(locks_[index].test_and_set(std::memory_order_acquire))
+    if(!freeSpans.empty())
     {
-        std::this_thread::yield();
-    }
-    for(const auto& [tracker, newFreeBlocks] : spanFreeCounts)
-    {
-        updateSpanFreeCount(tracker, newFreeBlocks, index);
-    }
-    locks_[index].clear(std::memory_order_release);
-}
-
-void CentralCache::updateSpanFreeCount(SpanTracker* tracker, size_t newFreeBlocks, size_t index)
-{
-    // 直接更新为当前在链表中统计到的空闲块数（而非累加历史值）
-    tracker->freeCount.store(newFreeBlocks, std::memory_order_release);
-    size_t newFreeCount = newFreeBlocks;
-
-    // 当所有块都空闲时，归还span
-    if(newFreeCount == tracker->blockCount.load(std::memory_order_relaxed))
-    {
-        void* spanAddr = tracker->spanAddr.load(std::memory_order_relaxed);
-        size_t numPages = tracker->numPages.load(std::memory_order_relaxed);
-
-        // 从自由链表中移除这些块
-        void* head = centralFreeList_[index].load(std::memory_order_relaxed);
-        void* newHead = head;
-        void* prev = nullptr;
-        void* current = head;
-
-        while(current)
+        auto inFreeSpan = [&](void* block)
         {
-            void* next = *reinterpret_cast<void**>(current);
-            if(current >= spanAddr &&
-                current < static_cast<char*>(spanAddr) + numPages * PageCache::PAGE_SIZE)
+            for(SpanTracker* tracker : freeSpans)
             {
-                if(prev)
-                {
-                    *reinterpret_cast<void**>(prev) = next;
-                }
-                else
-                {
-                    newHead = next;
-                }
+                char* spanAddr = static_cast<char*>(tracker->spanAddr.load(std::memory_order_relaxed));
+                size_t numPages = tracker->numPages.load(std::memory_order_relaxed);
+                if(block >= spanAddr && block < spanAddr + numPages * PAGE_SIZE) return true;
+            }
+            return false;
+        };
+
+        // 从私有链表中移除这些块
+        void* keptHead = nullptr;
+        void* keptTail = nullptr;
+        size_t removed = 0;
+        for(void* block = list; block; )
+        {
+            void* next = *reinterpret_cast<void**>(block);
+            if(inFreeSpan(block))
+            {
+                ++removed;
             }
             else
             {
-                prev = current;
+                if(keptTail) *reinterpret_cast<void**>(keptTail) = block;
+                else keptHead = block;
+                keptTail = block;
             }
-            current = next;
+            block = next;
         }
+        if(keptTail) *reinterpret_cast<void**>(keptTail) = nullptr;
+        list = keptHead;
+        tail = keptTail;
 
-        centralFreeList_[index].store(newHead,std::memory_order_release);
-        PageCache::getInstance().deallocateSpan(spanAddr, numPages);
+        freeBytes_.fetch_sub(removed * (index + 1) * ALIGNMENT, std::memory_order_relaxed);
+        scope.setCount(removed);
     }
+
+    // 剩余的块无锁放回，与期间并发推入的块拼接（只在头部前插，与 returnRange 相同）
+    if(list)
+    {
+        while(true)
+        {
+            void* head = bucket.freeList.load(std::memory_order_acquire);
+            *reinterpret_cast<void**>(tail) = head;
+            if(bucket.freeList.compare_exchange_weak(
+                    head,
+                    list,
+                    std::memory_order_release,
+                    std::memory_order_acquire))
+            {
+                break;
+            }
+            count(bucket, &ContentionCounters::casFailures);
+        }
+    }
+
+    // 不持有任何锁时才进入 PageCache
+    for(SpanTracker* tracker : freeSpans)
+    {
+        releaseSpan(tracker);
+    }
+}
+
+template<typename Policy>
+void BasicCentralCache<Policy>::releaseSpan(SpanTracker* tracker)
+{
+    void* spanAddr = tracker->spanAddr.load(std::memory_order_relaxed);
+    size_t numPages = tracker->numPages.load(std::memory_order_relaxed);
+
+    // 先清空地址范围再释放槽位，之后 getSpanTracker 不会再命中这个 span；
+    // 否则该地址被 PageCache 重新分配后会被误记到旧的 tracker 上
+    tracker->numPages.store(0, std::memory_order_release);
+    tracker->blockCount.store(0, std::memory_order_relaxed);
+    tracker->freeCount.store(0, std::memory_order_relaxed);
+    tracker->spanAddr.store(nullptr, std::memory_order_release);
+
+    pageCache_.deallocateSpan(spanAddr, numPages);
 }
 
-void* CentralCache::fetchFromPageCache(size_t size)
+template<typename Policy>
+void* BasicCentralCache<Policy>::fetchFromPageCache(size_t size)
 {
     // 实际需要的页数
-    size_t numPages = (size + PageCache::PAGE_SIZE - 1) / PageCache::PAGE_SIZE;
+    size_t numPages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
 
     // 决定分配策略
-    if(size <= SPAN_PAGES * PageCache::PAGE_SIZE)
+    if(size <= Policy::SPAN_PAGES * PAGE_SIZE)
     {
         // 小于32KB的请求，固定使用8页
-        return PageCache::getInstance().allocateSpan(SPAN_PAGES);
+        return pageCache_.allocateSpan(Policy::SPAN_PAGES);
     }
     else
     {
         // 大于32KB的请求，按实际需求分配
-        return PageCache::getInstance().allocateSpan(numPages);
+        return pageCache_.allocateSpan(numPages);
     }
 }
 
-SpanTracker* CentralCache::getSpanTracker(void* blockAddr)
+template<typename Policy>
+SpanTracker* BasicCentralCache<Policy>::getSpanTracker(void* blockAddr)
 {
     // 避免越界：只遍历有效范围
     size_t limit = spanCount_.load(std::memory_order_relaxed);
@@ -407,7 +637,7 @@ SpanTracker* CentralCache::getSpanTracker(void* blockAddr)
         size_t numPages = spanTrackers_[i].numPages.load(std::memory_order_relaxed);
 
         if(blockAddr >= spanAddr &&
-            blockAddr < static_cast<char*>(spanAddr) + numPages * PageCache::PAGE_SIZE)
+            blockAddr < static_cast<char*>(spanAddr) + numPages * PAGE_SIZE)
         {
             return &spanTrackers_[i];
         }
@@ -415,4 +645,7 @@ SpanTracker* CentralCache::getSpanTracker(void* blockAddr)
     return nullptr;
 }
 
+template class BasicCentralCache<DefaultPolicy>;
+template class BasicCentralCache<TinyObjectPolicy>;
+
 }
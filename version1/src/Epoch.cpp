@@ -0,0 +1,124 @@
+#include "../include/Epoch.h"
+
+namespace my_memorypool
+{
+
+template<typename Policy>
+BasicEpochDomain<Policy>::~BasicEpochDomain()
+{
+    EpochRecord* record = records_.load(std::memory_order_acquire);
+    while(record)
+    {
+        EpochRecord* next = record->next;
+        delete record;
+        record = next;
+    }
+}
+
+template<typename Policy>
+EpochRecord* BasicEpochDomain<Policy>::acquireRecord()
+{
+    for(EpochRecord* record = records_.load(std::memory_order_acquire); record; record = record->next)
+    {
+        bool expected = false;
+        if(!record->inUse.load(std::memory_order_relaxed) &&
+           record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            return record;
+        }
+    }
+
+    EpochRecord* record = new EpochRecord;
+    record->inUse.store(true, std::memory_order_relaxed);
+    EpochRecord* head = records_.load(std::memory_order_relaxed);
+    do
+    {
+        record->next = head;
+    } while(!records_.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+    return record;
+}
+
+template<typename Policy>
+void BasicEpochDomain<Policy>::releaseRecord(EpochRecord* record)
+{
+    record->state.store(0, std::memory_order_release);
+    record->inUse.store(false, std::memory_order_release);
+}
+
+template<typename Policy>
+uint64_t BasicEpochDomain<Policy>::tryAdvance()
+{
+    uint64_t current = global_.load(std::memory_order_seq_cst);
+    for(EpochRecord* record = records_.load(std::memory_order_acquire); record; record = record->next)
+    {
+        uint64_t state = record->state.load(std::memory_order_seq_cst);
+        if((state & 1) && (state >> 1) != current) return current;
+    }
+    // 失败说明其他线程已推进，current 被更新为最新值
+    if(global_.compare_exchange_strong(current, current + 1, std::memory_order_seq_cst))
+    {
+        return current + 1;
+    }
+    return current;
+}
+
+template<typename Policy>
+void BasicEpochDomain<Policy>::adopt(Chunk* chain)
+{
+    if(!chain) return;
+    Chunk* tail = chain;
+    while(tail->next) tail = tail->next;
+
+    std::lock_guard<std::mutex> lock(orphanMutex_);
+    tail->next = orphans_;
+    orphans_ = chain;
+    hasOrphans_.store(true, std::memory_order_relaxed);
+}
+
+template<typename Policy>
+typename BasicEpochDomain<Policy>::Chunk* BasicEpochDomain<Policy>::takeOrphans(uint64_t safeEpoch)
+{
+    std::lock_guard<std::mutex> lock(orphanMutex_);
+    Chunk* taken = nullptr;
+    Chunk** link = &orphans_;
+    while(Chunk* chunk = *link)
+    {
+        if(chunk->epoch <= safeEpoch)
+        {
+            *link = chunk->next;
+            chunk->next = taken;
+            taken = chunk;
+        }
+        else
+        {
+            link = &chunk->next;
+        }
+    }
+    hasOrphans_.store(orphans_ != nullptr, std::memory_order_relaxed);
+    return taken;
+}
+
+template<typename Policy>
+void BasicEpochDomain<Policy>::dropOrphans()
+{
+    std::lock_guard<std::mutex> lock(orphanMutex_);
+    orphans_ = nullptr;
+    hasOrphans_.store(false, std::memory_order_relaxed);
+}
+
+template<typename Policy>
+void BasicEpochDomain<Policy>::releaseRecords()
+{
+    for(EpochRecord* record = records_.load(std::memory_order_acquire); record; record = record->next)
+    {
+        releaseRecord(record);
+    }
+}
+
+static_assert(sizeof(LimboChunk<DefaultPolicy>) <= DefaultPolicy::PAGE_SIZE, "a limbo chunk must fit in one page");
+static_assert(sizeof(LimboChunk<TinyObjectPolicy>) <= TinyObjectPolicy::PAGE_SIZE, "a limbo chunk must fit in one page");
+
+template class BasicEpochDomain<DefaultPolicy>;
+template class BasicEpochDomain<TinyObjectPolicy>;
+
+}
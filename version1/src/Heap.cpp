@@ -0,0 +1,249 @@
+#include "../include/Heap.h"
+#include "../include/Epoch.h"
+#include "../include/ThreadCache.h"
+#include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace my_memorypool
+{
+
+namespace
+{
+
+uint64_t nextHeapId = 1;
+
+std::unordered_set<uint64_t>& liveHeaps()
+{
+    static std::unordered_set<uint64_t>* heaps = new std::unordered_set<uint64_t>;
+    return *heaps;
+}
+
+}
+
+std::mutex& HeapRegistry::mutex()
+{
+    static std::mutex* mutex = new std::mutex;
+    return *mutex;
+}
+
+uint64_t HeapRegistry::registerHeap()
+{
+    uint64_t id = nextHeapId++;
+    liveHeaps().insert(id);
+    return id;
+}
+
+void HeapRegistry::unregisterHeap(uint64_t id)
+{
+    liveHeaps().erase(id);
+}
+
+bool HeapRegistry::isAlive(uint64_t id)
+{
+    return liveHeaps().count(id) != 0;
+}
+
+template<typename Policy>
+BasicHeap<Policy>::BasicHeap()
+    : pageCache_(new PageCache)
+    , centralCache_(new CentralCache(*pageCache_))
+    , epochDomain_(new BasicEpochDomain<Policy>)
+{
+    std::lock_guard<std::mutex> lock(HeapRegistry::mutex());
+    id_.store(HeapRegistry::registerHeap(), std::memory_order_release);
+}
+
+template<typename Policy>
+BasicHeap<Policy>::~BasicHeap()
+{
+    std::lock_guard<std::mutex> lock(HeapRegistry::mutex());
+    HeapRegistry::unregisterHeap(id_.load(std::memory_order_relaxed));
+    // unique_ptr 析构时 PageCache 归还全部系统内存
+}
+
+template<typename Policy>
+BasicHeap<Policy>& BasicHeap<Policy>::getDefault()
+{
+    // 故意不析构：静态析构阶段其他线程或全局对象可能仍在使用默认堆
+    static BasicHeap* instance = new BasicHeap;
+    return *instance;
+}
+
+template<typename Policy>
+void* BasicHeap<Policy>::allocate(size_t size)
+{
+    return BasicThreadCache<Policy>::getInstance(*this)->allocate(size);
+}
+
+template<typename Policy>
+void* BasicHeap<Policy>::allocateZeroed(size_t size)
+{
+    return BasicThreadCache<Policy>::getInstance(*this)->allocateZeroed(size);
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::deallocate(void* ptr, size_t size)
+{
+    BasicThreadCache<Policy>::getInstance(*this)->deallocate(ptr, size);
+}
+
+template<typename Policy>
+bool BasicHeap<Policy>::enableRealtime(size_t budgetBytes)
+{
+    return pageCache_->enableRealtime(budgetBytes);
+}
+
+template<typename Policy>
+bool BasicHeap<Policy>::reserve(size_t size, size_t count)
+{
+    return BasicThreadCache<Policy>::getInstance(*this)->reserve(size, count);
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::setMemoryLimit(size_t softLimit, size_t hardLimit)
+{
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        softLimit_ = softLimit;
+        hardLimit_ = hardLimit;
+    }
+    pageCache_->setMemoryLimit(softLimit, hardLimit);
+}
+
+template<typename Policy>
+uint64_t BasicHeap<Policy>::addPressureCallback(PressureCallback callback)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    uint64_t id = nextCallbackId_++;
+    callbacks_.emplace_back(id, std::move(callback));
+    return id;
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::removePressureCallback(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    callbacks_.erase(std::remove_if(callbacks_.begin(), callbacks_.end(),
+                                    [id](const auto& entry) { return entry.first == id; }),
+                     callbacks_.end());
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::relievePressure(bool hard)
+{
+    // 其他线程在下次慢路径上清空自由链表；本堆能立即做的是把完全空闲的 span 交回 PageCache 并归还系统
+    trimEpoch_.fetch_add(1, std::memory_order_relaxed);
+    centralCache_->trim();
+    pageCache_->scavenge(SIZE_MAX);
+
+    // 回调在锁外执行：回调内释放内存可能再次进入本堆
+    std::vector<PressureCallback> callbacks;
+    MemoryPressure pressure;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        for (auto& entry : callbacks_) callbacks.push_back(entry.second);
+        pressure.softLimit = softLimit_;
+        pressure.hardLimit = hardLimit_;
+    }
+    pressure.hard = hard;
+    pressure.committedBytes = pageCache_->stats().committedBytes;
+    for (auto& callback : callbacks) callback(pressure);
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::enter()
+{
+    BasicThreadCache<Policy>::getInstance(*this)->enter();
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::exit()
+{
+    BasicThreadCache<Policy>::getInstance(*this)->exit();
+}
+
+template<typename Policy>
+bool BasicHeap<Policy>::retire(void* ptr, size_t size)
+{
+    return BasicThreadCache<Policy>::getInstance(*this)->retire(ptr, size);
+}
+
+template<typename Policy>
+size_t BasicHeap<Policy>::reclaim()
+{
+    return BasicThreadCache<Policy>::getInstance(*this)->reclaim();
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::trimThreadCache()
+{
+    BasicThreadCache<Policy>::getInstance(*this)->trim();
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::trimAll()
+{
+    trimEpoch_.fetch_add(1, std::memory_order_relaxed);
+    trimThreadCache();
+    centralCache_->trim();
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::destroy()
+{
+    if(this == &getDefault()) return;
+
+    std::lock_guard<std::mutex> lock(HeapRegistry::mutex());
+    HeapRegistry::unregisterHeap(id_.load(std::memory_order_relaxed));
+
+    centralCache_->reset();
+    pageCache_->releaseAll();
+    epochDomain_->dropOrphans();
+    epochDomain_->releaseRecords();
+
+    // 更换 id：各线程在旧 id 上的缓存作废，下次访问时新建，旧缓存在该线程为其他堆 id 建缓存时清理
+    id_.store(HeapRegistry::registerHeap(), std::memory_order_release);
+}
+
+template<typename Policy>
+size_t BasicHeap<Policy>::reservedBytes() const
+{
+    return pageCache_->systemBytes();
+}
+
+template<typename Policy>
+HeapStats BasicHeap<Policy>::stats() const
+{
+    auto pageStats = pageCache_->stats();
+    HeapStats result;
+    result.systemBytes = pageStats.systemBytes;
+    result.pageFreeBytes = pageStats.freeBytes;
+    result.pageReleasedBytes = pageStats.releasedBytes;
+    result.largeBytes = pageStats.largeBytes;
+    result.lockedBytes = pageStats.lockedBytes;
+    result.budgetFailures = pageStats.budgetFailures;
+    result.committedBytes = pageStats.committedBytes;
+    result.limitFailures = pageStats.limitFailures;
+    result.centralFreeBytes = centralCache_->freeBytes();
+    result.threadBytes = centralCache_->threadBytes();
+    return result;
+}
+
+template<typename Policy>
+std::vector<CentralClassStats> BasicHeap<Policy>::contentionStats() const
+{
+    return centralCache_->contentionStats();
+}
+
+template<typename Policy>
+void BasicHeap<Policy>::resetContentionStats()
+{
+    centralCache_->resetContentionStats();
+}
+
+template class BasicHeap<DefaultPolicy>;
+template class BasicHeap<TinyObjectPolicy>;
+
+}
@@ -0,0 +1,121 @@
+#include "../include/Options.h"
+#include <cstdlib>
+#include <cerrno>
+
+namespace my_memorypool
+{
+
+namespace
+{
+
+const char* const OPTION_ENV_NAMES[] = {
+    "MEMPOOL_RETURN_THRESHOLD",
+    "MEMPOOL_SMALL_BATCH",
+    "MEMPOOL_MEDIUM_BATCH",
+    "MEMPOOL_LARGE_BATCH",
+    "MEMPOOL_HUGE_BATCH",
+    "MEMPOOL_MAX_DELAY_COUNT",
+    "MEMPOOL_DELAY_INTERVAL_MS",
+    "MEMPOOL_SCAVENGE_RATE",
+    "MEMPOOL_LARGE_CUTOFF",
+    "MEMPOOL_IDLE_DECAY_MS",
+};
+static_assert(sizeof(OPTION_ENV_NAMES) / sizeof(OPTION_ENV_NAMES[0]) == static_cast<size_t>(Option::Count),
+              "every option needs an environment variable name");
+
+// 解析十进制非负整数，非法时返回 false
+bool parseSize(const char* text, size_t& value)
+{
+    if(!text || !*text) return false;
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if(errno != 0 || *end != '\0' || text[0] == '-') return false;
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+}
+
+const char* optionEnvName(Option option)
+{
+    return OPTION_ENV_NAMES[static_cast<size_t>(option)];
+}
+
+template<typename Policy>
+RuntimeOptions<Policy>::RuntimeOptions()
+{
+    reset();
+
+    // 环境变量非法时忽略，保留默认值
+    for(size_t i = 0; i < static_cast<size_t>(Option::Count); ++i)
+    {
+        size_t value = 0;
+        if(parseSize(getenv(OPTION_ENV_NAMES[i]), value))
+        {
+            set(static_cast<Option>(i), value);
+        }
+    }
+}
+
+template<typename Policy>
+void RuntimeOptions<Policy>::reset()
+{
+    auto store = [this](Option option, size_t value)
+    {
+        values_[static_cast<size_t>(option)].store(value, std::memory_order_relaxed);
+    };
+    store(Option::ReturnThreshold, Policy::RETURN_THRESHOLD);
+    store(Option::SmallBatch, Policy::SMALL_BATCH);
+    store(Option::MediumBatch, Policy::MEDIUM_BATCH);
+    store(Option::LargeBatch, Policy::LARGE_BATCH);
+    store(Option::HugeBatch, Policy::HUGE_BATCH);
+    store(Option::MaxDelayCount, Policy::MAX_DELAY_COUNT);
+    store(Option::DelayIntervalMs, Policy::DELAY_INTERVAL_MS);
+    store(Option::ScavengeRate, Policy::SCAVENGE_RATE);
+    store(Option::LargeObjectCutoff, Policy::MAX_BYTES);
+    store(Option::IdleDecayMs, Policy::IDLE_DECAY_MS);
+    // largeLookupFloor_ 只降不升：之前按页分配的对象仍可能在使用中
+    size_t floor = largeLookupFloor_.load(std::memory_order_relaxed);
+    if(floor == 0 || floor > Policy::MAX_BYTES)
+    {
+        largeLookupFloor_.store(Policy::MAX_BYTES, std::memory_order_relaxed);
+    }
+}
+
+template<typename Policy>
+bool RuntimeOptions<Policy>::set(Option option, size_t value)
+{
+    switch(option)
+    {
+    case Option::ReturnThreshold:
+    case Option::SmallBatch:
+    case Option::MediumBatch:
+    case Option::LargeBatch:
+    case Option::HugeBatch:
+        if(value == 0) return false;
+        break;
+    case Option::LargeObjectCutoff:
+        if(value < Policy::ALIGNMENT || value > Policy::MAX_BYTES) return false;
+        // 先降低 floor 再发布新 cutoff，保证释放路径总能识别按页分配的对象
+        if(value < largeLookupFloor_.load(std::memory_order_relaxed))
+        {
+            largeLookupFloor_.store(value, std::memory_order_seq_cst);
+        }
+        break;
+    case Option::MaxDelayCount:
+    case Option::DelayIntervalMs:
+    case Option::ScavengeRate:
+    case Option::IdleDecayMs:
+        break;
+    default:
+        return false;
+    }
+    values_[static_cast<size_t>(option)].store(value, std::memory_order_seq_cst);
+    return true;
+}
+
+template class RuntimeOptions<DefaultPolicy>;
+template class RuntimeOptions<TinyObjectPolicy>;
+
+}
@@ -5,14 +5,134 @@
 #include <sys/mman.h>
 #endif
 #include "PageCache.h"
+#include "Options.h"
+#include "SlowPathLog.h"
+#include <cassert>
 #include <cstring>
+#include <new>
+#include <set>
 
 namespace my_memorypool
 {
 
-void* PageCache::allocateSpan(size_t numPages)
+void* SpanMetaPool::allocate()
 {
+    ++usedSlots_;
+    if(freeList_)
+    {
+        void* slot = freeList_;
+        freeList_ = *static_cast<void**>(slot);
+        --freeSlots_;
+        return slot;
+    }
+    // 实时模式下池已按最坏情况备足，只有非实时模式会走到这里
+    return ::operator new(SLOT_BYTES);
+}
+
+void SpanMetaPool::deallocate(void* slot)
+{
+    --usedSlots_;
+    if(regions_.empty())
+    {
+        ::operator delete(slot);
+        return;
+    }
+    // 有预留区域后取自系统堆的槽也留在池中，释放时不再进入 free
+    *static_cast<void**>(slot) = freeList_;
+    freeList_ = slot;
+    ++freeSlots_;
+}
+
+void SpanMetaPool::addRegion(void* memory, size_t bytes)
+{
+    regions_.emplace_back(memory, bytes);
+    char* base = static_cast<char*>(memory);
+    for(size_t offset = 0; offset + SLOT_BYTES <= bytes; offset += SLOT_BYTES)
+    {
+        void* slot = base + offset;
+        *static_cast<void**>(slot) = freeList_;
+        freeList_ = slot;
+        ++freeSlots_;
+    }
+}
+
+bool SpanMetaPool::inRegion(void* slot) const
+{
+    for(const auto& [memory, bytes] : regions_)
+    {
+        if(slot >= memory && slot < static_cast<char*>(memory) + bytes) return true;
+    }
+    return false;
+}
+
+std::vector<std::pair<void*, size_t>> SpanMetaPool::release()
+{
+    while(freeList_)
+    {
+        void* slot = freeList_;
+        freeList_ = *static_cast<void**>(slot);
+        if(!inRegion(slot)) ::operator delete(slot);
+    }
+    freeSlots_ = 0;
+    std::vector<std::pair<void*, size_t>> regions;
+    regions.swap(regions_);
+    return regions;
+}
+
+template<typename Policy>
+BasicPageCache<Policy>::~BasicPageCache()
+{
+    releaseAll();
+}
+
+template<typename Policy>
+void* BasicPageCache<Policy>::allocateSpan(size_t numPages, bool* zeroed)
+{
+    SlowPathScope scope(SlowPathEvent::SpanAlloc, SlowPathEvent::NO_CLASS, numPages);
+    std::lock_guard<std::mutex> lock(mutex_);
+    scope.lockAcquired();
+    Span* span = allocateSpanLocked(numPages);
+    if(!span) return nullptr;
+    if(zeroed) *zeroed = span->zeroed;
+    return span->pageAddr;
+}
+
+template<typename Policy>
+void* BasicPageCache<Policy>::allocateLargeSpan(size_t numPages, bool* zeroed)
+{
+    SlowPathScope scope(SlowPathEvent::SpanAlloc, SlowPathEvent::NO_CLASS, numPages);
     std::lock_guard<std::mutex> lock(mutex_);
+    scope.lockAcquired();
+    Span* span = allocateSpanLocked(numPages);
+    if(!span) return nullptr;
+    span->large = true;
+    if(zeroed) *zeroed = span->zeroed;
+    return span->pageAddr;
+}
+
+template<typename Policy>
+typename BasicPageCache<Policy>::Span* BasicPageCache<Policy>::newSpan()
+{
+    return new (metaPool_.allocate()) Span;
+}
+
+template<typename Policy>
+void BasicPageCache<Policy>::deleteSpan(Span* span)
+{
+    span->~Span();
+    metaPool_.deallocate(span);
+}
+
+template<typename Policy>
+typename BasicPageCache<Policy>::Span* BasicPageCache<Policy>::allocateSpanLocked(size_t numPages)
+{
+    // 一次申请至多用到 3 个元数据槽（切分出的 Span 与两张表各一个节点）。实时模式下槽已按最坏情况备足，
+    // 仍不够时按预算耗尽处理，不进入 malloc
+    if(realtime_ && metaPool_.freeSlots() < 3)
+    {
+        ++budgetFailures_;
+        return nullptr;
+    }
 
     // 查找合适的空闲span
     // lower_bound函数返回第一个大于等于numPages的迭代器
@@ -34,10 +154,13 @@ void* PageCache::allocateSpan(size_t numPages)
         //如果span大于需要的numPages则进行分割
         if(span->numPages > numPages ) 
         {
-            Span* newSpan = new Span;
+            Span* newSpan = this->newSpan();
             newSpan->pageAddr = static_cast<char*>(span->pageAddr) + numPages * PAGE_SIZE;
             newSpan->numPages = span->numPages - numPages;
             newSpan->next = nullptr;
+            newSpan->released = span->released;
+            newSpan->zeroed = span->zeroed;
+            newSpan->freeEpoch = span->freeEpoch;
 
             //将超出部分放回Span*列表头部
             auto& list = freeSpans_[newSpan->numPages];
@@ -48,35 +171,82 @@ void* PageCache::allocateSpan(size_t numPages)
         }
 
         // 记录span信息用于回收
+        // 已归还系统的页再次访问时由内核重新提供零页，无需额外处理
+        // 切分出的剩余部分保持原状态，只有取走的部分不再计为已归还
+        if(span->released) releasedPages_ -= span->numPages;
+        span->released = false;
         spanMap_[span->pageAddr] = span;
-        return span->pageAddr;
+        return span;
+    }
+
+    // 实时模式下预算即上限，宁可失败也不进入内核
+    if(realtime_)
+    {
+        ++budgetFailures_;
+        return nullptr;
     }
+    if(!admitLocked(numPages)) return nullptr;
 
     // 没有合适的空闲span，想系统申请
     void* memory = systemAlloc(numPages);
     if(!memory) return nullptr;
 
     // 创建新的span
-    Span* span = new Span;
+    Span* span = newSpan();
     span->pageAddr = memory;
     span->numPages = numPages;
     span->next = nullptr;
+    span->zeroed = true; // 匿名映射的页由内核清零
 
     // 记录span信息用于回收
     spanMap_[memory] = span;
-    return memory;
+    return span;
 }
 
 //添加对前向空闲页的合并机制
-void PageCache::deallocateSpan(void* ptr, size_t numPages)
+template<typename Policy>
+void BasicPageCache<Policy>::deallocateSpan(void* ptr, size_t numPages)
 {
     std::lock_guard<std::mutex> lock(mutex_);
 
     // 查找对应的span，没找到代表不是PageCache分配的内存，直接返回
     auto it = spanMap_.find(ptr);
     if (it == spanMap_.end()) return;
+    // 调用方给出的页数只用于核对：span 分配时按需切分，页数必须与申请时一致
+    assert(it->second->numPages == numPages && "deallocateSpan: page count does not match the span");
+    (void)numPages;
 
-    Span* span = it->second;
+    it->second->zeroed = false;
+    deallocateSpanLocked(it->second);
+    maybeScavengeLocked();
+}
+
+template<typename Policy>
+bool BasicPageCache<Policy>::deallocateLargeSpan(void* ptr)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = spanMap_.find(ptr);
+    if (it == spanMap_.end() || !it->second->large) return false;
+
+    it->second->zeroed = false;
+    deallocateSpanLocked(it->second);
+    maybeScavengeLocked();
+    return true;
+}
+
+template<typename Policy>
+void BasicPageCache<Policy>::deallocateSpanLocked(Span* span)
+{
+    void* ptr = span->pageAddr;
+    span->large = false;
+    span->released = false;
+
+    // 合并后的 span 标记为驻留（部分页可能已归还），驻留字节数按偏大估计
+    auto absorb = [&](Span* neighbour)
+    {
+        if (neighbour->released) releasedPages_ -= neighbour->numPages;
+    };
 
     // 从空闲链表中移除指定span，成功返回true
     auto removeFromFreeList = [&](Span* target) -> bool
@@ -130,9 +300,12 @@ void PageCache::deallocateSpan(void* ptr, size_t numPages)
 
     if (prevSpan && removeFromFreeList(prevSpan))
     {
+        absorb(prevSpan);
         prevSpan->numPages += span->numPages;
+        prevSpan->released = false; // 合并后部分页仍驻留
+        prevSpan->zeroed = prevSpan->zeroed && span->zeroed;
         spanMap_.erase(ptr); // 当前span被并入前面的span，删除原映射
-        delete span;
+        deleteSpan(span);
         span = prevSpan;
         ptr = span->pageAddr;
     }
@@ -149,31 +322,305 @@ void PageCache::deallocateSpan(void* ptr, size_t numPages)
         if (removeFromFreeList(nextSpan))
         {
             // 合并span
+            absorb(nextSpan);
             span->numPages += nextSpan->numPages;
+            span->zeroed = span->zeroed && nextSpan->zeroed;
             spanMap_.erase(nextAddr);
-            delete nextSpan;
+            deleteSpan(nextSpan);
         }
     }
 
     // 将合并后的span通过头插法插入空闲列表
+    span->freeEpoch = scavengeEpoch_;
     auto& list = freeSpans_[span->numPages];
     span->next = list;
     list = span;
 }
 
+template<typename Policy>
+size_t BasicPageCache<Policy>::scavenge(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scavengeLocked(maxBytes, false);
+}
 
-void * PageCache::systemAlloc(size_t numPages)
+template<typename Policy>
+void BasicPageCache<Policy>::maybeScavengeLocked()
 {
+    size_t rate = RuntimeOptions<Policy>::instance().get(Option::ScavengeRate);
+    if (rate == 0) return;
+
+    // 每秒最多一轮，只归还在上一轮之前就已空闲的 span，避免反复 madvise 与缺页
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastScavenge_ < std::chrono::seconds(1)) return;
+    lastScavenge_ = now;
+
+    scavengeLocked(rate, true);
+    ++scavengeEpoch_;
+}
+
+template<typename Policy>
+size_t BasicPageCache<Policy>::scavengeLocked(size_t maxBytes, bool idleOnly)
+{
+    // 锁定的页不能归还，归还后再次访问还会缺页
+    if (realtime_) return 0;
+
+    size_t releasedBytes = 0;
+    // 从大 span 开始归还，单次 madvise 覆盖的页最多
+    for (auto it = freeSpans_.rbegin(); it != freeSpans_.rend() && releasedBytes < maxBytes; ++it)
+    {
+        for (Span* span = it->second; span && releasedBytes < maxBytes; span = span->next)
+        {
+            if (span->released) continue;
+            if (idleOnly && span->freeEpoch >= scavengeEpoch_) continue;
+
+            size_t bytes = span->numPages * PAGE_SIZE;
+#ifdef _WIN32
+            // MEM_RESET 不保证之后读到 0
+            VirtualAlloc(span->pageAddr, bytes, MEM_RESET, PAGE_READWRITE);
+#else
+            // 私有匿名映射的页再次访问时由内核提供零页
+            madvise(span->pageAddr, bytes, MADV_DONTNEED);
+            span->zeroed = true;
+#endif
+            span->released = true;
+            releasedPages_ += span->numPages;
+            releasedBytes += bytes;
+        }
+    }
+    return releasedBytes;
+}
+
+
+template<typename Policy>
+void BasicPageCache<Policy>::releaseAll()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 空闲span可能不在spanMap_中（切分出的剩余部分），去重后统一释放元数据
+    std::set<Span*> spans;
+    for (auto& kv : spanMap_) spans.insert(kv.second);
+    for (auto& kv : freeSpans_)
+    {
+        for (Span* span = kv.second; span; span = span->next) spans.insert(span);
+    }
+    for (Span* span : spans) deleteSpan(span);
+    spanMap_.clear();
+    freeSpans_.clear();
+    // 元数据槽已全部放回，预留区域随后解除映射
+    for (auto& [ptr, bytes] : metaPool_.release())
+    {
+        systemFree(ptr, bytes / PAGE_SIZE);
+    }
+
+    // 按原始申请区域整体归还，无需关心其中对象的状态
+    for (auto& [ptr, numPages] : systemRegions_)
+    {
+        systemFree(ptr, numPages);
+    }
+    systemRegions_.clear();
+    systemPages_ = 0;
+
+    // 锁定随 munmap 一并解除
+    realtime_ = false;
+    lockedRegions_ = 0;
+    lockedPages_ = 0;
+    budgetFailures_ = 0;
+    releasedPages_ = 0;
+    pressure_.store(false, std::memory_order_relaxed);
+}
+
+template<typename Policy>
+void BasicPageCache<Policy>::setMemoryLimit(size_t softLimit, size_t hardLimit)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    softLimit_ = softLimit;
+    hardLimit_ = hardLimit;
+}
+
+template<typename Policy>
+bool BasicPageCache<Policy>::admitLocked(size_t numPages)
+{
+    if (softLimit_ == 0 && hardLimit_ == 0) return true;
+
+    size_t bytes = numPages * PAGE_SIZE;
+    auto over = [&](size_t limit) { return limit != 0 && committedBytesLocked() + bytes > limit; };
+    // 足够大的空闲 span 已在前面找过，剩下的空闲 span 都太小，直接归还系统
+    if (over(softLimit_) || over(hardLimit_)) scavengeLocked(SIZE_MAX, false);
+    if (over(softLimit_)) pressure_.store(true, std::memory_order_release);
+    if (over(hardLimit_))
+    {
+        ++limitFailures_;
+        pressure_.store(true, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+template<typename Policy>
+bool BasicPageCache<Policy>::enableRealtime(size_t budgetBytes)
+{
+    // 预留整块预算也是一次 span 申请；外层事件保证其中 systemAlloc 的触发在解锁后才写出
+    SlowPathScope scope(SlowPathEvent::SpanAlloc, SlowPathEvent::NO_CLASS, (budgetBytes + PAGE_SIZE - 1) / PAGE_SIZE);
+    std::lock_guard<std::mutex> lock(mutex_);
+    scope.lockAcquired();
+
+    // 先锁定已有区域：其中的空闲 span 可能从未被访问过，或已被 scavenge 归还
+    for (; lockedRegions_ < systemRegions_.size(); ++lockedRegions_)
+    {
+        auto [ptr, numPages] = systemRegions_[lockedRegions_];
+        if (!lockRegion(ptr, numPages)) return false;
+        lockedPages_ += numPages;
+    }
+    // mlock 会重新调入已归还的页
+    for (auto& kv : freeSpans_)
+    {
+        for (Span* span = kv.second; span; span = span->next) span->released = false;
+    }
+    releasedPages_ = 0;
+
+    size_t numPages = (budgetBytes + PAGE_SIZE - 1) / PAGE_SIZE;
+    if (!reserveMetaLocked(systemPages_ + numPages)) return false;
+    if (numPages > 0)
+    {
+        void* memory = systemAlloc(numPages, true);
+        if (!memory) return false;
+        if (!lockRegion(memory, numPages))
+        {
+            systemRegions_.pop_back();
+            systemPages_ -= numPages;
+            systemFree(memory, numPages);
+            return false;
+        }
+        lockedRegions_ = systemRegions_.size();
+        lockedPages_ += numPages;
+
+        // 整块作为空闲 span 加入，与相邻的空闲 span 合并
+        Span* span = newSpan();
+        span->pageAddr = memory;
+        span->numPages = numPages;
+        span->next = nullptr;
+        span->zeroed = true;
+        spanMap_[memory] = span;
+        deallocateSpanLocked(span);
+    }
+
+    realtime_ = true;
+    return true;
+}
+
+
+template<typename Policy>
+bool BasicPageCache<Policy>::reserveMetaLocked(size_t totalPages)
+{
+    // 每页各成一个 span 时：Span 对象、spanMap_ 节点、freeSpans_ 节点各至多一个
+    size_t needed = 3 * totalPages + 3;
+    size_t have = metaPool_.freeSlots() + metaPool_.usedSlots();
+    if (have >= needed) return true;
+
+    size_t numPages = ((needed - have) * SpanMetaPool::SLOT_BYTES + PAGE_SIZE - 1) / PAGE_SIZE;
+    size_t bytes = numPages * PAGE_SIZE;
+    // 不计入 systemRegions_：元数据区域不参与 span 分配，由 releaseAll 单独解除映射
+#ifdef _WIN32
+    void* memory = VirtualAlloc(nullptr, bytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory) return false;
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (memory == MAP_FAILED) return false;
+#endif
+    if (!lockRegion(memory, numPages))
+    {
+        systemFree(memory, numPages);
+        return false;
+    }
+    metaPool_.addRegion(memory, bytes);
+    lockedPages_ += numPages;
+    return true;
+}
+
+template<typename Policy>
+size_t BasicPageCache<Policy>::systemBytes()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return systemPages_ * PAGE_SIZE;
+}
+
+template<typename Policy>
+typename BasicPageCache<Policy>::Stats BasicPageCache<Policy>::stats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats result;
+    result.systemBytes = systemPages_ * PAGE_SIZE;
+    result.lockedBytes = lockedPages_ * PAGE_SIZE;
+    result.budgetFailures = budgetFailures_;
+    result.committedBytes = committedBytesLocked();
+    result.limitFailures = limitFailures_;
+    for (auto& kv : freeSpans_)
+    {
+        for (Span* span = kv.second; span; span = span->next)
+        {
+            (span->released ? result.releasedBytes : result.freeBytes) += span->numPages * PAGE_SIZE;
+        }
+    }
+    for (auto& kv : spanMap_)
+    {
+        if (kv.second->large) result.largeBytes += kv.second->numPages * PAGE_SIZE;
+    }
+    return result;
+}
+
+template<typename Policy>
+void * BasicPageCache<Policy>::systemAlloc(size_t numPages, bool populate)
+{
+    SlowPathScope scope(SlowPathEvent::SystemAlloc, SlowPathEvent::NO_CLASS, numPages);
     size_t size = numPages * PAGE_SIZE;
 
 #ifdef _WIN32
+    // VirtualLock 时才真正缺页
+    (void)populate;
     void* ptr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if(!ptr) return nullptr;
 #else
-    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
-                    MAP_PRIVATE | MAP_ANONYMOUS, -1 , 0);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+    if(populate) flags |= MAP_POPULATE;
+#else
+    (void)populate; // 没有 MAP_POPULATE 的平台由 mlock 完成缺页
+#endif
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1 , 0);
     if(ptr == MAP_FAILED) return nullptr;
 #endif
+    systemRegions_.emplace_back(ptr, numPages);
+    systemPages_ += numPages;
     return ptr;
 }
 
+template<typename Policy>
+bool BasicPageCache<Policy>::lockRegion(void* ptr, size_t numPages)
+{
+#ifdef _WIN32
+    return VirtualLock(ptr, numPages * PAGE_SIZE) != 0;
+#else
+    return mlock(ptr, numPages * PAGE_SIZE) == 0;
+#endif
+}
+
+template<typename Policy>
+void BasicPageCache<Policy>::systemFree(void* ptr, size_t numPages)
+{
+#ifdef _WIN32
+    (void)numPages;
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, numPages * PAGE_SIZE);
+#endif
+}
+
+template class BasicPageCache<DefaultPolicy>;
+template class BasicPageCache<TinyObjectPolicy>;
+
 }//namespace my_memorypool
\ No newline at end of file
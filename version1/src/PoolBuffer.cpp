@@ -0,0 +1,618 @@
+#include "../include/PoolBuffer.h"
+#include <cstring>
+#include <new>
+
+namespace my_memorypool
+{
+
+// prepend 放不进首段时新建的段至少这么大，负载放在末尾，之后较短的头部可以原地写入
+static constexpr size_t PREPEND_SEGMENT_BYTES = 128;
+
+template<typename Policy>
+BasicPoolBuffer<Policy>::BasicPoolBuffer(BasicPoolBuffer&& other) noexcept
+    : heap_(other.heap_)
+    , chain_(other.chain_)
+    , offset_(other.offset_)
+    , size_(other.size_)
+{
+    other.chain_ = nullptr;
+    other.offset_ = other.size_ = 0;
+    other.readTail_ = nullptr;
+}
+
+template<typename Policy>
+BasicPoolBuffer<Policy>& BasicPoolBuffer<Policy>::operator=(BasicPoolBuffer&& other) noexcept
+{
+    if(this != &other)
+    {
+        clear();
+        heap_ = other.heap_;
+        chain_ = other.chain_;
+        offset_ = other.offset_;
+        size_ = other.size_;
+        other.chain_ = nullptr;
+        other.offset_ = other.size_ = 0;
+        other.readTail_ = nullptr;
+    }
+    return *this;
+}
+
+template<typename Policy>
+BasicPoolBuffer<Policy> BasicPoolBuffer<Policy>::create(size_t capacity, size_t headroom, Heap& heap)
+{
+    BasicPoolBuffer result(heap);
+    if(!result.own()) return result;
+    Storage* storage = newStorage(heap, headroom + capacity);
+    if(!storage) return result;
+    Segment* segment = newSegment(storage, storage->payload() + headroom, 0);
+    if(!segment)
+    {
+        releaseStorage(storage);
+        return result;
+    }
+    result.pushBack(segment);
+    return result;
+}
+
+template<typename Policy>
+BasicPoolBuffer<Policy> BasicPoolBuffer<Policy>::copyOf(const void* data, size_t len, Heap& heap)
+{
+    BasicPoolBuffer result(heap);
+    result.append(data, len);
+    return result;
+}
+
+template<typename Policy>
+size_t BasicPoolBuffer<Policy>::segmentCount() const
+{
+    if(!chain_) return 0;
+    if(offset_ == 0 && size_ == chain_->bytes) return chain_->count;
+
+    size_t count = 0;
+    size_t skip = offset_;
+    size_t left = size_;
+    for(Segment* segment = chain_->head; segment && left > 0; segment = segment->next)
+    {
+        if(skip >= segment->length)
+        {
+            skip -= segment->length;
+            continue;
+        }
+        left -= std::min(left, segment->length - skip);
+        skip = 0;
+        ++count;
+    }
+    return count;
+}
+
+template<typename Policy>
+bool BasicPoolBuffer<Policy>::append(const void* data, size_t len)
+{
+    if(!own()) return false;
+    const char* src = static_cast<const char*>(data);
+    Segment* tail = chain_->tail;
+    size_t room = (tail && writable(tail)) ? tailroom(tail) : 0;
+
+    // 先申请新段，失败时缓冲保持原状
+    Segment* extra = nullptr;
+    if(len > room)
+    {
+        Storage* storage = newStorage(*heap_, std::max(len - room, DEFAULT_SEGMENT_BYTES));
+        if(!storage) return false;
+        extra = newSegment(storage, storage->payload(), 0);
+        if(!extra)
+        {
+            releaseStorage(storage);
+            return false;
+        }
+    }
+
+    size_t inPlace = std::min(len, room);
+    if(inPlace > 0)
+    {
+        std::memcpy(tail->data + tail->length, src, inPlace);
+        tail->length += inPlace;
+        chain_->bytes += inPlace;
+        size_ += inPlace;
+    }
+    if(extra)
+    {
+        extra->length = len - inPlace;
+        std::memcpy(extra->data, src + inPlace, extra->length);
+        pushBack(extra);
+    }
+    return true;
+}
+
+template<typename Policy>
+bool BasicPoolBuffer<Policy>::prepend(const void* data, size_t len)
+{
+    if(!own()) return false;
+    Segment* head = chain_->head;
+    if(head && writable(head) && headroom(head) >= len)
+    {
+        head->data -= len;
+        head->length += len;
+        chain_->bytes += len;
+        size_ += len;
+        std::memcpy(head->data, data, len);
+        return true;
+    }
+
+    size_t capacity = std::max(len, PREPEND_SEGMENT_BYTES);
+    Storage* storage = newStorage(*heap_, capacity);
+    if(!storage) return false;
+    Segment* segment = newSegment(storage, storage->payload() + capacity - len, len);
+    if(!segment)
+    {
+        releaseStorage(storage);
+        return false;
+    }
+    std::memcpy(segment->data, data, len);
+    pushFront(segment);
+    return true;
+}
+
+template<typename Policy>
+bool BasicPoolBuffer<Policy>::append(BasicPoolBuffer&& other)
+{
+    if(&other == this || !other.chain_) return true;
+    if(!other.own()) return false;
+    if(!chain_)
+    {
+        // 本缓冲没有链：直接接管对方的链
+        chain_ = other.chain_;
+        offset_ = 0;
+        size_ = other.size_;
+        other.chain_ = nullptr;
+        other.size_ = 0;
+        other.readTail_ = nullptr;
+        return true;
+    }
+    if(!own()) return false;
+
+    Chain& from = *other.chain_;
+    if(from.head)
+    {
+        if(chain_->tail) chain_->tail->next = from.head;
+        else chain_->head = from.head;
+        chain_->tail = from.tail;
+        chain_->bytes += from.bytes;
+        chain_->count += from.count;
+        size_ += other.size_;
+        from.head = from.tail = nullptr;
+        from.bytes = from.count = 0;
+    }
+    other.clear();
+    return true;
+}
+
+template<typename Policy>
+bool BasicPoolBuffer<Policy>::prepend(BasicPoolBuffer&& other)
+{
+    if(&other == this || !other.chain_) return true;
+    if(!other.own()) return false;
+    if(!chain_)
+    {
+        chain_ = other.chain_;
+        offset_ = 0;
+        size_ = other.size_;
+        other.chain_ = nullptr;
+        other.size_ = 0;
+        other.readTail_ = nullptr;
+        return true;
+    }
+    if(!own()) return false;
+
+    Chain& from = *other.chain_;
+    if(from.head)
+    {
+        from.tail->next = chain_->head;
+        if(!chain_->tail) chain_->tail = from.tail;
+        chain_->head = from.head;
+        chain_->bytes += from.bytes;
+        chain_->count += from.count;
+        size_ += other.size_;
+        from.head = from.tail = nullptr;
+        from.bytes = from.count = 0;
+    }
+    other.clear();
+    return true;
+}
+
+template<typename Policy>
+BasicPoolBuffer<Policy> BasicPoolBuffer<Policy>::share() const
+{
+    return slice(0, size_);
+}
+
+template<typename Policy>
+BasicPoolBuffer<Policy> BasicPoolBuffer<Policy>::slice(size_t offset, size_t len) const
+{
+    BasicPoolBuffer result(*heap_);
+    if(offset >= size_ || len == 0) return result;
+    // 调用方持有引用，relaxed 即可；交给其他线程时由调用方负责同步
+    chain_->refs.fetch_add(1, std::memory_order_relaxed);
+    result.chain_ = chain_;
+    result.offset_ = offset_ + offset;
+    result.size_ = std::min(len, size_ - offset);
+    return result;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::trimFront(size_t n)
+{
+    if(n == 0) return;
+    if(n >= size_)
+    {
+        clear();
+        return;
+    }
+    if(exclusive())
+    {
+        own();
+        dropFront(*chain_, n);
+    }
+    else
+    {
+        offset_ += n;
+    }
+    size_ -= n;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::trimBack(size_t n)
+{
+    if(n == 0) return;
+    if(n >= size_)
+    {
+        clear();
+        return;
+    }
+    if(exclusive())
+    {
+        own();
+        dropBack(*chain_, n);
+    }
+    size_ -= n;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::clear()
+{
+    if(chain_) releaseChain(chain_);
+    chain_ = nullptr;
+    offset_ = size_ = 0;
+    readTail_ = nullptr;
+}
+
+template<typename Policy>
+size_t BasicPoolBuffer<Policy>::copyTo(void* dst, size_t offset, size_t len) const
+{
+    if(offset >= size_) return 0;
+    len = std::min(len, size_ - offset);
+    offset += offset_;
+
+    char* out = static_cast<char*>(dst);
+    size_t copied = 0;
+    for(Segment* segment = chain_->head; segment && copied < len; segment = segment->next)
+    {
+        if(offset >= segment->length)
+        {
+            offset -= segment->length;
+            continue;
+        }
+        size_t take = std::min(len - copied, segment->length - offset);
+        std::memcpy(out + copied, segment->data + offset, take);
+        copied += take;
+        offset = 0;
+    }
+    return copied;
+}
+
+template<typename Policy>
+size_t BasicPoolBuffer<Policy>::fillIovec(iovec* iov, size_t maxIov) const
+{
+    if(!chain_) return 0;
+    size_t n = 0;
+    size_t skip = offset_;
+    size_t left = size_;
+    for(Segment* segment = chain_->head; segment && left > 0 && n < maxIov; segment = segment->next)
+    {
+        if(skip >= segment->length)
+        {
+            skip -= segment->length;
+            continue;
+        }
+        size_t take = std::min(left, segment->length - skip);
+        iov[n].iov_base = segment->data + skip;
+        iov[n].iov_len = take;
+        ++n;
+        left -= take;
+        skip = 0;
+    }
+    return n;
+}
+
+template<typename Policy>
+size_t BasicPoolBuffer<Policy>::prepareRead(size_t bytes, iovec* iov, size_t maxIov)
+{
+    readTail_ = nullptr;
+    readIntoTail_ = false;
+    if(!own()) return 0;
+    Segment* tail = chain_->tail;
+    readTail_ = tail;
+    size_t n = 0;
+    size_t room = 0;
+    if(maxIov == 0) return 0;
+
+    if(tail && writable(tail) && tailroom(tail) > 0)
+    {
+        iov[n].iov_base = tail->data + tail->length;
+        iov[n].iov_len = tailroom(tail);
+        room += iov[n].iov_len;
+        ++n;
+        readIntoTail_ = true;
+    }
+    while(room < bytes && n < maxIov)
+    {
+        Storage* storage = newStorage(*heap_, DEFAULT_SEGMENT_BYTES);
+        if(!storage) break;
+        Segment* segment = newSegment(storage, storage->payload(), 0);
+        if(!segment)
+        {
+            releaseStorage(storage);
+            break;
+        }
+        pushBack(segment);
+        iov[n].iov_base = segment->data;
+        iov[n].iov_len = storage->capacity;
+        room += storage->capacity;
+        ++n;
+    }
+    return n;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::commitRead(size_t bytes)
+{
+    // prepareRead 没能取得独占的链时不会返回可写区域
+    if(!exclusive()) return;
+    Chain& chain = *chain_;
+    Segment* last = readTail_;
+    Segment* segment = readIntoTail_ ? readTail_ : (readTail_ ? readTail_->next : chain.head);
+    for(; segment && bytes > 0; segment = segment->next)
+    {
+        size_t take = std::min(bytes, tailroom(segment));
+        segment->length += take;
+        chain.bytes += take;
+        size_ += take;
+        bytes -= take;
+        last = segment;
+    }
+
+    // 没有读到数据的新段直接释放
+    Segment* rest = last ? last->next : chain.head;
+    if(last) last->next = nullptr;
+    else chain.head = nullptr;
+    chain.tail = last;
+    while(rest)
+    {
+        Segment* next = rest->next;
+        --chain.count;
+        freeSegment(rest);
+        rest = next;
+    }
+    readTail_ = nullptr;
+    readIntoTail_ = false;
+}
+
+template<typename Policy>
+bool BasicPoolBuffer<Policy>::own()
+{
+    if(!chain_)
+    {
+        chain_ = newChain(*heap_);
+        return chain_ != nullptr;
+    }
+    if(exclusive())
+    {
+        // 其他视图都已释放：把本视图之外的字节真正丢掉
+        dropFront(*chain_, offset_);
+        dropBack(*chain_, chain_->bytes - size_);
+        offset_ = 0;
+        return true;
+    }
+
+    // 被共享的链：只复制视图覆盖的段节点（存储引用计数 +1），不复制负载
+    Chain* copy = newChain(*heap_);
+    if(!copy) return false;
+    size_t skip = offset_;
+    size_t left = size_;
+    for(Segment* segment = chain_->head; segment && left > 0; segment = segment->next)
+    {
+        if(skip >= segment->length)
+        {
+            skip -= segment->length;
+            continue;
+        }
+        size_t take = std::min(left, segment->length - skip);
+        segment->storage->refs.fetch_add(1, std::memory_order_relaxed);
+        Segment* view = newSegment(segment->storage, segment->data + skip, take);
+        if(!view)
+        {
+            releaseStorage(segment->storage);
+            releaseChain(copy);
+            return false;
+        }
+        linkBack(*copy, view);
+        left -= take;
+        skip = 0;
+    }
+    releaseChain(chain_);
+    chain_ = copy;
+    offset_ = 0;
+    return true;
+}
+
+template<typename Policy>
+typename BasicPoolBuffer<Policy>::Storage* BasicPoolBuffer<Policy>::newStorage(Heap& heap, size_t capacity)
+{
+    void* memory = heap.allocate(sizeof(Storage) + capacity);
+    if(!memory) return nullptr;
+    Storage* storage = new(memory) Storage;
+    storage->refs.store(1, std::memory_order_relaxed);
+    storage->heap = &heap;
+    storage->capacity = capacity;
+    return storage;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::releaseStorage(Storage* storage)
+{
+    // 最后一个引用：负载可能刚被其他线程写过，acq_rel 保证释放前看到这些写入
+    if(storage->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        storage->heap->deallocate(storage, sizeof(Storage) + storage->capacity);
+    }
+}
+
+template<typename Policy>
+typename BasicPoolBuffer<Policy>::Segment* BasicPoolBuffer<Policy>::newSegment(Storage* storage, char* data, size_t length)
+{
+    void* memory = storage->heap->allocate(sizeof(Segment));
+    if(!memory) return nullptr;
+    return new(memory) Segment{storage, data, length, nullptr};
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::freeSegment(Segment* segment)
+{
+    Storage* storage = segment->storage;
+    storage->heap->deallocate(segment, sizeof(Segment));
+    releaseStorage(storage);
+}
+
+template<typename Policy>
+typename BasicPoolBuffer<Policy>::Chain* BasicPoolBuffer<Policy>::newChain(Heap& heap)
+{
+    void* memory = heap.allocate(sizeof(Chain));
+    if(!memory) return nullptr;
+    Chain* chain = new(memory) Chain;
+    chain->refs.store(1, std::memory_order_relaxed);
+    chain->heap = &heap;
+    chain->head = chain->tail = nullptr;
+    chain->bytes = chain->count = 0;
+    return chain;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::releaseChain(Chain* chain)
+{
+    // 与 releaseStorage 相同：最后一个引用释放前要看到其他视图对链的全部读取
+    if(chain->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    Segment* segment = chain->head;
+    while(segment)
+    {
+        Segment* next = segment->next;
+        freeSegment(segment);
+        segment = next;
+    }
+    chain->heap->deallocate(chain, sizeof(Chain));
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::linkBack(Chain& chain, Segment* segment)
+{
+    segment->next = nullptr;
+    if(chain.tail) chain.tail->next = segment;
+    else chain.head = segment;
+    chain.tail = segment;
+    chain.bytes += segment->length;
+    ++chain.count;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::linkFront(Chain& chain, Segment* segment)
+{
+    segment->next = chain.head;
+    chain.head = segment;
+    if(!chain.tail) chain.tail = segment;
+    chain.bytes += segment->length;
+    ++chain.count;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::dropFront(Chain& chain, size_t n)
+{
+    while(n > 0 && chain.head)
+    {
+        Segment* segment = chain.head;
+        if(segment->length > n)
+        {
+            segment->data += n;
+            segment->length -= n;
+            chain.bytes -= n;
+            return;
+        }
+        n -= segment->length;
+        chain.bytes -= segment->length;
+        chain.head = segment->next;
+        if(!chain.head) chain.tail = nullptr;
+        --chain.count;
+        freeSegment(segment);
+    }
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::dropBack(Chain& chain, size_t n)
+{
+    if(n == 0) return;
+    Segment* rest = chain.head;
+    if(n < chain.bytes)
+    {
+        size_t keep = chain.bytes - n;
+        Segment* last = chain.head;
+        while(last->length < keep)
+        {
+            keep -= last->length;
+            last = last->next;
+        }
+        last->length = keep;
+        rest = last->next;
+        last->next = nullptr;
+        chain.tail = last;
+    }
+    else
+    {
+        chain.head = chain.tail = nullptr;
+    }
+    chain.bytes -= std::min(n, chain.bytes);
+
+    while(rest)
+    {
+        Segment* next = rest->next;
+        --chain.count;
+        freeSegment(rest);
+        rest = next;
+    }
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::pushBack(Segment* segment)
+{
+    linkBack(*chain_, segment);
+    size_ += segment->length;
+}
+
+template<typename Policy>
+void BasicPoolBuffer<Policy>::pushFront(Segment* segment)
+{
+    linkFront(*chain_, segment);
+    size_ += segment->length;
+}
+
+template class BasicPoolBuffer<DefaultPolicy>;
+template class BasicPoolBuffer<TinyObjectPolicy>;
+
+}
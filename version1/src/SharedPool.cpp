@@ -0,0 +1,396 @@
+#include "../include/SharedPool.h"
+#if defined(__linux__)
+#include <cerrno>
+#include <csignal>
+#include <new>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace my_memorypool
+{
+
+namespace
+{
+constexpr uint64_t SHARED_MAGIC = 0x4d504f4f4c534852; // "MPOOLSHR"
+constexpr uint32_t OWNER_FREE = 0;
+constexpr uint32_t OWNER_IN_FLIGHT = 0xFFFFFFFFu;
+constexpr size_t SPAN_HEADER = 64;
+constexpr size_t REGION_ALIGN = 4096;
+
+// 空闲栈头 / 切分游标的打包格式：高 32 位为标签或 span 偏移，低 32 位为块偏移（8 字节为单位）或已用块数
+constexpr uint64_t LOW_MASK = 0xFFFFFFFFu;
+}
+
+// 区域头：位于 memfd 起始处，所有字段都以进程间共享的方式访问
+template<typename Policy>
+struct BasicSharedPool<Policy>::Region
+{
+    struct alignas(64) ClassState
+    {
+        std::atomic<uint64_t> freeHead; // (标签 << 32) | (块偏移 / 8)，0 表示空
+        std::atomic<uint64_t> bump;     // ((span 偏移 / 8) << 32) | 已切出块数，span 偏移为 0 表示还没有 span
+    };
+
+    struct ProcessSlot
+    {
+        std::atomic<int32_t> pid; // 0 表示空闲
+    };
+
+    uint64_t magic;
+    uint64_t regionBytes;
+    uint64_t dataStart;
+    // 只在切分 span 与回收时持有；持锁进程崩溃后由下一个加锁者恢复一致
+    pthread_mutex_t mutex;
+    std::atomic<uint64_t> nextSpan;
+    std::atomic<uint64_t> recovered;
+    ClassState classes[CLASS_COUNT];
+    ProcessSlot slots[MAX_PROCESSES];
+};
+
+// 块头：紧贴在句柄指向的负载之前
+struct SharedBlockHeader
+{
+    std::atomic<uint32_t> owner; // 进程槽 + 1；OWNER_FREE / OWNER_IN_FLIGHT
+    uint32_t classIndex;
+};
+
+template<typename Policy>
+std::unique_ptr<BasicSharedPool<Policy>> BasicSharedPool<Policy>::create(size_t regionBytes, const char* name)
+{
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int32_t>::is_always_lock_free,
+                  "process-shared atomics must be lock-free");
+    size_t dataStart = (sizeof(Region) + REGION_ALIGN - 1) & ~(REGION_ALIGN - 1);
+    // 块偏移以 8 字节为单位存入 32 位
+    if(regionBytes < dataStart + SPAN_BYTES || regionBytes > (uint64_t(1) << 35)) return nullptr;
+
+    int fd = memfd_create(name, MFD_CLOEXEC);
+    if(fd < 0) return nullptr;
+    if(ftruncate(fd, static_cast<off_t>(regionBytes)) != 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+    void* base = mmap(nullptr, regionBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(base == MAP_FAILED)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // ftruncate 得到的页全为 0：空闲栈、游标与进程表无需逐项初始化
+    Region* region = static_cast<Region*>(base);
+    region->regionBytes = regionBytes;
+    region->dataStart = dataStart;
+    region->nextSpan.store(dataStart, std::memory_order_relaxed);
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&region->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    std::atomic_thread_fence(std::memory_order_release);
+    region->magic = SHARED_MAGIC;
+
+    std::unique_ptr<BasicSharedPool> pool(new BasicSharedPool(fd, static_cast<char*>(base), regionBytes));
+    if(!pool->claimSlot()) return nullptr;
+    return pool;
+}
+
+template<typename Policy>
+std::unique_ptr<BasicSharedPool<Policy>> BasicSharedPool<Policy>::attach(int fd)
+{
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Region))
+    {
+        close(fd);
+        return nullptr;
+    }
+    size_t bytes = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(base == MAP_FAILED)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // 析构负责 munmap 与 close
+    std::unique_ptr<BasicSharedPool> pool(new BasicSharedPool(fd, static_cast<char*>(base), bytes));
+    Region* region = pool->region();
+    if(region->magic != SHARED_MAGIC || region->regionBytes != bytes) return nullptr;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(!pool->claimSlotOrRecover()) return nullptr;
+    return pool;
+}
+
+template<typename Policy>
+BasicSharedPool<Policy>::~BasicSharedPool()
+{
+    // fork 出的子进程若未调用 afterFork，槽位仍属于父进程，不能动
+    if(owner_ != 0 && pid_ == getpid())
+    {
+        bool dead[MAX_PROCESSES] = {};
+        dead[owner_ - 1] = true;
+        lock();
+        reclaimOwners(dead);
+        region()->slots[owner_ - 1].pid.store(0, std::memory_order_release);
+        unlock();
+    }
+    munmap(base_, bytes_);
+    close(fd_);
+}
+
+template<typename Policy>
+bool BasicSharedPool<Policy>::afterFork()
+{
+    if(pid_ == getpid()) return true;
+    return claimSlotOrRecover();
+}
+
+template<typename Policy>
+bool BasicSharedPool<Policy>::claimSlot()
+{
+    pid_t self = getpid();
+    for(size_t i = 0; i < MAX_PROCESSES; ++i)
+    {
+        int32_t expected = 0;
+        if(region()->slots[i].pid.compare_exchange_strong(expected, self, std::memory_order_acq_rel))
+        {
+            owner_ = static_cast<uint32_t>(i + 1);
+            pid_ = self;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename Policy>
+bool BasicSharedPool<Policy>::claimSlotOrRecover()
+{
+    if(claimSlot()) return true;
+    recover();
+    return claimSlot();
+}
+
+template<typename Policy>
+SharedHandle BasicSharedPool<Policy>::allocate(size_t size)
+{
+    if(size == 0) size = 1;
+    if(size > MAX_BLOCK - BLOCK_HEADER) return SharedHandle{};
+
+    size_t bytes = size + BLOCK_HEADER;
+    size_t index = bytes <= MIN_BLOCK ? 0 : 64 - __builtin_clzll(bytes - 1) - __builtin_ctzll(MIN_BLOCK);
+
+    uint64_t block = popFree(index);
+    if(!block) block = carveBlock(index);
+    if(!block) return SharedHandle{};
+
+    auto* header = reinterpret_cast<SharedBlockHeader*>(base_ + block);
+    header->classIndex = static_cast<uint32_t>(index);
+    header->owner.store(owner_, std::memory_order_release);
+    return SharedHandle{block + BLOCK_HEADER};
+}
+
+template<typename Policy>
+void BasicSharedPool<Policy>::deallocate(SharedHandle handle)
+{
+    if(!handle) return;
+    uint64_t block = handle.offset - BLOCK_HEADER;
+    auto* header = reinterpret_cast<SharedBlockHeader*>(base_ + block);
+    uint32_t previous = header->owner.exchange(OWNER_FREE, std::memory_order_acq_rel);
+    // 已经空闲：所有者已退出，块刚被并发的 recover() 放回空闲栈，不能再入栈一次
+    if(previous == OWNER_FREE) return;
+    pushFree(header->classIndex, block);
+}
+
+template<typename Policy>
+size_t BasicSharedPool<Policy>::usableSize(SharedHandle handle) const
+{
+    auto* header = reinterpret_cast<SharedBlockHeader*>(base_ + handle.offset - BLOCK_HEADER);
+    return (MIN_BLOCK << header->classIndex) - BLOCK_HEADER;
+}
+
+template<typename Policy>
+void BasicSharedPool<Policy>::release(SharedHandle handle)
+{
+    auto* header = reinterpret_cast<SharedBlockHeader*>(base_ + handle.offset - BLOCK_HEADER);
+    header->owner.store(OWNER_IN_FLIGHT, std::memory_order_release);
+}
+
+template<typename Policy>
+bool BasicSharedPool<Policy>::adopt(SharedHandle handle)
+{
+    auto* header = reinterpret_cast<SharedBlockHeader*>(base_ + handle.offset - BLOCK_HEADER);
+    uint32_t expected = OWNER_IN_FLIGHT;
+    return header->owner.compare_exchange_strong(expected, owner_, std::memory_order_acq_rel);
+}
+
+template<typename Policy>
+uint64_t BasicSharedPool<Policy>::popFree(size_t index)
+{
+    auto& freeHead = region()->classes[index].freeHead;
+    uint64_t head = freeHead.load(std::memory_order_acquire);
+    while(head & LOW_MASK)
+    {
+        uint64_t block = (head & LOW_MASK) * 8;
+        // 块可能同时被其他进程弹出并改写，读到的 next 作废时标签保证 CAS 失败
+        uint64_t next = reinterpret_cast<std::atomic<uint64_t>*>(base_ + block + BLOCK_HEADER)->load(std::memory_order_relaxed);
+        uint64_t desired = (((head >> 32) + 1) << 32) | (next & LOW_MASK);
+        if(freeHead.compare_exchange_weak(head, desired, std::memory_order_acquire, std::memory_order_acquire))
+        {
+            return block;
+        }
+    }
+    return 0;
+}
+
+template<typename Policy>
+void BasicSharedPool<Policy>::pushFree(size_t index, uint64_t block)
+{
+    auto& freeHead = region()->classes[index].freeHead;
+    auto* next = reinterpret_cast<std::atomic<uint64_t>*>(base_ + block + BLOCK_HEADER);
+    uint64_t head = freeHead.load(std::memory_order_relaxed);
+    uint64_t desired;
+    do
+    {
+        next->store(head & LOW_MASK, std::memory_order_relaxed);
+        desired = (((head >> 32) + 1) << 32) | (block / 8);
+    } while(!freeHead.compare_exchange_weak(head, desired, std::memory_order_release, std::memory_order_relaxed));
+}
+
+template<typename Policy>
+uint64_t BasicSharedPool<Policy>::carveBlock(size_t index)
+{
+    Region* r = region();
+    auto& bump = r->classes[index].bump;
+    size_t blockSize = MIN_BLOCK << index;
+    uint64_t perSpan = (SPAN_BYTES - SPAN_HEADER) / blockSize;
+
+    for(;;)
+    {
+        uint64_t current = bump.load(std::memory_order_acquire);
+        // 已用完的 span 不再 fetch_add，避免区域耗尽后计数持续增长
+        if((current >> 32) != 0 && (current & LOW_MASK) < perSpan)
+        {
+            current = bump.fetch_add(1, std::memory_order_acq_rel);
+            uint64_t used = current & LOW_MASK;
+            if(used < perSpan) return (current >> 32) * 8 + SPAN_HEADER + used * blockSize;
+        }
+
+        // 当前 span 用完：持锁切分新 span（其他进程可能已经换过）
+        lock();
+        if((bump.load(std::memory_order_relaxed) >> 32) == (current >> 32))
+        {
+            uint64_t span = r->nextSpan.load(std::memory_order_relaxed);
+            if(span + SPAN_BYTES > bytes_)
+            {
+                unlock();
+                return 0;
+            }
+            *reinterpret_cast<uint32_t*>(base_ + span) = static_cast<uint32_t>(index);
+            // 先推进 nextSpan 再发布游标：中途崩溃至多丢掉一个 span，不会有两个 size-class 共用
+            r->nextSpan.store(span + SPAN_BYTES, std::memory_order_release);
+            bump.store((span / 8) << 32, std::memory_order_release);
+        }
+        unlock();
+    }
+}
+
+template<typename Policy>
+size_t BasicSharedPool<Policy>::recover()
+{
+    Region* r = region();
+    bool dead[MAX_PROCESSES] = {};
+    bool any = false;
+    pid_t self = getpid();
+
+    lock();
+    for(size_t i = 0; i < MAX_PROCESSES; ++i)
+    {
+        pid_t pid = r->slots[i].pid.load(std::memory_order_acquire);
+        if(pid == 0 || pid == self) continue;
+        if(kill(pid, 0) == -1 && errno == ESRCH)
+        {
+            dead[i] = true;
+            any = true;
+        }
+    }
+
+    size_t freed = 0;
+    if(any)
+    {
+        freed = reclaimOwners(dead);
+        for(size_t i = 0; i < MAX_PROCESSES; ++i)
+        {
+            if(dead[i]) r->slots[i].pid.store(0, std::memory_order_release);
+        }
+    }
+    unlock();
+    return freed;
+}
+
+template<typename Policy>
+size_t BasicSharedPool<Policy>::reclaimOwners(const bool* dead)
+{
+    Region* r = region();
+    size_t freed = 0;
+    uint64_t end = r->nextSpan.load(std::memory_order_acquire);
+    for(uint64_t span = r->dataStart; span < end; span += SPAN_BYTES)
+    {
+        size_t index = *reinterpret_cast<uint32_t*>(base_ + span);
+        size_t blockSize = MIN_BLOCK << index;
+        uint64_t perSpan = (SPAN_BYTES - SPAN_HEADER) / blockSize;
+        for(uint64_t i = 0; i < perSpan; ++i)
+        {
+            uint64_t block = span + SPAN_HEADER + i * blockSize;
+            auto* header = reinterpret_cast<SharedBlockHeader*>(base_ + block);
+            // 尚未切出的块全为 0，交接中的块不属于任何进程
+            uint32_t owner = header->owner.load(std::memory_order_acquire);
+            if(owner == OWNER_FREE || owner == OWNER_IN_FLIGHT || !dead[owner - 1]) continue;
+            // 拿到句柄的其他进程可能正在 deallocate 同一块：只有 CAS 成功的一方归还，避免重复入链
+            if(!header->owner.compare_exchange_strong(owner, OWNER_FREE, std::memory_order_acq_rel)) continue;
+            pushFree(header->classIndex, block);
+            ++freed;
+        }
+    }
+    r->recovered.fetch_add(freed, std::memory_order_relaxed);
+    return freed;
+}
+
+template<typename Policy>
+void BasicSharedPool<Policy>::lock()
+{
+    // 上一个持锁进程崩溃：锁保护的只有 nextSpan / 游标 / 进程槽，均为单次原子写入，直接标记为一致
+    if(pthread_mutex_lock(&region()->mutex) == EOWNERDEAD)
+    {
+        pthread_mutex_consistent(&region()->mutex);
+    }
+}
+
+template<typename Policy>
+void BasicSharedPool<Policy>::unlock()
+{
+    pthread_mutex_unlock(&region()->mutex);
+}
+
+template<typename Policy>
+SharedPoolStats BasicSharedPool<Policy>::stats() const
+{
+    Region* r = region();
+    SharedPoolStats result;
+    result.regionBytes = bytes_;
+    result.carvedBytes = r->nextSpan.load(std::memory_order_relaxed) - r->dataStart;
+    for(size_t i = 0; i < MAX_PROCESSES; ++i)
+    {
+        if(r->slots[i].pid.load(std::memory_order_relaxed) != 0) ++result.processes;
+    }
+    result.recoveredBlocks = r->recovered.load(std::memory_order_relaxed);
+    return result;
+}
+
+template class BasicSharedPool<DefaultPolicy>;
+template class BasicSharedPool<TinyObjectPolicy>;
+
+}
+#endif
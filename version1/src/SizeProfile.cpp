@@ -0,0 +1,207 @@
+#include "../include/SizeProfile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+
+namespace my_memorypool
+{
+
+namespace
+{
+
+struct ProfileState
+{
+    std::mutex mutex;
+    std::atomic<std::atomic<uint64_t>*> counts{nullptr}; // BUCKETS 个计数，首次 start 时分配，之后不释放
+    std::atomic<uint64_t> requestedBytes{0};
+    std::atomic<uint64_t> largeCount{0};
+    std::atomic<uint64_t> largeBytes{0};
+    std::atomic<uint64_t> generation{0}; // 每次 start 递增，使线程缓冲中的旧样本失效
+};
+
+ProfileState& profileState()
+{
+    static ProfileState* state = new ProfileState;
+    return *state;
+}
+
+// 线程本地缓冲用 malloc 申请，只有真正统计过的线程才占用
+struct ThreadBuffer
+{
+    uint64_t generation;
+    uint32_t used;
+    uint32_t sizes[SizeProfile::BUFFER_SAMPLES];
+};
+
+thread_local ThreadBuffer* tlsBuffer = nullptr;
+
+void mergeBuffer(ThreadBuffer* buffer)
+{
+    ProfileState& state = profileState();
+    std::atomic<uint64_t>* counts = state.counts.load(std::memory_order_acquire);
+    if(counts && buffer->generation == state.generation.load(std::memory_order_acquire))
+    {
+        uint64_t requested = 0;
+        for(uint32_t i = 0; i < buffer->used; ++i)
+        {
+            size_t size = buffer->sizes[i];
+            size_t bucket = size == 0 ? 0 : (size - 1) / SizeProfile::GRANULE;
+            counts[bucket].fetch_add(1, std::memory_order_relaxed);
+            requested += size;
+        }
+        state.requestedBytes.fetch_add(requested, std::memory_order_relaxed);
+    }
+    buffer->used = 0;
+}
+
+// 线程退出时合并并释放缓冲；只在线程第一次统计时构造，不统计的线程没有析构开销
+struct ThreadFlusher
+{
+    ~ThreadFlusher()
+    {
+        if(tlsBuffer)
+        {
+            mergeBuffer(tlsBuffer);
+            free(tlsBuffer);
+            tlsBuffer = nullptr;
+        }
+    }
+};
+
+ThreadBuffer* attachBuffer()
+{
+    static thread_local ThreadFlusher flusher;
+    (void)flusher;
+    ThreadBuffer* buffer = static_cast<ThreadBuffer*>(malloc(sizeof(ThreadBuffer)));
+    if(!buffer) return nullptr;
+    buffer->generation = profileState().generation.load(std::memory_order_acquire);
+    buffer->used = 0;
+    tlsBuffer = buffer;
+    return buffer;
+}
+
+// 进程启动时根据环境变量开始统计，退出时写出
+std::string& autoDumpPath()
+{
+    static std::string* path = new std::string;
+    return *path;
+}
+
+struct ProfileAutoStart
+{
+    ProfileAutoStart()
+    {
+        if(const char* path = getenv("MEMPOOL_SIZE_PROFILE"))
+        {
+            if(*path == '\0' || !SizeProfile::start()) return;
+            autoDumpPath() = path;
+            std::atexit([] { SizeProfile::dump(autoDumpPath().c_str()); });
+        }
+    }
+} profileAutoStart;
+
+}
+
+std::atomic<bool> SizeProfile::enabled_{false};
+
+bool SizeProfile::start()
+{
+    ProfileState& state = profileState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    std::atomic<uint64_t>* counts = state.counts.load(std::memory_order_relaxed);
+    if(!counts)
+    {
+        counts = new (std::nothrow) std::atomic<uint64_t>[BUCKETS];
+        if(!counts) return false;
+    }
+    for(size_t i = 0; i < BUCKETS; ++i) counts[i].store(0, std::memory_order_relaxed);
+    state.requestedBytes.store(0, std::memory_order_relaxed);
+    state.largeCount.store(0, std::memory_order_relaxed);
+    state.largeBytes.store(0, std::memory_order_relaxed);
+    state.counts.store(counts, std::memory_order_release);
+    state.generation.fetch_add(1, std::memory_order_release);
+    enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+void SizeProfile::stop()
+{
+    enabled_.store(false, std::memory_order_release);
+}
+
+void SizeProfile::record(size_t size)
+{
+    ProfileState& state = profileState();
+    if(size > MAX_TRACKED)
+    {
+        state.largeCount.fetch_add(1, std::memory_order_relaxed);
+        state.largeBytes.fetch_add(size, std::memory_order_relaxed);
+        return;
+    }
+
+    ThreadBuffer* buffer = tlsBuffer;
+    if(!buffer)
+    {
+        buffer = attachBuffer();
+        if(!buffer) return;
+    }
+    uint64_t generation = state.generation.load(std::memory_order_acquire);
+    if(buffer->generation != generation)
+    {
+        buffer->generation = generation;
+        buffer->used = 0;
+    }
+    buffer->sizes[buffer->used++] = static_cast<uint32_t>(size);
+    if(buffer->used == BUFFER_SAMPLES) mergeBuffer(buffer);
+}
+
+void SizeProfile::flushThread()
+{
+    if(tlsBuffer) mergeBuffer(tlsBuffer);
+}
+
+SizeProfile::Snapshot SizeProfile::snapshot()
+{
+    ProfileState& state = profileState();
+    Snapshot snap;
+    std::atomic<uint64_t>* counts = state.counts.load(std::memory_order_acquire);
+    if(!counts) return snap;
+
+    for(size_t i = 0; i < BUCKETS; ++i)
+    {
+        uint64_t count = counts[i].load(std::memory_order_relaxed);
+        if(count == 0) continue;
+        snap.buckets.push_back(Bucket{(i + 1) * GRANULE, count});
+        snap.samples += count;
+    }
+    snap.requestedBytes = state.requestedBytes.load(std::memory_order_relaxed);
+    snap.largeCount = state.largeCount.load(std::memory_order_relaxed);
+    snap.largeBytes = state.largeBytes.load(std::memory_order_relaxed);
+    snap.samples += snap.largeCount;
+    return snap;
+}
+
+bool SizeProfile::dump(const char* path)
+{
+    flushThread();
+    Snapshot snap = snapshot();
+
+    FILE* file = fopen(path, "w");
+    if(!file) return false;
+    fprintf(file, "# my_memorypool size profile v1\n");
+    fprintf(file, "# granule %zu\n", GRANULE);
+    fprintf(file, "# samples %llu\n", static_cast<unsigned long long>(snap.samples));
+    fprintf(file, "# requested %llu\n", static_cast<unsigned long long>(snap.requestedBytes));
+    fprintf(file, "# large %llu %llu\n", static_cast<unsigned long long>(snap.largeCount),
+            static_cast<unsigned long long>(snap.largeBytes));
+    for(const Bucket& bucket : snap.buckets)
+    {
+        fprintf(file, "%zu %llu\n", bucket.bytes, static_cast<unsigned long long>(bucket.count));
+    }
+    return fclose(file) == 0;
+}
+
+}
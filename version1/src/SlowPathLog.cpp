@@ -0,0 +1,365 @@
+#include "../include/SlowPathLog.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace my_memorypool
+{
+
+namespace
+{
+
+// 槽位：seq 为 2 * 写入序号 + 2 时内容有效，写入期间为奇数；事件压成 4 个字以便用原子读写
+struct Slot
+{
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> words[4];
+};
+
+struct Ring
+{
+    std::atomic<uint64_t> head;   // 已写入的事件数，只增不减
+    std::atomic<uint32_t> thread; // 当前所有者编号
+    std::atomic<bool> inUse;
+    Ring* next;
+    Slot slots[SlowPathLog::RING_EVENTS];
+};
+
+std::atomic<Ring*> rings{nullptr};     // 所有缓冲，只追加
+std::atomic<uint32_t> nextThreadId{1};
+std::atomic<uint64_t> startTime{0};
+std::atomic<uint64_t> thresholdNs{0};
+std::atomic<int> triggerFd{-1};
+std::atomic<uint64_t> lastTrigger{0};
+std::atomic<uint64_t> triggers{0};
+
+thread_local Ring* tlsRing = nullptr;
+// 本线程 SlowPathScope 的嵌套深度，以及内层超过阈值、等最外层结束再写出的事件
+thread_local uint32_t tlsDepth = 0;
+thread_local bool tlsPending = false;
+thread_local SlowPathEvent tlsPendingEvent;
+
+// 线程退出时交还缓冲；只在线程第一次记录时构造
+struct RingReleaser
+{
+    ~RingReleaser()
+    {
+        if(tlsRing)
+        {
+            tlsRing->inUse.store(false, std::memory_order_release);
+            tlsRing = nullptr;
+        }
+    }
+};
+
+Ring* attachRing()
+{
+    static thread_local RingReleaser releaser;
+    (void)releaser;
+
+    uint32_t thread = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+    for(Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next)
+    {
+        bool expected = false;
+        if(!ring->inUse.load(std::memory_order_relaxed) &&
+           ring->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            ring->thread.store(thread, std::memory_order_relaxed);
+            tlsRing = ring;
+            return ring;
+        }
+    }
+
+    // calloc 得到的全 0 内存即为合法的初始状态（seq 为 0 的槽位无效）
+    Ring* ring = static_cast<Ring*>(calloc(1, sizeof(Ring)));
+    if(!ring) return nullptr;
+    ring->thread.store(thread, std::memory_order_relaxed);
+    ring->inUse.store(true, std::memory_order_relaxed);
+    Ring* head = rings.load(std::memory_order_relaxed);
+    do
+    {
+        ring->next = head;
+    } while(!rings.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+    tlsRing = ring;
+    return ring;
+}
+
+void unpack(const uint64_t* words, SlowPathEvent& event)
+{
+    uint64_t base = startTime.load(std::memory_order_relaxed);
+    event.timestamp = words[0] > base ? words[0] - base : 0;
+    event.duration = words[1];
+    event.wait = static_cast<uint32_t>(words[2]);
+    event.sizeClass = static_cast<uint32_t>(words[2] >> 32);
+    event.count = static_cast<uint32_t>(words[3]);
+    event.thread = static_cast<uint32_t>(words[3] >> 32) & 0xFFFFFF;
+    event.type = static_cast<SlowPathEvent::Type>(words[3] >> 56);
+}
+
+// 读取缓冲中最近的事件，跳过正在被覆盖的槽位
+template<typename Visitor>
+void readRing(const Ring* ring, Visitor&& visit)
+{
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t first = head > SlowPathLog::RING_EVENTS ? head - SlowPathLog::RING_EVENTS : 0;
+    for(uint64_t i = first; i < head; ++i)
+    {
+        const Slot& slot = ring->slots[i % SlowPathLog::RING_EVENTS];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if(seq != 2 * i + 2) continue;
+        uint64_t words[4];
+        for(int w = 0; w < 4; ++w) words[w] = slot.words[w].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot.seq.load(std::memory_order_relaxed) != seq) continue;
+        SlowPathEvent event;
+        unpack(words, event);
+        visit(event);
+    }
+}
+
+bool writeAll(int fd, const char* data, size_t length)
+{
+    while(length > 0)
+    {
+#ifdef _WIN32
+        int written = _write(fd, data, static_cast<unsigned>(length));
+#else
+        ssize_t written = write(fd, data, length);
+#endif
+        if(written <= 0) return false;
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// 格式化到栈上缓冲后直接 write，触发器在分配器内部调用，不能分配内存
+bool writeEvent(int fd, const SlowPathEvent& event)
+{
+    char line[160];
+    int length;
+    if(event.sizeClass == SlowPathEvent::NO_CLASS)
+    {
+        length = snprintf(line, sizeof(line), "%llu %u %s - %u %llu %u\n",
+                          static_cast<unsigned long long>(event.timestamp), event.thread,
+                          SlowPathEvent::typeName(event.type), event.count,
+                          static_cast<unsigned long long>(event.duration), event.wait);
+    }
+    else
+    {
+        length = snprintf(line, sizeof(line), "%llu %u %s %u %u %llu %u\n",
+                          static_cast<unsigned long long>(event.timestamp), event.thread,
+                          SlowPathEvent::typeName(event.type), event.sizeClass, event.count,
+                          static_cast<unsigned long long>(event.duration), event.wait);
+    }
+    return length > 0 && writeAll(fd, line, static_cast<size_t>(length));
+}
+
+const char HEADER[] = "# timestamp_ns thread type class count duration_ns wait_ns\n";
+
+void fireTrigger(const Ring* ring, const SlowPathEvent& slow)
+{
+    int fd = triggerFd.load(std::memory_order_relaxed);
+    if(fd < 0) return;
+
+    // 冷却期内只触发一次，避免同一次抖动刷出大量重复日志
+    uint64_t last = lastTrigger.load(std::memory_order_relaxed);
+    uint64_t current = SlowPathLog::now();
+    if(last != 0 && current - last < SlowPathLog::TRIGGER_COOLDOWN_MS * 1000000) return;
+    if(!lastTrigger.compare_exchange_strong(last, current, std::memory_order_relaxed)) return;
+    triggers.fetch_add(1, std::memory_order_relaxed);
+
+    char line[160];
+    int length = snprintf(line, sizeof(line), "# slow path trigger: %s took %llu ns (threshold %llu ns), thread %u history:\n",
+                          SlowPathEvent::typeName(slow.type), static_cast<unsigned long long>(slow.duration),
+                          static_cast<unsigned long long>(thresholdNs.load(std::memory_order_relaxed)), slow.thread);
+    if(length > 0) writeAll(fd, line, static_cast<size_t>(length));
+    writeAll(fd, HEADER, sizeof(HEADER) - 1);
+    readRing(ring, [fd](const SlowPathEvent& event) { writeEvent(fd, event); });
+}
+
+std::string& autoDumpPath()
+{
+    static std::string* path = new std::string;
+    return *path;
+}
+
+// 进程启动时根据环境变量开始记录
+struct SlowPathAutoStart
+{
+    SlowPathAutoStart()
+    {
+        const char* path = getenv("MEMPOOL_SLOW_PATH_LOG");
+        const char* threshold = getenv("MEMPOOL_SLOW_PATH_THRESHOLD_US");
+        if(path && *path)
+        {
+            SlowPathLog::start();
+            autoDumpPath() = path;
+            std::atexit([] { SlowPathLog::dump(autoDumpPath().c_str()); });
+        }
+        if(threshold && *threshold)
+        {
+            unsigned long long us = strtoull(threshold, nullptr, 10);
+            if(us == 0) return;
+            SlowPathLog::start();
+            SlowPathLog::setTrigger(us * 1000, 2);
+        }
+    }
+} slowPathAutoStart;
+
+}
+
+const char* SlowPathEvent::typeName(Type type)
+{
+    switch(type)
+    {
+    case CentralFetch: return "central_fetch";
+    case CentralReturn: return "central_return";
+    case SpanAlloc: return "span_alloc";
+    case SystemAlloc: return "system_alloc";
+    case DelayReturn: return "delay_return";
+    }
+    return "unknown";
+}
+
+std::atomic<bool> SlowPathLog::enabled_{false};
+
+void SlowPathLog::start()
+{
+    uint64_t expected = 0;
+    startTime.compare_exchange_strong(expected, now(), std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_release);
+}
+
+void SlowPathLog::stop()
+{
+    enabled_.store(false, std::memory_order_release);
+}
+
+void SlowPathLog::setTrigger(uint64_t threshold, int fd)
+{
+    if(threshold == 0 || fd < 0)
+    {
+        thresholdNs.store(0, std::memory_order_relaxed);
+        triggerFd.store(-1, std::memory_order_relaxed);
+        return;
+    }
+    triggerFd.store(fd, std::memory_order_relaxed);
+    thresholdNs.store(threshold, std::memory_order_release);
+}
+
+uint64_t SlowPathLog::triggerCount()
+{
+    return triggers.load(std::memory_order_relaxed);
+}
+
+void SlowPathLog::record(SlowPathEvent::Type type, uint32_t sizeClass, uint32_t count,
+                         uint64_t start, uint64_t end, uint64_t wait)
+{
+    Ring* ring = tlsRing;
+    if(!ring)
+    {
+        ring = attachRing();
+        if(!ring) return;
+    }
+
+    uint64_t duration = end > start ? end - start : 0;
+    uint64_t thread = ring->thread.load(std::memory_order_relaxed);
+    uint64_t words[4] = {
+        start,
+        duration,
+        std::min<uint64_t>(wait, 0xFFFFFFFF) | (static_cast<uint64_t>(sizeClass) << 32),
+        count | ((thread & 0xFFFFFF) << 32) | (static_cast<uint64_t>(type) << 56),
+    };
+
+    uint64_t index = ring->head.load(std::memory_order_relaxed);
+    Slot& slot = ring->slots[index % RING_EVENTS];
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for(int w = 0; w < 4; ++w) slot.words[w].store(words[w], std::memory_order_relaxed);
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+    ring->head.store(index + 1, std::memory_order_release);
+
+    uint64_t threshold = thresholdNs.load(std::memory_order_relaxed);
+    if(threshold != 0 && duration >= threshold)
+    {
+        SlowPathEvent event;
+        unpack(words, event);
+        // 内层慢路径结束时外层往往还持有锁（如 systemAlloc 在 PageCache 锁内），写文件会拖住其他线程：
+        // 只记下最慢的一次，由最外层 leave 写出
+        if(tlsDepth > 1)
+        {
+            if(!tlsPending || event.duration > tlsPendingEvent.duration) tlsPendingEvent = event;
+            tlsPending = true;
+            return;
+        }
+        // 最外层事件包含了内层的耗时，推迟的触发不再单独写出
+        tlsPending = false;
+        fireTrigger(ring, event);
+    }
+}
+
+uint64_t SlowPathLog::enter()
+{
+    ++tlsDepth;
+    return now();
+}
+
+void SlowPathLog::leave()
+{
+    if(tlsDepth > 0) --tlsDepth;
+    if(tlsDepth == 0 && tlsPending)
+    {
+        tlsPending = false;
+        if(tlsRing) fireTrigger(tlsRing, tlsPendingEvent);
+    }
+}
+
+std::vector<SlowPathEvent> SlowPathLog::snapshot()
+{
+    std::vector<SlowPathEvent> events;
+    for(const Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next)
+    {
+        readRing(ring, [&events](const SlowPathEvent& event) { events.push_back(event); });
+    }
+    std::sort(events.begin(), events.end(), [](const SlowPathEvent& a, const SlowPathEvent& b) {
+        return a.timestamp < b.timestamp;
+    });
+    return events;
+}
+
+bool SlowPathLog::dump(int fd)
+{
+    if(!writeAll(fd, HEADER, sizeof(HEADER) - 1)) return false;
+    for(const SlowPathEvent& event : snapshot())
+    {
+        if(!writeEvent(fd, event)) return false;
+    }
+    return true;
+}
+
+bool SlowPathLog::dump(const char* path)
+{
+#ifdef _WIN32
+    int fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC, 0644);
+#else
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if(fd < 0) return false;
+    bool ok = dump(fd);
+#ifdef _WIN32
+    return _close(fd) == 0 && ok;
+#else
+    return close(fd) == 0 && ok;
+#endif
+}
+
+}
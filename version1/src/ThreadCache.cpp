@@ -1,11 +1,191 @@
 #include "../include/ThreadCache.h"
 #include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include "../include/SlowPathLog.h"
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 namespace my_memorypool
 {
 
-void* ThreadCache::allocate(size_t size)
+// 清零：大块用非临时存储直接写内存，不把即将被覆盖的旧内容读进缓存，也不挤掉调用方的工作集
+template<typename Policy>
+static void zeroBytes(void* ptr, size_t bytes)
+{
+#if defined(__SSE2__) || defined(_M_X64)
+    if(bytes >= Policy::NONTEMPORAL_ZERO_BYTES)
+    {
+        char* p = static_cast<char*>(ptr);
+        size_t head = (16 - (reinterpret_cast<uintptr_t>(p) & 15)) & 15;
+        std::memset(p, 0, head);
+        p += head;
+        bytes -= head;
+        __m128i zero = _mm_setzero_si128();
+        char* end = p + (bytes & ~size_t(63));
+        for(; p < end; p += 64)
+        {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(p), zero);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(p + 16), zero);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(p + 32), zero);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(p + 48), zero);
+        }
+        // 非临时存储是弱序的，返回前保证对其他线程可见
+        _mm_sfence();
+        std::memset(p, 0, bytes & 63);
+        return;
+    }
+#endif
+    std::memset(ptr, 0, bytes);
+}
+
+// 非默认堆的线程缓存表：按堆 id 索引（destroy 后 id 更换，旧缓存随之作废），线程退出时统一归还
+template<typename Policy>
+struct ThreadHeapCaches
+{
+    using Cache = BasicThreadCache<Policy>;
+
+    std::unordered_map<uint64_t, std::unique_ptr<Cache>> caches;
+    // 最近一次取到的缓存：连续使用同一个堆时不查表（id 从 1 开始，0 不会命中）
+    uint64_t lastId = 0;
+    Cache* last = nullptr;
+
+    Cache* find(BasicHeap<Policy>& heap)
+    {
+        uint64_t id = heap.id();
+        if(id == lastId) return last;
+        auto it = caches.find(id);
+        if(it == caches.end())
+        {
+            // 只在为新的堆 id 建缓存时清理，表中的失效项不会多于两次创建之间作废的堆数
+            prune();
+            it = caches.emplace(id, std::unique_ptr<Cache>(new Cache(heap))).first;
+        }
+        lastId = id;
+        last = it->second.get();
+        return last;
+    }
+
+    // 丢弃已 destroy 或析构的堆的缓存：其自由链表与组所在的页已随 PageCache 整体归还，只剩缓存对象本身
+    void prune()
+    {
+        std::vector<std::unique_ptr<Cache>> dead;
+        {
+            std::lock_guard<std::mutex> lock(HeapRegistry::mutex());
+            for(auto it = caches.begin(); it != caches.end(); )
+            {
+                if(HeapRegistry::isAlive(it->first))
+                {
+                    ++it;
+                    continue;
+                }
+                dead.push_back(std::move(it->second));
+                it = caches.erase(it);
+            }
+        }
+        lastId = 0;
+        last = nullptr;
+        // dead 在锁外析构：析构函数会再取登记锁，确认堆已失效后不做归还
+    }
+};
+
+template<typename Policy>
+BasicThreadCache<Policy>* BasicThreadCache<Policy>::createInstance()
+{
+    static thread_local BasicThreadCache instance(Heap::getDefault());
+    current_ = &instance;
+    return &instance;
+}
+
+template<typename Policy>
+BasicThreadCache<Policy>* BasicThreadCache<Policy>::getInstance(Heap& heap)
+{
+    if(&heap == &Heap::getDefault()) return getInstance();
+
+    static thread_local ThreadHeapCaches<Policy> tlsCaches;
+    return tlsCaches.find(heap);
+}
+
+template<typename Policy>
+BasicThreadCache<Policy>::~BasicThreadCache()
+{
+    // 堆仍存活时才归还，持有登记锁防止与 destroy/析构并发
+    std::lock_guard<std::mutex> lock(HeapRegistry::mutex());
+    if(HeapRegistry::isAlive(heapId_))
+    {
+        flush();
+    }
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::discard()
+{
+    // 组所在的页与待回收页已随 PageCache::releaseAll 归还
+    groups_.fill(nullptr);
+    zeroRun_ = ZeroRun{};
+    limbo_.fill(nullptr);
+    spareChunk_ = nullptr;
+    limboCount_ = 0;
+    reclaimAt_ = Policy::RECLAIM_BATCH;
+#if ENABLE_TINY_SLABS
+    slabs_.discard();
+#endif
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::flush()
+{
+    // 先处理待回收块：已安全的块放回自由链表，随后一并归还
+    orphanLimbo();
+    trim();
+    for(FreeList* group : groups_)
+    {
+        if(group) heap_->pageCache().deallocateSpan(group, 1);
+    }
+#if ENABLE_TINY_SLABS
+    slabs_.flush(heap_->pageCache());
+#endif
+    discard();
+}
+
+template<typename Policy>
+typename BasicThreadCache<Policy>::FreeList* BasicThreadCache<Policy>::ensureList(size_t index)
+{
+    FreeList*& group = groups_[index / LISTS_PER_GROUP];
+    if(!group)
+    {
+        void* page = heap_->pageCache().allocateSpan(1);
+        if(!page && relievePressure(true)) page = heap_->pageCache().allocateSpan(1);
+        if(!page) return nullptr;
+        group = static_cast<FreeList*>(page);
+        std::uninitialized_value_construct_n(group, LISTS_PER_GROUP);
+    }
+    return group + index % LISTS_PER_GROUP;
+}
+
+template<typename Policy>
+template<typename Fn>
+void BasicThreadCache<Policy>::forEachList(Fn fn)
+{
+    for(size_t g = 0; g < GROUP_COUNT; ++g)
+    {
+        FreeList* group = groups_[g];
+        if(!group) continue;
+        size_t first = g * LISTS_PER_GROUP;
+        size_t count = std::min(LISTS_PER_GROUP, FREE_LIST_SIZE - first);
+        for(size_t i = 0; i < count; ++i) fn(first + i, group[i]);
+    }
+}
+
+template<typename Policy>
+void* BasicThreadCache<Policy>::allocateSlow(size_t size)
 {
     // 处理0大小的分配请求
     if(size == 0)
@@ -13,91 +193,446 @@ void* ThreadCache::allocate(size_t size)
         size = ALIGNMENT; // 至少分配一个对对齐大小
     }
 
-    if(size > MAX_BYTES)
+    if(size > options_->largeObjectCutoff())
     {
-        // 大对象直接从系统分配
-        return malloc(size);
+        return allocateLarge(size);
     }
 
     size_t index = SizeClass::getIndex(size);
 
+#if ENABLE_TINY_SLABS
+    if(TinySlabCache<Policy>::handles(index))
+    {
+        void* ptr = slabs_.allocate(index, heap_->pageCache());
+        if(!ptr && relievePressure(true)) ptr = slabs_.allocate(index, heap_->pageCache());
+        return ptr;
+    }
+#endif
+
     // 检查线程本地自由链表
-    // 如果 freeList_[index] 不为，表示该链表中有可用内存块
-    if(void* ptr = freeList_[index])
+    // 如果 list->head 不为空，表示该链表中有可用内存块
+    FreeList* list = listFor(index);
+    if(list && list->head)
     {
-        freeList_[index] = *reinterpret_cast<void**>(ptr); // 将freeList_[index]指向的内存块的下一个内存块地址（取决与内存块的实现）
+        void* ptr = list->head;
+        list->head = *reinterpret_cast<void**>(ptr); // 将链表头指向的内存块的下一个内存块地址（取决与内存块的实现）
         // 只有成功弹出时才减少计数
-        if (freeListSize_[index] > 0)
+        if (list->size > 0)
         {
-            freeListSize_[index]--;
+            list->size--;
         }
+        if (list->size < list->lowWater) list->lowWater = list->size;
         return ptr;
     }
 
+    // allocateZeroed 留下的已知为 0 的块同样可用，先于中心缓存取用
+    if(void* ptr = takeZeroRun(index)) return ptr;
+
     // 如果线程本地自由链表为空，则从中心缓存获取一批内存
     return fetchFromCentralCache(index, size);
 }
 
-void ThreadCache::deallocate(void* ptr, size_t size)
+template<typename Policy>
+void BasicThreadCache<Policy>::deallocateSlow(void* ptr, size_t size)
 {
     if(size > MAX_BYTES)
     {
-        free(ptr);
+        heap_->pageCache().deallocateSpan(ptr, (size + PAGE_SIZE - 1) / PAGE_SIZE);
+        return;
+    }
+    // cutoff 可在线调整：介于历史最小 cutoff 与 MAX_BYTES 之间的对象需确认是否按页分配
+    if(size > options_->largeLookupFloor() && heap_->pageCache().deallocateLargeSpan(ptr))
+    {
         return;
     }
 
     size_t index = SizeClass::getIndex(size);
 
+#if ENABLE_TINY_SLABS
+    if(TinySlabCache<Policy>::handles(index))
+    {
+        slabs_.deallocate(ptr, heap_->pageCache());
+        return;
+    }
+#endif
+
+    FreeList* list = listFor(index);
+    if(!list)
+    {
+        // 本线程从未用过该组（如释放其他线程分配的块）时才申请，申请失败则直接交回中心缓存
+        list = ensureList(index);
+        if(!list)
+        {
+            heap_->centralCache().returnRange(ptr, (index + 1) * ALIGNMENT, index);
+            return;
+        }
+    }
+
     // 插入到线程本地自由链表
-    *reinterpret_cast<void**>(ptr) = freeList_[index];
-    freeList_[index] = ptr;
+    *reinterpret_cast<void**>(ptr) = list->head;
+    list->head = ptr;
 
     // 更新对应自由链表的长度计数
-    freeListSize_[index]++;
+    list->size++;
 
     // 判断是否需要将部分内存回收给中心缓存
     if(shouldReturnToCentralCache(index))
     {
-        returnToCentralCache(freeList_[index], size);
+        returnToCentralCache(list->head, size);
+    }
+}
+
+template<typename Policy>
+void* BasicThreadCache<Policy>::allocateZeroed(size_t size)
+{
+    if(size > options_->largeObjectCutoff())
+    {
+        bool zeroed = false;
+        void* ptr = allocateLarge(size, &zeroed);
+        if(ptr && !zeroed) zeroBytes<Policy>(ptr, size);
+        return ptr;
+    }
+    if(size == 0) size = ALIGNMENT;
+    size_t index = SizeClass::getIndex(size);
+
+    // 自由链表中的块无从得知是否为 0（被使用过，且首字被链表指针占用），一律清零；
+    // 优先取用它们：回收来的块多半还在缓存中，清零比碰新页便宜
+    FreeList* list = listFor(index);
+    bool recycled = list && list->head;
+#if ENABLE_TINY_SLABS
+    recycled = recycled || TinySlabCache<Policy>::handles(index);
+#endif
+    if(recycled)
+    {
+        void* ptr = allocate(size);
+        if(ptr) zeroBytes<Policy>(ptr, size);
+        return ptr;
     }
+
+    // 刚从已知为 0 的 span 切出的块只有首字被写过
+    bool zeroed = true;
+    void* ptr = takeZeroRun(index);
+    if(!ptr) ptr = fetchFromCentralCache(index, size, &zeroed);
+    if(!ptr) return nullptr;
+    if(zeroed) *reinterpret_cast<void**>(ptr) = nullptr;
+    else zeroBytes<Policy>(ptr, size);
+    return ptr;
+}
+
+template<typename Policy>
+void* BasicThreadCache<Policy>::takeZeroRun(size_t index)
+{
+    if(!zeroRun_.head || zeroRun_.index != index) return nullptr;
+    void* ptr = zeroRun_.head;
+    zeroRun_.head = *reinterpret_cast<void**>(ptr);
+    --zeroRun_.count;
+    return ptr;
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::returnZeroRun()
+{
+    if(!zeroRun_.head) return;
+    size_t blockSize = (zeroRun_.index + 1) * ALIGNMENT;
+    heap_->centralCache().returnRange(zeroRun_.head, zeroRun_.count * blockSize, zeroRun_.index);
+    zeroRun_ = ZeroRun{};
+}
+
+template<typename Policy>
+void* BasicThreadCache<Policy>::allocateLarge(size_t size, bool* zeroed)
+{
+    // 大对象直接从所属堆的 PageCache 分配，destroy 时一并归还
+    size_t numPages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    void* ptr = heap_->pageCache().allocateLargeSpan(numPages, zeroed);
+    if(!ptr)
+    {
+        if(relievePressure(true)) ptr = heap_->pageCache().allocateLargeSpan(numPages, zeroed);
+    }
+    else
+    {
+        relievePressure(false);
+    }
+    return ptr;
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::trim()
+{
+    returnZeroRun();
+    forEachList([this](size_t index, FreeList& list)
+    {
+        if(list.head && list.size > 0)
+        {
+            size_t blockSize = (index + 1) * ALIGNMENT;
+            heap_->centralCache().returnRange(list.head, list.size * blockSize, index);
+        }
+        list = FreeList{};
+    });
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::maybeDecay()
+{
+    size_t interval = options_->get(Option::IdleDecayMs);
+    if(interval == 0) return;
+    auto now = std::chrono::steady_clock::now();
+    if(now - lastDecay_ < std::chrono::milliseconds(interval)) return;
+    lastDecay_ = now;
+
+    forEachList([this](size_t index, FreeList& list)
+    {
+        size_t unused = std::min(list.lowWater, list.size);
+        if(unused > 0) shrinkList(index, list.size - unused);
+        list.lowWater = list.size;
+    });
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::shrinkList(size_t index, size_t keepNum)
+{
+    FreeList& list = *listFor(index);
+    size_t total = list.size;
+    if(keepNum >= total) return;
+
+    void* release = list.head;
+    if(keepNum > 0)
+    {
+        void* last = list.head;
+        for(size_t i = 1; i < keepNum; ++i) last = *reinterpret_cast<void**>(last);
+        release = *reinterpret_cast<void**>(last);
+        *reinterpret_cast<void**>(last) = nullptr;
+    }
+    else
+    {
+        list.head = nullptr;
+    }
+    list.size = static_cast<uint32_t>(keepNum);
+    if(list.lowWater > keepNum) list.lowWater = list.size;
+
+    size_t blockSize = (index + 1) * ALIGNMENT;
+    heap_->centralCache().returnRange(release, (total - keepNum) * blockSize, index);
+}
+
+template<typename Policy>
+bool BasicThreadCache<Policy>::relievePressure(bool failed)
+{
+    if(relieving_ || !heap_->pageCache().takePressure()) return false;
+    relieving_ = true;
+    trim();
+    heap_->relievePressure(failed);
+    trimEpoch_ = heap_->trimEpoch();
+    relieving_ = false;
+    return true;
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::enter()
+{
+    if(epochNesting_++ > 0) return;
+    BasicEpochDomain<Policy>& domain = heap_->epochDomain();
+    if(!epochRecord_) epochRecord_ = domain.acquireRecord();
+    // 公布纪元先于临界区内的任何读取，与 tryAdvance 中对记录的读取配对
+    epochRecord_->state.store((domain.epoch() << 1) | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::exit()
+{
+    assert(epochNesting_ > 0);
+    if(--epochNesting_ == 0) epochRecord_->state.store(0, std::memory_order_release);
+}
+
+template<typename Policy>
+bool BasicThreadCache<Policy>::retire(void* ptr, size_t size)
+{
+    // 调用方从共享结构中摘下块先于读取纪元
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t epoch = heap_->epochDomain().epoch();
+
+    LimboChunk*& head = limbo_[epoch % 3];
+    if(head && head->epoch != epoch)
+    {
+        // 同余的旧纪元至少早三个纪元，链上的块已经没有读者
+        limboCount_ -= freeLimbo(head);
+        head = nullptr;
+    }
+    if(!head || head->count == LimboChunk::CAPACITY)
+    {
+        LimboChunk* chunk = spareChunk_;
+        spareChunk_ = nullptr;
+        if(!chunk)
+        {
+            void* page = heap_->pageCache().allocateSpan(1);
+            if(!page && relievePressure(true)) page = heap_->pageCache().allocateSpan(1);
+            if(!page) return false;
+            chunk = static_cast<LimboChunk*>(page);
+        }
+        chunk->next = head;
+        chunk->count = 0;
+        chunk->epoch = epoch;
+        head = chunk;
+    }
+    head->entries[head->count++] = {ptr, size};
+
+    if(++limboCount_ >= reclaimAt_) reclaim();
+    return true;
+}
+
+template<typename Policy>
+size_t BasicThreadCache<Policy>::reclaim()
+{
+    BasicEpochDomain<Policy>& domain = heap_->epochDomain();
+    uint64_t epoch = domain.tryAdvance();
+    for(LimboChunk*& head : limbo_)
+    {
+        if(head && head->epoch + 2 <= epoch)
+        {
+            limboCount_ -= freeLimbo(head);
+            head = nullptr;
+        }
+    }
+    if(domain.hasOrphans()) freeLimbo(domain.takeOrphans(epoch - 2));
+
+    // 有读者长期停留在临界区时纪元推进不了，再攒一批之后才重新扫描各线程的记录
+    reclaimAt_ = limboCount_ + Policy::RECLAIM_BATCH;
+    return limboCount_;
+}
+
+template<typename Policy>
+size_t BasicThreadCache<Policy>::freeLimbo(LimboChunk* chain)
+{
+    size_t freed = 0;
+    while(chain)
+    {
+        LimboChunk* next = chain->next;
+        for(size_t i = 0; i < chain->count; ++i)
+        {
+            deallocate(chain->entries[i].ptr, chain->entries[i].size);
+        }
+        freed += chain->count;
+        if(!spareChunk_) spareChunk_ = chain;
+        else heap_->pageCache().deallocateSpan(chain, 1);
+        chain = next;
+    }
+    return freed;
+}
+
+template<typename Policy>
+void BasicThreadCache<Policy>::orphanLimbo()
+{
+    BasicEpochDomain<Policy>& domain = heap_->epochDomain();
+    if(limboCount_ > 0) reclaim();
+    for(LimboChunk*& head : limbo_)
+    {
+        domain.adopt(head);
+        head = nullptr;
+    }
+    if(spareChunk_)
+    {
+        heap_->pageCache().deallocateSpan(spareChunk_, 1);
+        spareChunk_ = nullptr;
+    }
+    limboCount_ = 0;
+
+    if(epochRecord_)
+    {
+        domain.releaseRecord(epochRecord_);
+        epochRecord_ = nullptr;
+        epochNesting_ = 0;
+    }
+}
+
+template<typename Policy>
+bool BasicThreadCache<Policy>::reserve(size_t size, size_t count)
+{
+    // 借用块首字把取出的块串成链表，不额外申请内存
+    void* chain = nullptr;
+    size_t got = 0;
+    for(; got < count; ++got)
+    {
+        void* ptr = allocate(size);
+        if(!ptr) break;
+        *reinterpret_cast<void**>(ptr) = chain;
+        chain = ptr;
+    }
+    while(chain)
+    {
+        void* next = *reinterpret_cast<void**>(chain);
+        deallocate(chain, size);
+        chain = next;
+    }
+    return got == count;
 }
 
 // 判断是否需要将部分内存回收给中心缓存
-bool ThreadCache::shouldReturnToCentralCache(size_t index)
+template<typename Policy>
+bool BasicThreadCache<Policy>::shouldReturnToCentralCache(size_t index)
 {
     // 设定阈值
-    size_t threadcnt = 256;
-    return (freeListSize_[index] > threadcnt);
+    size_t threadcnt = options_->returnThreshold();
+    return (listFor(index)->size > threadcnt);
 }
 
-void* ThreadCache::fetchFromCentralCache(size_t index, size_t size)
+template<typename Policy>
+void* BasicThreadCache<Policy>::fetchFromCentralCache(size_t index, size_t size, bool* zeroed)
 {
     // 慢启动策略：
     // 如果需要的内存块较小，我们也不一次拿太多，避免浪费
-    // 随着 freeListSize_[index] 增长，或者根据 MaxLimit 动态调整
+    // 随着自由链表长度增长，或者根据 MaxLimit 动态调整
     // 简单起见，我们根据 size 大小决定一次拿多少
     // 比如：小对象(<=64B)一次拿 512 个，中对象(<=4KB)一次拿 64 个
     
     // 计算 ThreadCache 最大容量限制 (这里先硬编码简单逻辑)
+    SlowPathScope scope(SlowPathEvent::CentralFetch, index);
+
+    // 按所属 size-class 的块大小分档（使用 size-class 表时块可能远大于请求大小）
+    size = (index + 1) * ALIGNMENT;
     size_t batchNum = 1;
-    if (size <= 64) batchNum = 512;
-    else if (size <= 512) batchNum = 128;
-    else if (size <= 4096) batchNum = 32;
-    else batchNum = 4; // 大块少拿点
+    if (size <= Policy::SMALL_BATCH_BYTES) batchNum = options_->get(Option::SmallBatch);
+    else if (size <= Policy::MEDIUM_BATCH_BYTES) batchNum = options_->get(Option::MediumBatch);
+    else if (size <= Policy::LARGE_BATCH_BYTES) batchNum = options_->get(Option::LargeBatch);
+    else batchNum = options_->get(Option::HugeBatch); // 大块少拿点
+
+    // 其他线程遇到过内存压力或调用了 trimAll：先把本线程缓存的块全部交回
+    if(trimEpoch_ != heap_->trimEpoch())
+    {
+        trimEpoch_ = heap_->trimEpoch();
+        trim();
+    }
+    maybeDecay();
+
+    FreeList* list = ensureList(index);
+    if(!list) return nullptr;
 
     void* start = nullptr;
     void* end = nullptr;
     
-    // 从中心缓存批量获取内存
-    size_t actualNum = CentralCache::getInstance().fetchRange(start, end, batchNum, index);
-    if(actualNum == 0) return nullptr;
+    // 从中心缓存批量获取内存，因硬上限失败时裁剪后重试一次
+    bool freshZero = false;
+    bool* fresh = zeroed ? &freshZero : nullptr;
+    size_t actualNum = heap_->centralCache().fetchRange(start, end, batchNum, index, fresh);
+    if(actualNum == 0)
+    {
+        if(!relievePressure(true)) return nullptr;
+        actualNum = heap_->centralCache().fetchRange(start, end, batchNum, index, fresh);
+        if(actualNum == 0) return nullptr;
+    }
+    if(zeroed) *zeroed = freshZero;
+    scope.setCount(actualNum);
 
     assert(start != nullptr);
     assert(end != nullptr);
 
     // 取一个返回给 threadAlloc
     void* result = start;
-    if (actualNum == 1) {
+    if (freshZero) {
+        // 已知为 0 的其余块留给之后的 allocateZeroed，之前留下的另一批交回中心缓存
+        returnZeroRun();
+        zeroRun_.head = *reinterpret_cast<void**>(result);
+        zeroRun_.index = index;
+        zeroRun_.count = actualNum - 1;
+    } else if (actualNum == 1) {
         // 只有一个，没有剩余
     } else {
         // 将剩下的放入 freeList
@@ -105,30 +640,35 @@ void* ThreadCache::fetchFromCentralCache(size_t index, size_t size)
         // result 的 next 置空
         //*reinterpret_cast<void**>(result) = nullptr; // 实际上不需要，调用者会覆盖
         
-        // 将链表[remainStart ... end] 插入 freeList_ 头部
+        // 将链表[remainStart ... end] 插入自由链表头部
         if (remainStart) {
              // 找到 end (实际上 fetchRange 自带了 end 指针，它指向的是这批链表的最后一个节点)
-             // end 的 next 应该接到旧的 freeList_ 上
-             *reinterpret_cast<void**>(end) = freeList_[index];
-             freeList_[index] = remainStart;
+             // end 的 next 应该接到旧的链表头上
+             *reinterpret_cast<void**>(end) = list->head;
+             list->head = remainStart;
              
-             freeListSize_[index] += (actualNum - 1);
+             list->size += static_cast<uint32_t>(actualNum - 1);
         }
     }
 
+    // 本次申请越过了软上限：此时本线程缓存状态完整，可以安全地调用回调
+    relievePressure(false);
     return result;
 }
 
-void ThreadCache::returnToCentralCache(void* start, size_t size)
+template<typename Policy>
+void BasicThreadCache<Policy>::returnToCentralCache(void* start, size_t size)
 {
     // 根据大小计算对应的索引
     size_t index = SizeClass::getIndex(size);
+    SlowPathScope scope(SlowPathEvent::CentralReturn, index);
 
     // 获取对齐后的实际块大小
     size_t alignedSize = SizeClass::roundUp(size);
 
     //计算要归还的内存块数量
-    size_t batchNum = freeListSize_[index];
+    FreeList* list = listFor(index);
+    size_t batchNum = list->size;
     if(batchNum <= 1) return;
 
     // 保留一部分在ThreadCache中（比如保留1/4）
@@ -157,17 +697,24 @@ void ThreadCache::returnToCentralCache(void* start, size_t size)
         *reinterpret_cast<void**>(splitNode) = nullptr;
 
         // 更新ThreadCache的空闲链表
-        freeList_[index] = start;
+        list->head = start;
 
         // 更新自由链表大小
-        freeListSize_[index] = keepNum;
+        list->size = static_cast<uint32_t>(keepNum);
+        if(list->lowWater > keepNum) list->lowWater = list->size;
 
         // 将剩下部分返回给CentralCache
         if(returnNum > 0 && nextNode != nullptr)
         {
-            CentralCache::getInstance().returnRange(nextNode, returnNum * alignedSize, index);
+            heap_->centralCache().returnRange(nextNode, returnNum * alignedSize, index);
+            scope.setCount(returnNum);
         }
     }
+
+    maybeDecay();
 }
 
-}
\ No newline at end of file
+template class BasicThreadCache<DefaultPolicy>;
+template class BasicThreadCache<TinyObjectPolicy>;
+
+}
@@ -0,0 +1,164 @@
+#include "../include/TinySlab.h"
+#include "../include/PageCache.h"
+#include <new>
+
+namespace my_memorypool
+{
+
+template<typename Policy>
+typename TinySlabCache<Policy>::Slab* TinySlabCache<Policy>::newSlab(size_t index, PageCache& pageCache)
+{
+    void* page = pageCache.allocateSpan(Slab::SLAB_BYTES / Policy::PAGE_SIZE);
+    if(!page) return nullptr;
+
+    Slab* slab = new(page) Slab;
+    slab->owner.store(this, std::memory_order_relaxed);
+    slab->prev = nullptr;
+    slab->next = nullptr;
+    slab->index = static_cast<uint32_t>(index);
+    slab->blockSize = static_cast<uint32_t>((index + 1) * Policy::ALIGNMENT);
+    slab->capacity = static_cast<uint32_t>((Slab::SLAB_BYTES - Slab::headerBytes()) / slab->blockSize);
+    slab->localFree = slab->capacity;
+    slab->hint = 0;
+    slab->reciprocal = static_cast<uint32_t>(((uint64_t(1) << 32) + slab->blockSize - 1) / slab->blockSize);
+    slab->remoteMerged = 0;
+    slab->orphanTarget = 0;
+    slab->remoteCount.store(0, std::memory_order_relaxed);
+
+    size_t fullWords = slab->capacity / 64;
+    for(size_t w = 0; w < Slab::WORDS; ++w)
+    {
+        if(w < fullWords) slab->localBits[w] = ~uint64_t(0);
+        else if(w == fullWords && slab->capacity % 64) slab->localBits[w] = (uint64_t(1) << (slab->capacity % 64)) - 1;
+        else slab->localBits[w] = 0;
+        slab->remoteBits[w].store(0, std::memory_order_relaxed);
+    }
+    return slab;
+}
+
+template<typename Policy>
+void TinySlabCache<Policy>::remoteFree(Slab* slab, size_t word, uint64_t mask, PageCache& pageCache)
+{
+    slab->remoteBits[word].fetch_or(mask, std::memory_order_release);
+    uint64_t old = slab->remoteCount.fetch_add(1, std::memory_order_acq_rel);
+    if((old & Slab::ORPHANED) && (old & Slab::COUNT_MASK) + 1 == slab->orphanTarget)
+    {
+        pageCache.deallocateSpan(slab, Slab::SLAB_BYTES / Policy::PAGE_SIZE);
+    }
+}
+
+template<typename Policy>
+void TinySlabCache<Policy>::onStateChange(Slab* slab, PageCache& pageCache)
+{
+    size_t index = slab->index;
+    if(slab->localFree == 1)
+    {
+        unlink(full_[index], slab);
+        pushFront(partial_[index], slab);
+    }
+
+    // 完全空闲且不是唯一可用的 slab 时归还，每个 size-class 最多留一个空 slab
+    if(slab->localFree == slab->capacity && (slab->prev || slab->next) && remoteSettled(slab))
+    {
+        unlink(partial_[index], slab);
+        pageCache.deallocateSpan(slab, Slab::SLAB_BYTES / Policy::PAGE_SIZE);
+    }
+}
+
+template<typename Policy>
+typename TinySlabCache<Policy>::Slab* TinySlabCache<Policy>::refill(size_t index, PageCache& pageCache)
+{
+    for(Slab* slab = full_[index]; slab; slab = slab->next)
+    {
+        if((slab->remoteCount.load(std::memory_order_acquire) & Slab::COUNT_MASK) == slab->remoteMerged) continue;
+        mergeRemote(slab);
+        if(slab->localFree > 0)
+        {
+            unlink(full_[index], slab);
+            pushFront(partial_[index], slab);
+            return slab;
+        }
+    }
+
+    Slab* slab = newSlab(index, pageCache);
+    if(slab) pushFront(partial_[index], slab);
+    return slab;
+}
+
+template<typename Policy>
+void TinySlabCache<Policy>::mergeRemote(Slab* slab)
+{
+    for(size_t w = 0; w < Slab::WORDS; ++w)
+    {
+        if(slab->remoteBits[w].load(std::memory_order_relaxed) == 0) continue;
+        uint64_t bits = slab->remoteBits[w].exchange(0, std::memory_order_acquire);
+        slab->localBits[w] |= bits;
+        slab->localFree += static_cast<uint32_t>(popCount(bits));
+        slab->remoteMerged += popCount(bits);
+        if(bits && w < slab->hint) slab->hint = static_cast<uint32_t>(w);
+    }
+}
+
+template<typename Policy>
+bool TinySlabCache<Policy>::remoteSettled(Slab* slab)
+{
+    return (slab->remoteCount.load(std::memory_order_acquire) & Slab::COUNT_MASK) == slab->remoteMerged;
+}
+
+template<typename Policy>
+void TinySlabCache<Policy>::flush(PageCache& pageCache)
+{
+    for(size_t index = 0; index < CLASSES; ++index)
+    {
+        for(Slab* list : {partial_[index], full_[index]})
+        {
+            for(Slab* slab = list; slab; )
+            {
+                Slab* next = slab->next;
+                mergeRemote(slab);
+                // 先清除 owner：之后复用同一地址的新 ThreadCache 不会把它当作本地 slab
+                slab->owner.store(nullptr, std::memory_order_relaxed);
+                uint64_t outstanding = slab->capacity - slab->localFree;
+                slab->orphanTarget = slab->remoteMerged + outstanding;
+                uint64_t old = slab->remoteCount.fetch_or(Slab::ORPHANED, std::memory_order_acq_rel);
+                if((old & Slab::COUNT_MASK) == slab->orphanTarget)
+                {
+                    pageCache.deallocateSpan(slab, Slab::SLAB_BYTES / Policy::PAGE_SIZE);
+                }
+                slab = next;
+            }
+        }
+    }
+    discard();
+}
+
+template<typename Policy>
+void TinySlabCache<Policy>::discard()
+{
+    partial_.fill(nullptr);
+    full_.fill(nullptr);
+}
+
+template<typename Policy>
+void TinySlabCache<Policy>::unlink(Slab*& list, Slab* slab)
+{
+    if(slab->prev) slab->prev->next = slab->next;
+    else list = slab->next;
+    if(slab->next) slab->next->prev = slab->prev;
+    slab->prev = nullptr;
+    slab->next = nullptr;
+}
+
+template<typename Policy>
+void TinySlabCache<Policy>::pushFront(Slab*& list, Slab* slab)
+{
+    slab->prev = nullptr;
+    slab->next = list;
+    if(list) list->prev = slab;
+    list = slab;
+}
+
+template class TinySlabCache<DefaultPolicy>;
+template class TinySlabCache<TinyObjectPolicy>;
+
+}
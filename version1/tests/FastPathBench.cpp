@@ -0,0 +1,197 @@
+// 快路径微基准：只命中线程本地自由链表的 allocate / deallocate，按每次分配（含对应的释放）归一化
+//   pair   分配后立即释放，自由链表头反复弹出 / 压入同一块
+//   batch  连续分配 BATCH 个再全部释放，弹出时沿链表前进（下一个节点的预取在此生效）
+// 每组取 rounds 轮中最快的一轮；--counters 时附带 instructions / cycles（依赖 perf_event_open，不可用时仅计时）
+// 用法：fastpath_bench [--ops=N] [--rounds=N] [--sizes=16,64,256,1024] [--allocator=pool|malloc|both] [--counters]
+//                      [--format=text|csv|json]
+#include "../include/MemoryPool.h"
+#include "PerfCounters.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace my_memorypool;
+
+static constexpr size_t BATCH = 32;
+
+struct Result {
+    std::string allocator;
+    std::string pattern;
+    size_t size = 0;
+    double nsPerAlloc = 0;
+    double instructionsPerAlloc = -1; // < 0 表示没有计数
+    double cyclesPerAlloc = -1;
+};
+
+// 防止编译器把成对的分配 / 释放消除
+static inline void escape(void* ptr)
+{
+    asm volatile("" : : "r"(ptr) : "memory");
+}
+
+struct PoolAllocator {
+    static void* allocate(size_t size) { return MemoryPool::allocate(size); }
+    static void deallocate(void* ptr, size_t size) { MemoryPool::deallocate(ptr, size); }
+};
+
+struct MallocAllocator {
+    static void* allocate(size_t size) { return std::malloc(size); }
+    static void deallocate(void* ptr, size_t) { std::free(ptr); }
+};
+
+template<typename Alloc>
+static void runPair(size_t size, size_t ops)
+{
+    for(size_t i = 0; i < ops; ++i) {
+        void* ptr = Alloc::allocate(size);
+        escape(ptr);
+        Alloc::deallocate(ptr, size);
+    }
+}
+
+template<typename Alloc>
+static void runBatch(size_t size, size_t ops)
+{
+    void* ptrs[BATCH];
+    for(size_t done = 0; done < ops; done += BATCH) {
+        for(size_t j = 0; j < BATCH; ++j) {
+            ptrs[j] = Alloc::allocate(size);
+            escape(ptrs[j]);
+        }
+        for(size_t j = BATCH; j > 0; --j) Alloc::deallocate(ptrs[j - 1], size);
+    }
+}
+
+template<typename Alloc>
+static Result measure(const char* allocator, const char* pattern, size_t size, size_t ops, size_t rounds)
+{
+    bool batch = std::strcmp(pattern, "batch") == 0;
+    ops = (ops + BATCH - 1) / BATCH * BATCH;
+    // 预热：把块搬进线程本地自由链表，之后的轮次不再进入慢路径
+    if(batch) runBatch<Alloc>(size, BATCH * 4);
+    else runPair<Alloc>(size, 16);
+
+    Result result{allocator, pattern, size};
+    double best = 0;
+    bench::CounterSample bestCounters;
+    for(size_t r = 0; r < rounds; ++r) {
+        bench::CounterSample counters;
+        auto begin = std::chrono::steady_clock::now();
+        {
+            bench::CounterScope scope(counters);
+            if(batch) runBatch<Alloc>(size, ops);
+            else runPair<Alloc>(size, ops);
+        }
+        double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count());
+        if(r == 0 || ns < best) {
+            best = ns;
+            bestCounters = counters;
+        }
+    }
+    result.nsPerAlloc = best / ops;
+    if(bestCounters.has(bench::Counter::Instructions))
+        result.instructionsPerAlloc = bestCounters[bench::Counter::Instructions] / ops;
+    if(bestCounters.has(bench::Counter::Cycles))
+        result.cyclesPerAlloc = bestCounters[bench::Counter::Cycles] / ops;
+    return result;
+}
+
+static std::string counterText(double value)
+{
+    if(value < 0) return "-";
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << value;
+    return out.str();
+}
+
+static std::string counterJson(double value)
+{
+    return value < 0 ? "null" : counterText(value);
+}
+
+static void printResults(const std::vector<Result>& results, const std::string& format)
+{
+    if(format == "csv") {
+        std::cout << "allocator,pattern,size,ns_per_alloc,instructions_per_alloc,cycles_per_alloc\n";
+        for(const auto& r : results) {
+            std::cout << r.allocator << ',' << r.pattern << ',' << r.size << ',' << std::fixed << std::setprecision(2)
+                      << r.nsPerAlloc << ',' << (r.instructionsPerAlloc < 0 ? "" : counterText(r.instructionsPerAlloc))
+                      << ',' << (r.cyclesPerAlloc < 0 ? "" : counterText(r.cyclesPerAlloc)) << '\n';
+        }
+    } else if(format == "json") {
+        std::cout << "[\n";
+        for(size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            std::cout << "  {\"allocator\": \"" << r.allocator << "\", \"pattern\": \"" << r.pattern
+                      << "\", \"size\": " << r.size << std::fixed << std::setprecision(2)
+                      << ", \"ns_per_alloc\": " << r.nsPerAlloc
+                      << ", \"instructions_per_alloc\": " << counterJson(r.instructionsPerAlloc)
+                      << ", \"cycles_per_alloc\": " << counterJson(r.cyclesPerAlloc) << "}"
+                      << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "]\n";
+    } else {
+        std::cout << std::left << std::setw(8) << "alloc" << std::setw(8) << "pattern" << std::right
+                  << std::setw(8) << "size" << std::setw(12) << "ns/alloc" << std::setw(12) << "insn/alloc"
+                  << std::setw(12) << "cyc/alloc" << '\n';
+        for(const auto& r : results) {
+            std::cout << std::left << std::setw(8) << r.allocator << std::setw(8) << r.pattern << std::right
+                      << std::setw(8) << r.size << std::fixed << std::setprecision(2) << std::setw(12) << r.nsPerAlloc
+                      << std::setw(12) << counterText(r.instructionsPerAlloc)
+                      << std::setw(12) << counterText(r.cyclesPerAlloc) << '\n';
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t ops = 10000000;
+    size_t rounds = 5;
+    std::vector<size_t> sizes = {16, 64, 256, 1024};
+    std::string allocator = "both";
+    std::string format = "text";
+    bool counters = false;
+    for(int i = 1; i < argc; ++i) {
+        if(std::strncmp(argv[i], "--ops=", 6) == 0) ops = std::stoul(argv[i] + 6);
+        else if(std::strncmp(argv[i], "--rounds=", 9) == 0) rounds = std::stoul(argv[i] + 9);
+        else if(std::strncmp(argv[i], "--sizes=", 8) == 0) {
+            sizes.clear();
+            std::istringstream list(argv[i] + 8);
+            std::string item;
+            while(std::getline(list, item, ',')) if(!item.empty()) sizes.push_back(std::stoul(item));
+        }
+        else if(std::strncmp(argv[i], "--allocator=", 12) == 0) allocator = argv[i] + 12;
+        else if(std::strncmp(argv[i], "--format=", 9) == 0) format = argv[i] + 9;
+        else if(std::strcmp(argv[i], "--counters") == 0) counters = true;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--ops=N] [--rounds=N] [--sizes=16,64,256,1024]"
+                      << " [--allocator=pool|malloc|both] [--counters] [--format=text|csv|json]" << std::endl;
+            return 1;
+        }
+    }
+    if(ops == 0 || rounds == 0 || sizes.empty()) {
+        std::cerr << "ops, rounds and sizes must be non-empty" << std::endl;
+        return 1;
+    }
+
+    if(counters && !bench::PerfCounters::instance().open()) {
+        std::cerr << "Hardware counters unavailable (" << bench::PerfCounters::instance().error()
+                  << "), reporting time only" << std::endl;
+    }
+
+    std::vector<Result> results;
+    for(const char* pattern : {"pair", "batch"}) {
+        for(size_t size : sizes) {
+            if(allocator != "malloc") results.push_back(measure<PoolAllocator>("pool", pattern, size, ops, rounds));
+            if(allocator != "pool") results.push_back(measure<MallocAllocator>("malloc", pattern, size, ops, rounds));
+        }
+    }
+    printResults(results, format);
+    return 0;
+}
@@ -0,0 +1,319 @@
+// 碎片与 RSS 随时间变化基准：分阶段（增长 / 收缩 / 切换尺寸分布 / 长短生命周期混合）运行，
+// 定期采样 /proc/self/statm 的 RSS 与分配器自身各层统计，对比内存池与 glibc malloc
+// 用法：frag_bench [--allocator=pool|malloc|both] [--format=text|csv|json] [--samples=<file.csv>]
+#include "../include/MemoryPool.h"
+#include "ProcessStats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace my_memorypool;
+
+constexpr size_t MB = 1024 * 1024;
+
+// 分配器自身的视角：已向系统申请多少、其中多少是缓存/空闲
+struct AllocatorStats {
+    size_t reservedBytes = 0; // 内存池：systemBytes；malloc：arena + mmap
+    size_t cachedBytes = 0;   // 内存池：各层空闲；malloc：fordblks
+    size_t releasedBytes = 0; // 已归还系统物理页（内存池 MADV_DONTNEED 的空闲 span）
+};
+
+struct PoolAllocator {
+    static constexpr const char* NAME = "pool";
+    static void* allocate(size_t n) { return MemoryPool::allocate(n); }
+    static void deallocate(void* p, size_t n) { MemoryPool::deallocate(p, n); }
+    static AllocatorStats stats() {
+        HeapStats s = MemoryPool::stats();
+        // threadBytes 同时包含线程缓存中的空闲块与正在使用的对象，不计入 cached
+        return {s.systemBytes, s.pageFreeBytes + s.centralFreeBytes, s.pageReleasedBytes};
+    }
+};
+
+struct MallocAllocator {
+    static constexpr const char* NAME = "malloc";
+    static void* allocate(size_t n) { return std::malloc(n); }
+    static void deallocate(void* p, size_t) { std::free(p); }
+    static AllocatorStats stats() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        struct mallinfo2 mi = mallinfo2();
+        return {mi.arena + mi.hblkhd, mi.fordblks, 0};
+#else
+        return {};
+#endif
+    }
+};
+
+struct Sample {
+    double ms;
+    std::string phase;
+    size_t liveBytes;
+    size_t rssBytes;
+    AllocatorStats stats;
+};
+
+struct PhaseSummary {
+    std::string phase;
+    size_t liveBytes;
+    size_t rssBytes;       // 阶段结束时（扣除基线）
+    size_t peakRssBytes;   // 阶段内采样到的最大值（扣除基线）
+    double overhead;       // (RSS - live) / live
+    double returnedRatio;  // 收缩阶段：RSS 下降量 / 释放的字节数
+};
+
+template<typename Alloc>
+class FragmentationRun
+{
+public:
+    FragmentationRun() : gen_(12345), baselineRss_(bench::currentRssBytes()), start_(std::chrono::steady_clock::now()) {}
+
+    void run()
+    {
+        // 1. 小对象增长
+        beginPhase("grow-small");
+        std::uniform_int_distribution<size_t> small(2, 32);
+        while(liveBytes_ < 64 * MB) allocate(small(gen_) * 8, false);
+        endPhase();
+
+        // 2. 收缩：随机释放 90%
+        beginPhase("shrink-small");
+        freeFraction(0.9, false);
+        endPhase();
+
+        // 3. 尺寸分布切换：中等对象 + 少量大对象
+        beginPhase("grow-medium");
+        std::uniform_int_distribution<size_t> medium(64, 1024);
+        std::uniform_int_distribution<size_t> large(300 * 1024, 1024 * 1024);
+        std::uniform_int_distribution<int> percent(0, 99);
+        while(liveBytes_ < 128 * MB) allocate(percent(gen_) < 2 ? large(gen_) : medium(gen_) * 8, false);
+        endPhase();
+
+        // 4. 再次收缩：随机释放 80%
+        beginPhase("shrink-medium");
+        freeFraction(0.8, false);
+        endPhase();
+
+        // 5. 长短生命周期混合：剩余对象长期存活，短生命周期对象反复分配释放
+        beginPhase("churn");
+        for(auto& obj : objects_) obj.longLived = true;
+        std::uniform_int_distribution<size_t> mixed(1, 512);
+        for(int round = 0; round < 20; ++round) {
+            for(int i = 0; i < 20000; ++i) allocate(mixed(gen_) * 8, false);
+            freeFraction(1.0, true);
+        }
+        endPhase();
+
+        // 6. 全部释放：观察能归还多少
+        beginPhase("drain");
+        for(auto& obj : objects_) obj.longLived = false;
+        freeFraction(1.0, false);
+        endPhase();
+    }
+
+    const std::vector<Sample>& samples() const { return samples_; }
+    const std::vector<PhaseSummary>& summaries() const { return summaries_; }
+    size_t baselineRss() const { return baselineRss_; }
+
+private:
+    struct Object {
+        void* ptr;
+        size_t size;
+        bool longLived;
+    };
+
+    void allocate(size_t size, bool longLived)
+    {
+        void* ptr = Alloc::allocate(size);
+        std::memset(ptr, 0x3C, size); // 写满对象，使存活字节都真实驻留
+        objects_.push_back({ptr, size, longLived});
+        liveBytes_ += size;
+        tick();
+    }
+
+    // 随机释放 fraction 比例的对象；onlyShortLived 时只释放非长期对象
+    void freeFraction(double fraction, bool onlyShortLived)
+    {
+        std::shuffle(objects_.begin(), objects_.end(), gen_);
+        size_t candidates = 0;
+        for(const auto& obj : objects_) candidates += (!onlyShortLived || !obj.longLived);
+        size_t toFree = static_cast<size_t>(candidates * fraction);
+
+        std::vector<Object> kept;
+        kept.reserve(objects_.size() - toFree);
+        for(const auto& obj : objects_) {
+            if(toFree > 0 && (!onlyShortLived || !obj.longLived)) {
+                Alloc::deallocate(obj.ptr, obj.size);
+                liveBytes_ -= obj.size;
+                --toFree;
+                tick();
+            } else {
+                kept.push_back(obj);
+            }
+        }
+        objects_.swap(kept);
+    }
+
+    void tick()
+    {
+        if(++ops_ % 20000 == 0) sample();
+    }
+
+    void sample()
+    {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+        size_t rss = bench::currentRssBytes();
+        samples_.push_back({ms, phase_, liveBytes_, rss, Alloc::stats()});
+        phasePeakRss_ = std::max(phasePeakRss_, rss);
+    }
+
+    void beginPhase(const char* name)
+    {
+        phase_ = name;
+        phaseStartLive_ = liveBytes_;
+        phaseStartRss_ = bench::currentRssBytes();
+        phasePeakRss_ = phaseStartRss_;
+    }
+
+    void endPhase()
+    {
+        sample();
+        size_t rss = samples_.back().rssBytes;
+        auto aboveBaseline = [this](size_t bytes) { return bytes > baselineRss_ ? bytes - baselineRss_ : 0; };
+        PhaseSummary summary;
+        summary.phase = phase_;
+        summary.liveBytes = liveBytes_;
+        summary.rssBytes = aboveBaseline(rss);
+        summary.peakRssBytes = aboveBaseline(phasePeakRss_);
+        summary.overhead = liveBytes_ ? (static_cast<double>(summary.rssBytes) - liveBytes_) / liveBytes_ : 0.0;
+        summary.returnedRatio = 0.0;
+        if(phaseStartLive_ > liveBytes_) {
+            double freed = static_cast<double>(phaseStartLive_ - liveBytes_);
+            double dropped = phaseStartRss_ > rss ? static_cast<double>(phaseStartRss_ - rss) : 0.0;
+            summary.returnedRatio = dropped / freed;
+        }
+        summaries_.push_back(summary);
+    }
+
+    std::mt19937 gen_;
+    std::vector<Object> objects_;
+    size_t liveBytes_ = 0;
+    size_t ops_ = 0;
+    size_t baselineRss_;
+    std::chrono::steady_clock::time_point start_;
+    std::string phase_;
+    size_t phaseStartLive_ = 0;
+    size_t phaseStartRss_ = 0;
+    size_t phasePeakRss_ = 0;
+    std::vector<Sample> samples_;
+    std::vector<PhaseSummary> summaries_;
+};
+
+template<typename Alloc>
+void report(const FragmentationRun<Alloc>& run, const std::string& format, const std::string& samplesPath)
+{
+    const char* name = Alloc::NAME;
+    size_t peak = 0;
+    for(const auto& s : run.summaries()) peak = std::max(peak, s.peakRssBytes);
+
+    if(format == "csv") {
+        for(const auto& s : run.summaries()) {
+            std::cout << name << ',' << s.phase << ',' << s.liveBytes << ',' << s.rssBytes << ',' << s.peakRssBytes << ','
+                      << std::fixed << std::setprecision(3) << s.overhead << ',' << s.returnedRatio << '\n';
+        }
+    } else if(format == "json") {
+        std::cout << "{\"allocator\": \"" << name << "\", \"peak_rss_bytes\": " << peak << ", \"phases\": [";
+        for(size_t i = 0; i < run.summaries().size(); ++i) {
+            const auto& s = run.summaries()[i];
+            std::cout << (i ? ", " : "") << "{\"phase\": \"" << s.phase << "\", \"live_bytes\": " << s.liveBytes
+                      << ", \"rss_bytes\": " << s.rssBytes << ", \"peak_rss_bytes\": " << s.peakRssBytes
+                      << ", \"overhead\": " << std::fixed << std::setprecision(3) << s.overhead
+                      << ", \"returned_ratio\": " << s.returnedRatio << "}";
+        }
+        std::cout << "]}\n";
+    } else {
+        std::cout << "\n[" << name << "] peak RSS above baseline: " << peak / MB << " MB\n"
+                  << std::left << std::setw(15) << "  phase" << std::right << std::setw(10) << "live MB"
+                  << std::setw(10) << "RSS MB" << std::setw(10) << "peak MB" << std::setw(11) << "overhead"
+                  << std::setw(11) << "returned" << "\n";
+        for(const auto& s : run.summaries()) {
+            std::cout << "  " << std::left << std::setw(13) << s.phase << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(10) << s.liveBytes / double(MB) << std::setw(10) << s.rssBytes / double(MB)
+                      << std::setw(10) << s.peakRssBytes / double(MB)
+                      << std::setw(10) << s.overhead * 100 << '%';
+            if(s.returnedRatio > 0 || s.phase.compare(0, 6, "shrink") == 0 || s.phase == "drain") {
+                std::cout << std::setw(10) << s.returnedRatio * 100 << '%';
+            }
+            std::cout << "\n";
+        }
+    }
+
+    if(!samplesPath.empty()) {
+        std::ofstream out(samplesPath, std::ios::app);
+        for(const auto& s : run.samples()) {
+            out << name << ',' << std::fixed << std::setprecision(1) << s.ms << ',' << s.phase << ','
+                << s.liveBytes << ',' << s.rssBytes << ',' << s.stats.reservedBytes << ','
+                << s.stats.cachedBytes << ',' << s.stats.releasedBytes << '\n';
+        }
+    }
+}
+
+// 每个分配器在独立子进程中运行，RSS 互不干扰
+template<typename Alloc>
+void runIsolated(const std::string& format, const std::string& samplesPath)
+{
+    std::cout.flush();
+    pid_t pid = fork();
+    if(pid == 0) {
+        FragmentationRun<Alloc> run;
+        run.run();
+        report(run, format, samplesPath);
+        std::cout.flush();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << Alloc::NAME << " run failed" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string allocator = "both";
+    std::string format = "text";
+    std::string samplesPath;
+    for(int i = 1; i < argc; ++i) {
+        if(std::strncmp(argv[i], "--allocator=", 12) == 0) allocator = argv[i] + 12;
+        else if(std::strncmp(argv[i], "--format=", 9) == 0) format = argv[i] + 9;
+        else if(std::strncmp(argv[i], "--samples=", 10) == 0) samplesPath = argv[i] + 10;
+        else allocator.clear();
+    }
+    if(allocator != "pool" && allocator != "malloc" && allocator != "both") {
+        std::cerr << "usage: " << argv[0] << " [--allocator=pool|malloc|both] [--format=text|csv|json] [--samples=<file.csv>]" << std::endl;
+        return 1;
+    }
+
+    if(!samplesPath.empty()) {
+        std::ofstream out(samplesPath, std::ios::trunc);
+        out << "allocator,ms,phase,live_bytes,rss_bytes,reserved_bytes,cached_bytes,released_bytes\n";
+    }
+    if(format == "csv") {
+        std::cout << "allocator,phase,live_bytes,rss_bytes,peak_rss_bytes,overhead,returned_ratio\n";
+    } else if(format == "text") {
+        std::cout << "RSS is reported above the process baseline; overhead = (RSS - live) / live; "
+                     "returned = RSS drop / bytes freed in the phase." << std::endl;
+    }
+
+    if(allocator == "pool" || allocator == "both") runIsolated<PoolAllocator>(format, samplesPath);
+    if(allocator == "malloc" || allocator == "both") runIsolated<MallocAllocator>(format, samplesPath);
+    return 0;
+}
@@ -0,0 +1,130 @@
+#pragma once
+// 基准测试公用：低开销计时与 HDR 风格的延迟直方图
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace bench
+{
+
+// 计时源：x86 上使用 rdtsc（开机后校准为纳秒），其他平台退化为 steady_clock
+class TickClock
+{
+public:
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // 每纳秒的 tick 数
+    static double ticksPerNs()
+    {
+        static const double ratio = calibrate();
+        return ratio;
+    }
+
+    static uint64_t toNs(uint64_t ticks)
+    {
+        return static_cast<uint64_t>(ticks / ticksPerNs());
+    }
+
+private:
+    static double calibrate()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        auto wallStart = std::chrono::steady_clock::now();
+        uint64_t tickStart = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint64_t tickEnd = __rdtsc();
+        auto wallEnd = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(wallEnd - wallStart).count();
+        return ns > 0 ? (tickEnd - tickStart) / ns : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+};
+
+// 对数-线性分桶：每个 2 的幂区间再等分为 SUB_BUCKETS 份，相对误差约 1/SUB_BUCKETS
+// 记录与合并均为 O(1)，适合在测量循环中直接调用
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MAGNITUDES = 64 - SUB_BITS;
+
+    void record(uint64_t value)
+    {
+        ++counts_[bucketOf(value)];
+        ++total_;
+        sum_ += value;
+        max_ = std::max(max_, value);
+        min_ = std::min(min_, value);
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for(size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        sum_ += other.sum_;
+        max_ = std::max(max_, other.max_);
+        min_ = std::min(min_, other.min_);
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return total_ ? max_ : 0; }
+    uint64_t min() const { return total_ ? min_ : 0; }
+    double mean() const { return total_ ? static_cast<double>(sum_) / total_ : 0.0; }
+
+    // 返回分位点所在桶的上界（不超过实际最大值）
+    uint64_t percentile(double p) const
+    {
+        if(total_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * total_ + 0.5);
+        rank = std::max<uint64_t>(1, std::min(rank, total_));
+        uint64_t seen = 0;
+        for(size_t i = 0; i < counts_.size(); ++i)
+        {
+            seen += counts_[i];
+            if(seen >= rank) return std::min(upperBound(i), max_);
+        }
+        return max_;
+    }
+
+private:
+    static size_t bucketOf(uint64_t value)
+    {
+        if(value < SUB_BUCKETS) return static_cast<size_t>(value);
+        int magnitude = 63 - __builtin_clzll(value) - SUB_BITS + 1; // >= 1
+        size_t sub = static_cast<size_t>(value >> (magnitude - 1)) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>(magnitude) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t upperBound(size_t bucket)
+    {
+        size_t magnitude = bucket / SUB_BUCKETS;
+        size_t sub = bucket % SUB_BUCKETS;
+        if(magnitude == 0) return sub;
+        uint64_t width = 1ULL << (magnitude - 1);
+        return ((SUB_BUCKETS + sub) << (magnitude - 1)) + width - 1;
+    }
+
+    std::array<uint64_t, (MAGNITUDES + 1) * SUB_BUCKETS> counts_{};
+    uint64_t total_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t max_ = 0;
+    uint64_t min_ = UINT64_MAX;
+};
+
+}
@@ -0,0 +1,187 @@
+#pragma once
+// 基准测试公用：基于 perf_event_open 的硬件计数器
+// 仅用户态计数（exclude_kernel），perf_event_paranoid<=2 时普通用户即可使用；
+// 容器或非 Linux 平台打不开的计数器记为不可用，测试照常运行
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench
+{
+
+enum class Counter
+{
+    Cycles,
+    Instructions,
+    L1dMisses,
+    LlcMisses,
+    DtlbMisses,
+    BranchMisses,
+    Count
+};
+
+constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::Count);
+
+inline const char* counterName(Counter counter)
+{
+    static const char* const NAMES[COUNTER_COUNT] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "branch_misses"
+    };
+    return NAMES[static_cast<size_t>(counter)];
+}
+
+// 一次采样（或两次采样之差）；valid 为 false 表示该计数器不可用
+struct CounterSample
+{
+    std::array<double, COUNTER_COUNT> values{};
+    std::array<bool, COUNTER_COUNT> valid{};
+
+    double operator[](Counter counter) const { return values[static_cast<size_t>(counter)]; }
+    bool has(Counter counter) const { return valid[static_cast<size_t>(counter)]; }
+
+    CounterSample operator-(const CounterSample& other) const
+    {
+        CounterSample diff;
+        for(size_t i = 0; i < COUNTER_COUNT; ++i) {
+            diff.valid[i] = valid[i] && other.valid[i];
+            diff.values[i] = diff.valid[i] ? values[i] - other.values[i] : 0.0;
+        }
+        return diff;
+    }
+};
+
+// 进程级计数器集合；open() 之前所有读取都返回不可用的空样本
+// 计数器带 inherit 标志，测量区间内创建并 join 的工作线程也计入
+class PerfCounters
+{
+public:
+    static PerfCounters& instance()
+    {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    // 打开全部计数器，返回是否至少有一个可用
+    bool open()
+    {
+        if(opened_) return available();
+        opened_ = true;
+#if defined(__linux__)
+        for(size_t i = 0; i < COUNTER_COUNT; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            configure(static_cast<Counter>(i), attr);
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            // 计数器多于硬件 PMU 槽位时会被分时复用，按 enabled / running 比例还原
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if(fds_[i] < 0 && error_.empty()) error_ = std::string("perf_event_open: ") + std::strerror(errno);
+        }
+#else
+        error_ = "perf_event_open is only available on Linux";
+#endif
+        return available();
+    }
+
+    bool enabled() const { return opened_; }
+
+    bool available() const
+    {
+        for(int fd : fds_) if(fd >= 0) return true;
+        return false;
+    }
+
+    // 第一个打开失败的原因，全部成功时为空
+    const std::string& error() const { return error_; }
+
+    CounterSample read() const
+    {
+        CounterSample sample;
+#if defined(__linux__)
+        for(size_t i = 0; i < COUNTER_COUNT; ++i) {
+            if(fds_[i] < 0) continue;
+            uint64_t data[3] = {0, 0, 0}; // value, time_enabled, time_running
+            if(::read(fds_[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) continue;
+            // 一直没被调度到 PMU 上（running == 0）的计数器无意义
+            if(data[2] == 0) continue;
+            sample.values[i] = static_cast<double>(data[0]) * data[1] / data[2];
+            sample.valid[i] = true;
+        }
+#endif
+        return sample;
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+private:
+    PerfCounters() { fds_.fill(-1); }
+
+    ~PerfCounters()
+    {
+#if defined(__linux__)
+        for(int fd : fds_) if(fd >= 0) close(fd);
+#endif
+    }
+
+#if defined(__linux__)
+    static void configure(Counter counter, perf_event_attr& attr)
+    {
+        auto cacheMiss = [&](uint64_t cache) {
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        attr.type = PERF_TYPE_HARDWARE;
+        switch(counter) {
+            case Counter::Cycles:       attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+            case Counter::Instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case Counter::L1dMisses:    cacheMiss(PERF_COUNT_HW_CACHE_L1D); break;
+            case Counter::LlcMisses:    attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+            case Counter::DtlbMisses:   cacheMiss(PERF_COUNT_HW_CACHE_DTLB); break;
+            case Counter::BranchMisses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+            default: break;
+        }
+    }
+#endif
+
+    bool opened_ = false;
+    std::array<int, COUNTER_COUNT> fds_;
+    std::string error_;
+};
+
+// RAII：作用域结束时把区间内的计数差写入 out；计数器未开启时不做任何系统调用
+class CounterScope
+{
+public:
+    explicit CounterScope(CounterSample& out)
+        : out_(out), active_(PerfCounters::instance().enabled())
+    {
+        if(active_) begin_ = PerfCounters::instance().read();
+    }
+
+    ~CounterScope()
+    {
+        if(active_) out_ = PerfCounters::instance().read() - begin_;
+    }
+
+    CounterScope(const CounterScope&) = delete;
+    CounterScope& operator=(const CounterScope&) = delete;
+
+private:
+    CounterSample& out_;
+    bool active_;
+    CounterSample begin_;
+};
+
+} // namespace bench
@@ -1,5 +1,10 @@
 #include "../include/MemoryPool.h"
+#include "LatencyHistogram.h"
+#include "PerfCounters.h"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <string>
 #include <vector>
 #include <chrono>
 #include <random>
@@ -71,15 +76,39 @@ public:
 struct BenchResult {
     double memPoolTime;
     double systemTime;
+    // 以下仅在 --counters 时有意义：两侧各自区间内的硬件计数，以及一次运行的分配次数
+    bench::CounterSample memPoolCounters{};
+    bench::CounterSample systemCounters{};
+    size_t allocs = 0;
+};
+
+// 多轮计数累加，最终按每次分配（allocate + deallocate）归一化
+struct CounterTotals {
+    bench::CounterSample memPool{};
+    bench::CounterSample system{};
+    size_t allocs = 0;
+
+    void add(const BenchResult& res)
+    {
+        for(size_t i = 0; i < bench::COUNTER_COUNT; ++i) {
+            memPool.values[i] += res.memPoolCounters.values[i];
+            system.values[i] += res.systemCounters.values[i];
+            // 任意一轮不可用即视为不可用
+            memPool.valid[i] = (allocs == 0 || memPool.valid[i]) && res.memPoolCounters.valid[i];
+            system.valid[i] = (allocs == 0 || system.valid[i]) && res.systemCounters.valid[i];
+        }
+        allocs += res.allocs;
+    }
 };
 
 template<typename Func>
-BenchResult runBench(Func testFunc, int iterations = 5) {
+BenchResult runBench(Func testFunc, int iterations = 5, CounterTotals* totals = nullptr) {
     BenchResult best = {1e9, 1e9};
     BenchResult worst = {0, 0};
     double sumMem = 0, sumSys = 0;
     for (int i = 0; i < iterations; ++i) {
         auto res = testFunc();
+        if(totals) totals->add(res);
         sumMem += res.memPoolTime;
         sumSys += res.systemTime;
         if (res.memPoolTime < best.memPoolTime) best = res;
@@ -91,6 +120,8 @@ BenchResult runBench(Func testFunc, int iterations = 5) {
 // 改造各测试函数，返回耗时数据供统计使用
 BenchResult testSmallAllocationWrapper() {
     double memTime, sysTime;
+    bench::CounterSample memCounters, sysCounters;
+    constexpr size_t TOTAL_ALLOCS = 50000;
     {
         constexpr size_t NUM_ALLOCS = 50000;
         const size_t SIZES[] = {8, 16, 32, 64, 128, 256};
@@ -99,6 +130,7 @@ BenchResult testSmallAllocationWrapper() {
         // 内存池
         {
             Timer t;
+            bench::CounterScope counters(memCounters);
             std::array<std::vector<std::pair<void*, size_t>>, NUM_SIZES> sizePtrs;
             for(auto& ptrs : sizePtrs) ptrs.reserve(NUM_ALLOCS / NUM_SIZES);
             for(size_t i = 0; i < NUM_ALLOCS; ++i) {
@@ -124,6 +156,7 @@ BenchResult testSmallAllocationWrapper() {
         // new/delete
         {
             Timer t;
+            bench::CounterScope counters(sysCounters);
             std::array<std::vector<std::pair<void*, size_t>>, NUM_SIZES> sizePtrs;
             for(auto& ptrs : sizePtrs) ptrs.reserve(NUM_ALLOCS / NUM_SIZES);
             for(size_t i = 0; i < NUM_ALLOCS; ++i) {
@@ -146,7 +179,7 @@ BenchResult testSmallAllocationWrapper() {
             sysTime = t.elapsed();
         }
     }
-    return {memTime, sysTime};
+    return {memTime, sysTime, memCounters, sysCounters, TOTAL_ALLOCS};
 }
 
 BenchResult testMultiThreadedWrapper() {
@@ -200,8 +233,12 @@ BenchResult testMultiThreadedWrapper() {
     };
 
     double memTime, sysTime;
+    bench::CounterSample memCounters, sysCounters;
+    // 每线程主循环分配 ALLOCS_PER_THREAD 次，另有每 1000 次一轮、每轮 50 次的压力分配
+    constexpr size_t TOTAL_ALLOCS = NUM_THREADS * (ALLOCS_PER_THREAD + (ALLOCS_PER_THREAD + 999) / 1000 * 50);
     {
         Timer t;
+        bench::CounterScope counters(memCounters);
         std::vector<std::thread> threads;
         for(size_t i = 0; i < NUM_THREADS; ++i)
             threads.emplace_back(threadFunc, true);
@@ -210,13 +247,14 @@ BenchResult testMultiThreadedWrapper() {
     }
     {
         Timer t;
+        bench::CounterScope counters(sysCounters);
         std::vector<std::thread> threads;
         for(size_t i = 0; i < NUM_THREADS; ++i)
             threads.emplace_back(threadFunc, false);
         for(auto& th : threads) th.join();
         sysTime = t.elapsed();
     }
-    return {memTime, sysTime};
+    return {memTime, sysTime, memCounters, sysCounters, TOTAL_ALLOCS};
 }
 
 BenchResult testMixedSizesWrapper() {
@@ -230,8 +268,10 @@ BenchResult testMixedSizesWrapper() {
     const size_t NUM_BUCKETS = NUM_SMALL + NUM_MEDIUM + NUM_LARGE;
 
     double memTime, sysTime;
+    bench::CounterSample memCounters, sysCounters;
     {
         Timer t;
+        bench::CounterScope counters(memCounters);
         std::array<std::vector<std::pair<void*, size_t>>, NUM_BUCKETS> sizePtrs;
         for(auto& ptrs : sizePtrs) ptrs.reserve(NUM_ALLOCS / NUM_BUCKETS);
         for(size_t i = 0; i < NUM_ALLOCS; ++i) {
@@ -267,6 +307,7 @@ BenchResult testMixedSizesWrapper() {
     }
     {
         Timer t;
+        bench::CounterScope counters(sysCounters);
         std::array<std::vector<std::pair<void*, size_t>>, NUM_BUCKETS> sizePtrs;
         for(auto& ptrs : sizePtrs) ptrs.reserve(NUM_ALLOCS / NUM_BUCKETS);
         for(size_t i = 0; i < NUM_ALLOCS; ++i) {
@@ -300,43 +341,216 @@ BenchResult testMixedSizesWrapper() {
                 delete[] static_cast<char*>(ptr);
         sysTime = t.elapsed();
     }
-    return {memTime, sysTime};
+    return {memTime, sysTime, memCounters, sysCounters, NUM_ALLOCS};
+}
+
+// ---------------- 延迟分布模式（--latency） ----------------
+// 逐次记录每个 allocate / deallocate 的耗时，按分配器、操作、size 分别统计分位数，
+// 用于观察均值中看不到的尾延迟（如 CentralCache 填充、performDelayReturn 扫描）
+
+struct LatencyRecord {
+    std::string allocator;
+    std::string op;
+    size_t size;
+    bench::LatencyHistogram hist;
+};
+
+template<typename AllocFunc, typename FreeFunc>
+void measureLatency(size_t size, AllocFunc allocFunc, FreeFunc freeFunc,
+                    bench::LatencyHistogram& allocHist, bench::LatencyHistogram& freeHist)
+{
+    constexpr size_t ROUNDS = 50;
+    constexpr size_t BATCH = 2000;
+    std::mt19937 gen(42);
+    std::vector<void*> ptrs;
+    ptrs.reserve(BATCH);
+
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < BATCH; ++i) {
+            uint64_t begin = bench::TickClock::now();
+            void* ptr = allocFunc(size);
+            uint64_t end = bench::TickClock::now();
+            allocHist.record(end - begin);
+            *static_cast<char*>(ptr) = 1; // 触碰内存，避免分配被优化
+            ptrs.push_back(ptr);
+        }
+        // 乱序释放，接近真实负载中对象生命周期交错的情况
+        std::shuffle(ptrs.begin(), ptrs.end(), gen);
+        for(void* ptr : ptrs) {
+            uint64_t begin = bench::TickClock::now();
+            freeFunc(ptr, size);
+            uint64_t end = bench::TickClock::now();
+            freeHist.record(end - begin);
+        }
+        ptrs.clear();
+    }
+}
+
+std::vector<LatencyRecord> runLatencyBench()
+{
+    const size_t SIZES[] = {8, 16, 32, 64, 128, 256, 512, 1024, 4096, 16384};
+    std::vector<LatencyRecord> records;
+
+    for(size_t size : SIZES) {
+        LatencyRecord poolAlloc{"MemoryPool", "allocate", size, {}};
+        LatencyRecord poolFree{"MemoryPool", "deallocate", size, {}};
+        measureLatency(size,
+            [](size_t n) { return MemoryPool::allocate(n); },
+            [](void* p, size_t n) { MemoryPool::deallocate(p, n); },
+            poolAlloc.hist, poolFree.hist);
+
+        LatencyRecord sysAlloc{"NewDelete", "allocate", size, {}};
+        LatencyRecord sysFree{"NewDelete", "deallocate", size, {}};
+        measureLatency(size,
+            [](size_t n) { return static_cast<void*>(new char[n]); },
+            [](void* p, size_t) { delete[] static_cast<char*>(p); },
+            sysAlloc.hist, sysFree.hist);
+
+        records.push_back(std::move(poolAlloc));
+        records.push_back(std::move(poolFree));
+        records.push_back(std::move(sysAlloc));
+        records.push_back(std::move(sysFree));
+    }
+    return records;
+}
+
+void printLatency(const std::vector<LatencyRecord>& records, const std::string& format)
+{
+    auto ns = [](uint64_t ticks) { return bench::TickClock::toNs(ticks); };
+    if(format == "csv") {
+        std::cout << "allocator,op,size,count,mean_ns,p50_ns,p90_ns,p99_ns,p99_9_ns,max_ns\n";
+        for(const auto& r : records) {
+            std::cout << r.allocator << ',' << r.op << ',' << r.size << ',' << r.hist.count() << ','
+                      << std::fixed << std::setprecision(1) << r.hist.mean() / bench::TickClock::ticksPerNs() << ','
+                      << ns(r.hist.percentile(50)) << ',' << ns(r.hist.percentile(90)) << ','
+                      << ns(r.hist.percentile(99)) << ',' << ns(r.hist.percentile(99.9)) << ','
+                      << ns(r.hist.max()) << '\n';
+        }
+    } else if(format == "json") {
+        std::cout << "[\n";
+        for(size_t i = 0; i < records.size(); ++i) {
+            const auto& r = records[i];
+            std::cout << "  {\"allocator\": \"" << r.allocator << "\", \"op\": \"" << r.op
+                      << "\", \"size\": " << r.size << ", \"count\": " << r.hist.count()
+                      << ", \"mean_ns\": " << std::fixed << std::setprecision(1)
+                      << r.hist.mean() / bench::TickClock::ticksPerNs()
+                      << ", \"p50_ns\": " << ns(r.hist.percentile(50))
+                      << ", \"p90_ns\": " << ns(r.hist.percentile(90))
+                      << ", \"p99_ns\": " << ns(r.hist.percentile(99))
+                      << ", \"p99_9_ns\": " << ns(r.hist.percentile(99.9))
+                      << ", \"max_ns\": " << ns(r.hist.max()) << "}"
+                      << (i + 1 < records.size() ? "," : "") << "\n";
+        }
+        std::cout << "]\n";
+    } else {
+        std::cout << "\n[Per-operation latency (ns)]\n"
+                  << std::left << std::setw(12) << "allocator" << std::setw(12) << "op"
+                  << std::right << std::setw(7) << "size" << std::setw(8) << "p50" << std::setw(8) << "p99"
+                  << std::setw(9) << "p99.9" << std::setw(10) << "max" << "\n";
+        for(const auto& r : records) {
+            std::cout << std::left << std::setw(12) << r.allocator << std::setw(12) << r.op
+                      << std::right << std::setw(7) << r.size
+                      << std::setw(8) << ns(r.hist.percentile(50)) << std::setw(8) << ns(r.hist.percentile(99))
+                      << std::setw(9) << ns(r.hist.percentile(99.9)) << std::setw(10) << ns(r.hist.max()) << "\n";
+        }
+    }
+}
+
+// 每次分配（allocate + deallocate）平均的硬件事件数，以及两侧的 IPC
+void printCounters(const CounterTotals& totals)
+{
+    if(totals.allocs == 0) return;
+    std::cout << "  " << std::left << std::setw(16) << "per alloc" << std::right
+              << std::setw(12) << "MemoryPool" << std::setw(12) << "New/Delete" << "\n";
+    for(size_t i = 0; i < bench::COUNTER_COUNT; ++i) {
+        auto counter = static_cast<bench::Counter>(i);
+        std::cout << "  " << std::left << std::setw(16) << bench::counterName(counter) << std::right;
+        for(const auto* sample : {&totals.memPool, &totals.system}) {
+            if(sample->has(counter)) std::cout << std::setw(12) << std::setprecision(2) << (*sample)[counter] / totals.allocs;
+            else std::cout << std::setw(12) << "n/a";
+        }
+        std::cout << "\n";
+    }
+    std::cout << "  " << std::left << std::setw(16) << "ipc" << std::right;
+    for(const auto* sample : {&totals.memPool, &totals.system}) {
+        if(sample->has(bench::Counter::Cycles) && sample->has(bench::Counter::Instructions) &&
+           (*sample)[bench::Counter::Cycles] > 0) {
+            std::cout << std::setw(12) << std::setprecision(2)
+                      << (*sample)[bench::Counter::Instructions] / (*sample)[bench::Counter::Cycles];
+        } else {
+            std::cout << std::setw(12) << "n/a";
+        }
+    }
+    std::cout << std::endl;
 }
 
-int main()
+// 用法：perf_test [--counters] | [--latency [--format=text|csv|json]]
+int main(int argc, char** argv)
 {
+    bool latencyMode = false;
+    bool countersMode = false;
+    std::string format = "text";
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--latency") == 0) latencyMode = true;
+        else if(std::strcmp(argv[i], "--counters") == 0) countersMode = true;
+        else if(std::strncmp(argv[i], "--format=", 9) == 0) format = argv[i] + 9;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--counters] | [--latency [--format=text|csv|json]]" << std::endl;
+            return 1;
+        }
+    }
+
+    if(latencyMode) {
+        // 机器可读格式只输出数据本身
+        if(format == "text") PerformanceTest::warmup();
+        printLatency(runLatencyBench(), format);
+        return 0;
+    }
+
     constexpr int ITERATIONS = 5;
     std::cout << "Starting performance tests (" << ITERATIONS << " iterations each)..." << std::endl;
     PerformanceTest::warmup();
 
+    // 硬件计数器不可用（容器、非 Linux、权限不足）时只报告一次原因，计时照常进行
+    if(countersMode && !bench::PerfCounters::instance().open()) {
+        std::cout << "Hardware counters unavailable (" << bench::PerfCounters::instance().error()
+                  << "), reporting wall-clock time only." << std::endl;
+    }
+
     // 小对象测试
     {
-        auto res = runBench(testSmallAllocationWrapper, ITERATIONS);
+        CounterTotals totals;
+        auto res = runBench(testSmallAllocationWrapper, ITERATIONS, &totals);
         double speedup = (res.systemTime / res.memPoolTime - 1.0) * 100;
         std::cout << "\n[Small Objects " << ITERATIONS << "-run avg]\n"
                   << "  MemoryPool: " << std::fixed << std::setprecision(2) << res.memPoolTime << " ms\n"
                   << "  New/Delete: " << res.systemTime << " ms\n"
                   << "  Speedup:    +" << std::setprecision(1) << speedup << "%" << std::endl;
+        if(bench::PerfCounters::instance().available()) printCounters(totals);
     }
 
     // 多线程测试
     {
-        auto res = runBench(testMultiThreadedWrapper, ITERATIONS);
+        CounterTotals totals;
+        auto res = runBench(testMultiThreadedWrapper, ITERATIONS, &totals);
         double speedup = (res.systemTime / res.memPoolTime - 1.0) * 100;
         std::cout << "\n[Multi-Threaded " << ITERATIONS << "-run avg]\n"
                   << "  MemoryPool: " << std::fixed << std::setprecision(2) << res.memPoolTime << " ms\n"
                   << "  New/Delete: " << res.systemTime << " ms\n"
                   << "  Speedup:    +" << std::setprecision(1) << speedup << "%" << std::endl;
+        if(bench::PerfCounters::instance().available()) printCounters(totals);
     }
 
     // 混合大小测试
     {
-        auto res = runBench(testMixedSizesWrapper, ITERATIONS);
+        CounterTotals totals;
+        auto res = runBench(testMixedSizesWrapper, ITERATIONS, &totals);
         double speedup = (res.systemTime / res.memPoolTime - 1.0) * 100;
         std::cout << "\n[Mixed Sizes " << ITERATIONS << "-run avg]\n"
                   << "  MemoryPool: " << std::fixed << std::setprecision(2) << res.memPoolTime << " ms\n"
                   << "  New/Delete: " << res.systemTime << " ms\n"
                   << "  Speedup:    +" << std::setprecision(1) << speedup << "%" << std::endl;
+        if(bench::PerfCounters::instance().available()) printCounters(totals);
     }
 
     return 0;
@@ -0,0 +1,48 @@
+#pragma once
+// 基准测试公用：进程内存占用采样（Linux /proc）
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace bench
+{
+
+// 当前 RSS（字节），来自 /proc/self/statm 第二列
+inline size_t currentRssBytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    size_t sizePages = 0, residentPages = 0;
+    statm >> sizePages >> residentPages;
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// 读取 /proc/self/status 中的字段（kB），如 "VmHWM:"
+inline size_t readStatusKb(const char* field)
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t len = std::strlen(field);
+    while(std::getline(status, line)) {
+        if(line.compare(0, len, field) == 0) return std::strtoull(line.c_str() + len + 1, nullptr, 10);
+    }
+    return 0;
+}
+
+// 重置峰值 RSS（VmHWM），之后的 peakRssKb 只反映重置后的峰值
+inline void resetPeakRss()
+{
+    if(FILE* f = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+}
+
+inline size_t peakRssKb()
+{
+    return readStatusKb("VmHWM:");
+}
+
+}
@@ -0,0 +1,337 @@
+// 可扩展性矩阵基准：线程数 1 … 2×nproc，覆盖多种共享模式，对比内存池与 new/delete
+//   local     线程本地分配释放
+//   pipeline  生产者-消费者：线程 t 分配，线程 t+1 释放（环形拓扑，跨线程释放）
+//   larson    Larson 风格：对象随线程代际移交，新线程释放上一代线程分配的对象
+//   hot       所有线程反复批量分配释放同一 size-class，集中压测 CentralCache 单个桶
+// 用法：scale_bench [--max-threads=N] [--ops=N] [--patterns=local,pipeline,larson,hot] [--format=text|csv|json]
+#include "../include/MemoryPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace my_memorypool;
+
+struct PoolAllocator {
+    static constexpr const char* NAME = "MemoryPool";
+    static void* allocate(size_t n) { return MemoryPool::allocate(n); }
+    static void deallocate(void* p, size_t n) { MemoryPool::deallocate(p, n); }
+};
+
+struct NewDeleteAllocator {
+    static constexpr const char* NAME = "NewDelete";
+    static void* allocate(size_t n) { return new char[n]; }
+    static void deallocate(void* p, size_t) { delete[] static_cast<char*>(p); }
+};
+
+const size_t SIZES[] = {16, 32, 48, 64, 96, 128, 256, 512};
+constexpr size_t NUM_SIZES = sizeof(SIZES) / sizeof(SIZES[0]);
+
+struct Block {
+    void* ptr;
+    size_t size;
+};
+
+// 单生产者单消费者环形队列
+class SpscRing
+{
+public:
+    explicit SpscRing(size_t capacity) : slots_(capacity) {}
+
+    bool push(const Block& block)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - head_.load(std::memory_order_acquire) == slots_.size()) return false;
+        slots_[tail % slots_.size()] = block;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(Block& block)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if(head == tail_.load(std::memory_order_acquire)) return false;
+        block = slots_[head % slots_.size()];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<Block> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// 所有线程就绪后同时开始计时
+class StartGate
+{
+public:
+    void wait() { while(!open_.load(std::memory_order_acquire)) std::this_thread::yield(); }
+    void open() { open_.store(true, std::memory_order_release); }
+private:
+    std::atomic<bool> open_{false};
+};
+
+template<typename Alloc>
+double runLocal(size_t threads, size_t opsPerThread)
+{
+    StartGate gate;
+    auto worker = [&](size_t t) {
+        std::mt19937 gen(static_cast<unsigned>(t + 1));
+        std::vector<Block> window(256, Block{nullptr, 0});
+        gate.wait();
+        for(size_t i = 0; i < opsPerThread; ++i) {
+            Block& slot = window[gen() % window.size()];
+            if(slot.ptr) Alloc::deallocate(slot.ptr, slot.size);
+            slot.size = SIZES[gen() % NUM_SIZES];
+            slot.ptr = Alloc::allocate(slot.size);
+        }
+        for(auto& slot : window) if(slot.ptr) Alloc::deallocate(slot.ptr, slot.size);
+    };
+    std::vector<std::thread> pool;
+    for(size_t t = 0; t < threads; ++t) pool.emplace_back(worker, t);
+    auto start = std::chrono::steady_clock::now();
+    gate.open();
+    for(auto& th : pool) th.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename Alloc>
+double runPipeline(size_t threads, size_t opsPerThread)
+{
+    std::vector<std::unique_ptr<SpscRing>> rings;
+    for(size_t t = 0; t < threads; ++t) rings.emplace_back(new SpscRing(1024));
+    StartGate gate;
+
+    // 线程 t 向 rings[t] 生产，从 rings[(t + threads - 1) % threads] 消费
+    auto worker = [&](size_t t) {
+        std::mt19937 gen(static_cast<unsigned>(t + 1));
+        SpscRing& out = *rings[t];
+        SpscRing& in = *rings[(t + threads - 1) % threads];
+        size_t produced = 0, consumed = 0;
+        bool pending = false;
+        Block next{nullptr, 0};
+        gate.wait();
+        while(produced < opsPerThread || consumed < opsPerThread) {
+            if(produced < opsPerThread) {
+                if(!pending) {
+                    next.size = SIZES[gen() % NUM_SIZES];
+                    next.ptr = Alloc::allocate(next.size);
+                    pending = true;
+                }
+                if(out.push(next)) {
+                    pending = false;
+                    ++produced;
+                }
+            }
+            Block block;
+            if(in.pop(block)) {
+                Alloc::deallocate(block.ptr, block.size);
+                ++consumed;
+            } else if(pending) {
+                std::this_thread::yield();
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for(size_t t = 0; t < threads; ++t) pool.emplace_back(worker, t);
+    auto start = std::chrono::steady_clock::now();
+    gate.open();
+    for(auto& th : pool) th.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<typename Alloc>
+double runLarson(size_t threads, size_t opsPerThread)
+{
+    constexpr size_t GENERATIONS = 4;
+    constexpr size_t SLOTS = 512;
+    size_t opsPerGeneration = std::max<size_t>(opsPerThread / GENERATIONS, 1);
+
+    // 每个线程槽位的对象在代际之间移交
+    std::vector<std::vector<Block>> slots(threads, std::vector<Block>(SLOTS, Block{nullptr, 0}));
+    auto start = std::chrono::steady_clock::now();
+    for(size_t g = 0; g < GENERATIONS; ++g) {
+        std::vector<std::thread> pool;
+        for(size_t t = 0; t < threads; ++t) {
+            pool.emplace_back([&, t, g]() {
+                std::mt19937 gen(static_cast<unsigned>(t * GENERATIONS + g + 1));
+                auto& mine = slots[t];
+                for(size_t i = 0; i < opsPerGeneration; ++i) {
+                    Block& slot = mine[gen() % SLOTS];
+                    if(slot.ptr) Alloc::deallocate(slot.ptr, slot.size);
+                    slot.size = SIZES[gen() % NUM_SIZES];
+                    slot.ptr = Alloc::allocate(slot.size);
+                }
+            });
+        }
+        for(auto& th : pool) th.join();
+        // 轮换：下一代线程 t 接手上一代线程 t+1 的对象
+        std::rotate(slots.begin(), slots.begin() + 1, slots.end());
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for(auto& mine : slots) for(auto& slot : mine) if(slot.ptr) Alloc::deallocate(slot.ptr, slot.size);
+    return seconds;
+}
+
+template<typename Alloc>
+double runHot(size_t threads, size_t opsPerThread)
+{
+    constexpr size_t HOT_SIZE = 64;
+    // 超过线程缓存归还阈值，保证每轮都经过 CentralCache 的取回与归还
+    const size_t batch = 2 * MemoryPool::getOption(Option::ReturnThreshold) + 1;
+    StartGate gate;
+    auto worker = [&]() {
+        std::vector<void*> ptrs(batch);
+        gate.wait();
+        for(size_t done = 0; done < opsPerThread; done += batch) {
+            for(auto& p : ptrs) p = Alloc::allocate(HOT_SIZE);
+            for(auto p : ptrs) Alloc::deallocate(p, HOT_SIZE);
+        }
+    };
+    std::vector<std::thread> pool;
+    for(size_t t = 0; t < threads; ++t) pool.emplace_back(worker);
+    auto start = std::chrono::steady_clock::now();
+    gate.open();
+    for(auto& th : pool) th.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Cell {
+    std::string pattern;
+    std::string allocator;
+    size_t threads;
+    double opsPerSecPerThread;
+    double efficiency; // 吞吐 / (min(threads, nproc) × 单线程吞吐)
+};
+
+template<typename Alloc>
+void runPattern(const std::string& pattern, const std::vector<size_t>& threadCounts, size_t ops,
+                size_t cores, std::vector<Cell>& cells)
+{
+    auto run = [&](size_t threads, size_t n) {
+        if(pattern == "local") return runLocal<Alloc>(threads, n);
+        if(pattern == "pipeline") return runPipeline<Alloc>(threads, n);
+        if(pattern == "larson") return runLarson<Alloc>(threads, n);
+        return runHot<Alloc>(threads, n);
+    };
+    // 预热一轮，避免单线程基线承担首次向系统申请内存的开销
+    run(1, ops / 4 + 1);
+
+    double single = 0;
+    for(size_t threads : threadCounts) {
+        double seconds = run(threads, ops);
+
+        double throughput = threads * ops / seconds;
+        if(threads == 1) single = throughput;
+        double ideal = single * std::min(threads, cores);
+        cells.push_back({pattern, Alloc::NAME, threads, throughput / threads, ideal > 0 ? throughput / ideal : 0});
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    size_t maxThreads = 2 * cores;
+    size_t ops = 1000000;
+    std::string patternList = "local,pipeline,larson,hot";
+    std::string format = "text";
+    for(int i = 1; i < argc; ++i) {
+        if(std::strncmp(argv[i], "--max-threads=", 14) == 0) maxThreads = std::stoul(argv[i] + 14);
+        else if(std::strncmp(argv[i], "--ops=", 6) == 0) ops = std::stoul(argv[i] + 6);
+        else if(std::strncmp(argv[i], "--patterns=", 11) == 0) patternList = argv[i] + 11;
+        else if(std::strncmp(argv[i], "--format=", 9) == 0) format = argv[i] + 9;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--max-threads=N] [--ops=N] "
+                      << "[--patterns=local,pipeline,larson,hot] [--format=text|csv|json]" << std::endl;
+            return 1;
+        }
+    }
+
+    // 1, 2, 4, ... 直到 maxThreads（包含 maxThreads 本身）
+    std::vector<size_t> threadCounts;
+    for(size_t t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(std::max<size_t>(maxThreads, 1));
+
+    std::vector<std::string> patterns;
+    std::stringstream ss(patternList);
+    for(std::string p; std::getline(ss, p, ',');) {
+        if(p != "local" && p != "pipeline" && p != "larson" && p != "hot") {
+            std::cerr << "unknown pattern: " << p << std::endl;
+            return 1;
+        }
+        patterns.push_back(p);
+    }
+
+    std::vector<Cell> cells;
+    for(const auto& pattern : patterns) {
+        runPattern<PoolAllocator>(pattern, threadCounts, ops, cores, cells);
+        runPattern<NewDeleteAllocator>(pattern, threadCounts, ops, cores, cells);
+    }
+
+    if(format == "csv") {
+        std::cout << "pattern,allocator,threads,ops_per_sec_per_thread,efficiency\n";
+        for(const auto& c : cells) {
+            std::cout << c.pattern << ',' << c.allocator << ',' << c.threads << ','
+                      << std::fixed << std::setprecision(0) << c.opsPerSecPerThread << ','
+                      << std::setprecision(3) << c.efficiency << '\n';
+        }
+    } else if(format == "json") {
+        std::cout << "[\n";
+        for(size_t i = 0; i < cells.size(); ++i) {
+            const auto& c = cells[i];
+            std::cout << "  {\"pattern\": \"" << c.pattern << "\", \"allocator\": \"" << c.allocator
+                      << "\", \"threads\": " << c.threads << ", \"ops_per_sec_per_thread\": "
+                      << std::fixed << std::setprecision(0) << c.opsPerSecPerThread
+                      << ", \"efficiency\": " << std::setprecision(3) << c.efficiency << "}"
+                      << (i + 1 < cells.size() ? "," : "") << "\n";
+        }
+        std::cout << "]\n";
+    } else {
+        std::cout << "Scalability matrix (" << cores << " cores, " << ops << " ops/thread); "
+                  << "efficiency = throughput / (min(threads, cores) x single-thread throughput)\n";
+        for(const auto& pattern : patterns) {
+            std::cout << "\n[" << pattern << "]\n"
+                      << std::setw(9) << "threads" << std::setw(18) << "MemoryPool Mops/t" << std::setw(8) << "eff"
+                      << std::setw(18) << "NewDelete Mops/t" << std::setw(8) << "eff" << "\n";
+            for(size_t threads : threadCounts) {
+                const Cell* pool = nullptr;
+                const Cell* sys = nullptr;
+                for(const auto& c : cells) {
+                    if(c.pattern != pattern || c.threads != threads) continue;
+                    (c.allocator == std::string(PoolAllocator::NAME) ? pool : sys) = &c;
+                }
+                std::cout << std::setw(9) << threads << std::fixed
+                          << std::setw(18) << std::setprecision(2) << pool->opsPerSecPerThread / 1e6
+                          << std::setw(7) << std::setprecision(0) << pool->efficiency * 100 << '%'
+                          << std::setw(18) << std::setprecision(2) << sys->opsPerSecPerThread / 1e6
+                          << std::setw(7) << std::setprecision(0) << sys->efficiency * 100 << '%' << "\n";
+            }
+        }
+#if ENABLE_CENTRAL_STATS
+        // 争用最严重的几个 size-class（整个矩阵累计）
+        auto contention = MemoryPool::contentionStats();
+        auto weight = [](const CentralClassStats& c) { return c.lockSpins + c.casFailures; };
+        std::sort(contention.begin(), contention.end(),
+                  [&](const CentralClassStats& a, const CentralClassStats& b) { return weight(a) > weight(b); });
+        std::cout << "\n[CentralCache contention, top classes]\n"
+                  << std::setw(7) << "size" << std::setw(12) << "locks" << std::setw(12) << "spins"
+                  << std::setw(12) << "cas_fail" << std::setw(10) << "fallback" << std::setw(14) << "delay_ms" << "\n";
+        for(size_t i = 0; i < std::min<size_t>(contention.size(), 5); ++i) {
+            const auto& c = contention[i];
+            std::cout << std::setw(7) << c.blockSize << std::setw(12) << c.lockAcquisitions << std::setw(12) << c.lockSpins
+                      << std::setw(12) << c.casFailures << std::setw(10) << c.fallbackLocks
+                      << std::setw(14) << std::setprecision(2) << c.delayReturnNs / 1e6 << "\n";
+        }
+#endif
+    }
+    return 0;
+}
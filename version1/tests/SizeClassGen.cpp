@@ -0,0 +1,78 @@
+// size-class 表生成：读取 SizeProfile 导出的大小直方图，在内部碎片预算内求类数最少的 size-class 表，
+// 并在该类数下使内部碎片最小，输出可直接用于 -DSIZE_CLASS_HEADER=<file> 的 constexpr 头文件
+// 用法：size_class_gen <profile> [--waste=0.05] [--max-classes=256] [--out=<header>]
+//   waste 为内部碎片占（按 ALIGNMENT 取整后）请求字节数的比例上限；类数到达 max-classes 仍超预算时输出该类数下的最优表
+#include "SizeClassPlanner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace sizegen;
+
+int main(int argc, char** argv)
+{
+    const char* path = nullptr;
+    const char* outPath = nullptr;
+    double wasteBudget = 0.05;
+    size_t maxClasses = 256;
+    for(int i = 1; i < argc; ++i) {
+        if(std::strncmp(argv[i], "--waste=", 8) == 0) wasteBudget = std::atof(argv[i] + 8);
+        else if(std::strncmp(argv[i], "--max-classes=", 14) == 0) maxClasses = std::strtoul(argv[i] + 14, nullptr, 10);
+        else if(std::strncmp(argv[i], "--out=", 6) == 0) outPath = argv[i] + 6;
+        else if(!path && argv[i][0] != '-') path = argv[i];
+    }
+    if(!path || wasteBudget < 0 || maxClasses == 0) {
+        std::cerr << "usage: " << argv[0] << " <profile> [--waste=0.05] [--max-classes=256] [--out=<header>]" << std::endl;
+        return 1;
+    }
+
+    Profile profile;
+    if(!loadProfile(path, profile)) {
+        std::cerr << "cannot read size profile " << path << std::endl;
+        return 1;
+    }
+    if(profile.sizes.empty()) {
+        std::cerr << "size profile " << path << " has no samples" << std::endl;
+        return 1;
+    }
+
+    Plan plan = planSizeClasses(profile, wasteBudget, maxClasses);
+    const std::vector<size_t>& classes = plan.classes;
+    double wasteRatio = plan.totalBytes > 0 ? plan.waste / plan.totalBytes : 0.0;
+
+    std::ostringstream header;
+    header << "// 由 size_class_gen 根据 " << path << " 生成，请勿手工修改\n";
+    header << "// " << profile.samples << " 次分配，" << profile.sizes.size() << " 种大小 -> "
+           << classes.size() << " 个 size-class，内部碎片 " << wasteRatio * 100 << "%（预算 "
+           << wasteBudget * 100 << "%）\n";
+    header << "#pragma once\n#include <cstddef>\n\nnamespace my_memorypool\n{\n\n";
+    header << "struct ProfiledSizeClasses\n{\n";
+    header << "    static constexpr std::size_t COUNT = " << classes.size() << ";\n";
+    header << "    static constexpr std::size_t SIZES[COUNT] = {";
+    for(size_t i = 0; i < classes.size(); ++i) {
+        header << (i % 8 == 0 ? "\n        " : " ") << classes[i] << ",";
+    }
+    header << "\n    };\n};\n\n}\n";
+
+    if(outPath) {
+        std::ofstream out(outPath);
+        if(!out || !(out << header.str())) {
+            std::cerr << "cannot write " << outPath << std::endl;
+            return 1;
+        }
+    } else {
+        std::cout << header.str();
+    }
+
+    std::cerr << "sizes: " << profile.sizes.size() << "  classes: " << classes.size()
+              << "  waste: " << wasteRatio * 100 << "% (budget " << wasteBudget * 100 << "%)";
+    if(profile.largeCount) std::cerr << "  large (not classed): " << profile.largeCount;
+    if(!plan.budgetMet) std::cerr << "  [budget not met within " << classes.size() << " classes]";
+    std::cerr << std::endl;
+    return 0;
+}
@@ -0,0 +1,176 @@
+#pragma once
+// size_class_gen 与单元测试公用：读取 SizeProfile 直方图、按碎片预算求 size-class 表
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sizegen
+{
+
+struct Profile {
+    size_t granule = 8;
+    unsigned long long samples = 0;
+    unsigned long long requested = 0;
+    unsigned long long largeCount = 0;
+    std::vector<size_t> sizes;             // 升序、去重
+    std::vector<unsigned long long> counts;
+};
+
+inline bool loadProfile(const char* path, Profile& profile)
+{
+    std::ifstream in(path);
+    if(!in) return false;
+
+    std::vector<std::pair<size_t, unsigned long long>> entries;
+    std::string line;
+    while(std::getline(in, line)) {
+        if(line.empty()) continue;
+        std::istringstream fields(line);
+        if(line[0] == '#') {
+            std::string hash, key;
+            fields >> hash >> key;
+            if(key == "granule") fields >> profile.granule;
+            else if(key == "samples") fields >> profile.samples;
+            else if(key == "requested") fields >> profile.requested;
+            else if(key == "large") fields >> profile.largeCount;
+            continue;
+        }
+        size_t bytes = 0;
+        unsigned long long count = 0;
+        if(!(fields >> bytes >> count)) return false;
+        if(count > 0) entries.emplace_back(bytes, count);
+    }
+    if(profile.granule == 0) return false;
+
+    std::sort(entries.begin(), entries.end());
+    for(const auto& entry : entries) {
+        // 类必须是 granule 的倍数
+        size_t bytes = (std::max<size_t>(entry.first, 1) + profile.granule - 1) / profile.granule * profile.granule;
+        if(!profile.sizes.empty() && profile.sizes.back() == bytes) {
+            profile.counts.back() += entry.second;
+        } else {
+            profile.sizes.push_back(bytes);
+            profile.counts.push_back(entry.second);
+        }
+    }
+    return true;
+}
+
+// 一维分段：把升序的 n 个大小切成 k 段，每段向上取整到段内最大值，代价为 sum(count * (上界 - 大小))。
+// 代价满足四边形不等式，最优切分点随右端点单调，每层用分治优化在 O(n log n) 内求出
+class Planner {
+public:
+    explicit Planner(const Profile& profile)
+        : sizes_(profile.sizes)
+    {
+        size_t n = sizes_.size();
+        prefixCount_.assign(n + 1, 0.0);
+        prefixBytes_.assign(n + 1, 0.0);
+        for(size_t i = 0; i < n; ++i) {
+            prefixCount_[i + 1] = prefixCount_[i] + static_cast<double>(profile.counts[i]);
+            prefixBytes_[i + 1] = prefixBytes_[i] + static_cast<double>(profile.counts[i]) * static_cast<double>(sizes_[i]);
+        }
+        prev_.assign(n + 1, INF);
+        prev_[0] = 0.0;
+    }
+
+    double totalBytes() const { return prefixBytes_.back(); }
+
+    // 再增加一个类，返回当前类数下覆盖全部大小的最小碎片
+    double addClass()
+    {
+        size_t n = sizes_.size();
+        cur_.assign(n + 1, INF);
+        opt_.emplace_back(n + 1, 0);
+        ++classes_;
+        solve(classes_, n, 1, n);
+        prev_.swap(cur_);
+        return prev_[n];
+    }
+
+    // 按当前类数回溯出各类的上界
+    std::vector<size_t> classSizes() const
+    {
+        std::vector<size_t> result;
+        size_t j = sizes_.size();
+        for(size_t k = classes_; k > 0 && j > 0; --k) {
+            result.push_back(sizes_[j - 1]);
+            j = opt_[k - 1][j] - 1;
+        }
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    static constexpr double INF = std::numeric_limits<double>::infinity();
+
+    // 大小 [i, j]（1 起）合为一类的碎片
+    double cost(size_t i, size_t j) const
+    {
+        double count = prefixCount_[j] - prefixCount_[i - 1];
+        double bytes = prefixBytes_[j] - prefixBytes_[i - 1];
+        return static_cast<double>(sizes_[j - 1]) * count - bytes;
+    }
+
+    // 求 cur_[lo..hi]，已知最优的段起点落在 [optLo, optHi]
+    void solve(size_t lo, size_t hi, size_t optLo, size_t optHi)
+    {
+        if(lo > hi) return;
+        size_t mid = lo + (hi - lo) / 2;
+        double best = INF;
+        size_t bestStart = optLo;
+        for(size_t i = optLo; i <= std::min(mid, optHi); ++i) {
+            if(prev_[i - 1] == INF) continue;
+            double value = prev_[i - 1] + cost(i, mid);
+            if(value < best) {
+                best = value;
+                bestStart = i;
+            }
+        }
+        cur_[mid] = best;
+        opt_.back()[mid] = static_cast<uint32_t>(bestStart);
+        if(mid > lo) solve(lo, mid - 1, optLo, bestStart);
+        solve(mid + 1, hi, bestStart, optHi);
+    }
+
+    const std::vector<size_t>& sizes_;
+    std::vector<double> prefixCount_;
+    std::vector<double> prefixBytes_;
+    std::vector<double> prev_;
+    std::vector<double> cur_;
+    std::vector<std::vector<uint32_t>> opt_; // opt_[k-1][j]：k 个类覆盖前 j 个大小时最后一类的起点
+    size_t classes_ = 0;
+};
+
+struct Plan {
+    std::vector<size_t> classes;
+    double waste = 0;        // 内部碎片字节数
+    double totalBytes = 0;   // 按 granule 取整后的请求字节数
+    bool budgetMet = false;
+};
+
+// 从 1 个类开始逐个增加，碎片不超过 wasteBudget * totalBytes 即停；
+// 到 maxClasses（或大小种数）仍超预算时返回该类数下的最优表
+inline Plan planSizeClasses(const Profile& profile, double wasteBudget, size_t maxClasses)
+{
+    Plan plan;
+    Planner planner(profile);
+    plan.totalBytes = planner.totalBytes();
+    double budget = wasteBudget * plan.totalBytes;
+    size_t limit = std::min(maxClasses, profile.sizes.size());
+    for(size_t k = 1; k <= limit; ++k) {
+        plan.waste = planner.addClass();
+        if(plan.waste <= budget) break;
+    }
+    plan.classes = planner.classSizes();
+    plan.budgetMet = plan.waste <= budget;
+    return plan;
+}
+
+} // namespace sizegen
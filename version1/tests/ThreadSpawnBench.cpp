@@ -0,0 +1,118 @@
+// 线程创建基准：逐个创建短命线程，每个线程只做一次分配 + 释放后退出
+// 统计从 std::thread 构造到 join 返回的耗时分布，包含线程本地缓存的构造与退出时的归还
+//   empty    线程什么都不做（基线）
+//   pool     MemoryPool 默认堆
+//   heap     独立 Heap（走 ThreadHeapCaches 查找表）
+//   new      new / delete
+// 用法：spawn_bench [--threads=N] [--size=N] [--format=text|csv|json]
+#include "../include/MemoryPool.h"
+#include "LatencyHistogram.h"
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace my_memorypool;
+
+struct Result {
+    std::string scenario;
+    bench::LatencyHistogram hist;
+};
+
+template<typename Body>
+bench::LatencyHistogram measure(size_t threads, Body body)
+{
+    bench::LatencyHistogram hist;
+    for(size_t i = 0; i < threads; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        std::thread worker(body);
+        worker.join();
+        hist.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count()));
+    }
+    return hist;
+}
+
+void printResults(const std::vector<Result>& results, const std::string& format)
+{
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    if(format == "csv") {
+        std::cout << "scenario,threads,mean_us,p50_us,p90_us,p99_us,max_us\n";
+        for(const auto& r : results) {
+            std::cout << r.scenario << ',' << r.hist.count() << std::fixed << std::setprecision(2)
+                      << ',' << r.hist.mean() / 1000.0 << ',' << us(r.hist.percentile(50))
+                      << ',' << us(r.hist.percentile(90)) << ',' << us(r.hist.percentile(99))
+                      << ',' << us(r.hist.max()) << '\n';
+        }
+    } else if(format == "json") {
+        std::cout << "[\n";
+        for(size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            std::cout << "  {\"scenario\": \"" << r.scenario << "\", \"threads\": " << r.hist.count()
+                      << std::fixed << std::setprecision(2)
+                      << ", \"mean_us\": " << r.hist.mean() / 1000.0
+                      << ", \"p50_us\": " << us(r.hist.percentile(50))
+                      << ", \"p90_us\": " << us(r.hist.percentile(90))
+                      << ", \"p99_us\": " << us(r.hist.percentile(99))
+                      << ", \"max_us\": " << us(r.hist.max()) << "}"
+                      << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "]\n";
+    } else {
+        std::cout << "thread-local ThreadCache: " << sizeof(ThreadCache) << " bytes\n";
+        std::cout << std::left << std::setw(8) << "scenario" << std::right
+                  << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90"
+                  << std::setw(10) << "p99" << std::setw(10) << "max" << "  (us)\n";
+        for(const auto& r : results) {
+            std::cout << std::left << std::setw(8) << r.scenario << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(10) << r.hist.mean() / 1000.0 << std::setw(10) << us(r.hist.percentile(50))
+                      << std::setw(10) << us(r.hist.percentile(90)) << std::setw(10) << us(r.hist.percentile(99))
+                      << std::setw(10) << us(r.hist.max()) << '\n';
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t threads = 2000;
+    size_t size = 64;
+    std::string format = "text";
+    for(int i = 1; i < argc; ++i) {
+        if(std::strncmp(argv[i], "--threads=", 10) == 0) threads = std::stoul(argv[i] + 10);
+        else if(std::strncmp(argv[i], "--size=", 7) == 0) size = std::stoul(argv[i] + 7);
+        else if(std::strncmp(argv[i], "--format=", 9) == 0) format = argv[i] + 9;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--threads=N] [--size=N] [--format=text|csv|json]" << std::endl;
+            return 1;
+        }
+    }
+
+    // 预热：主线程先建好默认堆，线程栈等由 libc 缓存
+    MemoryPool::deallocate(MemoryPool::allocate(size), size);
+    Heap heap;
+    measure(threads / 10 + 1, [] {});
+
+    std::vector<Result> results;
+    results.push_back({"empty", measure(threads, [] {})});
+    results.push_back({"pool", measure(threads, [size] {
+        void* ptr = MemoryPool::allocate(size);
+        std::memset(ptr, 0, size);
+        MemoryPool::deallocate(ptr, size);
+    })});
+    results.push_back({"heap", measure(threads, [size, &heap] {
+        void* ptr = heap.allocate(size);
+        std::memset(ptr, 0, size);
+        heap.deallocate(ptr, size);
+    })});
+    results.push_back({"new", measure(threads, [size] {
+        char* ptr = new char[size];
+        std::memset(ptr, 0, size);
+        // 防止编译器把 new / delete 成对消除
+        asm volatile("" : : "r"(ptr) : "memory");
+        delete[] ptr;
+    })});
+    printResults(results, format);
+    return 0;
+}
@@ -0,0 +1,213 @@
+// 分层微基准：绕过 ThreadCache，直接驱动 CentralCache 与 PageCache
+//   central  N 个线程对同一 size-class 反复 fetchRange / returnRange（每线程最多持有 DEPTH 批）
+//   page     堆规模 1MB … 10GB 下的 span 操作：
+//              grow      从空 PageCache 按随机页数申请到目标规模（systemAlloc + 建立映射）
+//              churn     稳态下随机释放一个 span 再申请随机页数（lower_bound、切分、合并）
+//              coalesce  先释放偶数位 span，再释放奇数位 span（每次释放都与两侧合并）
+// 输出每次操作的平均耗时，--format=csv|json 便于跟踪回归
+// 用法：tier_bench [--tier=central|page|both] [--max-threads=N] [--max-heap-mb=N] [--ops=N] [--format=text|csv|json]
+#include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace my_memorypool;
+
+struct Result {
+    std::string tier;
+    std::string scenario;
+    size_t param1;      // central: 对象大小；page: 堆规模（字节）
+    size_t param2;      // central: 线程数；page: 存活 span 数
+    size_t ops;
+    double nsPerOp;
+};
+
+// ---------------- CentralCache ----------------
+
+size_t batchFor(size_t size)
+{
+    auto& options = RuntimeOptions<DefaultPolicy>::instance();
+    if(size <= DefaultPolicy::SMALL_BATCH_BYTES) return options.get(Option::SmallBatch);
+    if(size <= DefaultPolicy::MEDIUM_BATCH_BYTES) return options.get(Option::MediumBatch);
+    if(size <= DefaultPolicy::LARGE_BATCH_BYTES) return options.get(Option::LargeBatch);
+    return options.get(Option::HugeBatch);
+}
+
+double runCentral(size_t size, size_t threads, size_t opsPerThread)
+{
+    constexpr size_t DEPTH = 4;
+    PageCache pageCache;
+    // CentralCache 内含按 size-class 展开的大数组，放在堆上
+    auto central = std::make_unique<CentralCache>(pageCache);
+    const size_t index = SizeClass::getIndex(size);
+    const size_t blockSize = (index + 1) * ALIGNMENT;
+    const size_t batch = batchFor(blockSize);
+
+    std::atomic<bool> go{false};
+    auto worker = [&]() {
+        std::deque<std::pair<void*, size_t>> held;
+        while(!go.load(std::memory_order_acquire)) std::this_thread::yield();
+        for(size_t i = 0; i < opsPerThread; ++i) {
+            void* start = nullptr;
+            void* end = nullptr;
+            size_t n = central->fetchRange(start, end, batch, index);
+            if(n) held.emplace_back(start, n);
+            if(held.size() > DEPTH) {
+                central->returnRange(held.front().first, held.front().second * blockSize, index);
+                held.pop_front();
+            }
+        }
+        for(auto& [start, n] : held) central->returnRange(start, n * blockSize, index);
+    };
+
+    std::vector<std::thread> pool;
+    for(size_t t = 0; t < threads; ++t) pool.emplace_back(worker);
+    auto begin = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for(auto& th : pool) th.join();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    // 每次迭代包含一次 fetchRange 与（稳态下）一次 returnRange
+    return ns / (threads * opsPerThread);
+}
+
+// ---------------- PageCache ----------------
+
+struct LiveSpan {
+    void* ptr;
+    size_t pages;
+};
+
+void runPage(size_t heapBytes, size_t churnOps, std::vector<Result>& results)
+{
+    PageCache pageCache;
+    std::mt19937 gen(static_cast<unsigned>(heapBytes >> 20));
+    std::uniform_int_distribution<size_t> pagesDist(1, DefaultPolicy::MAX_SPAN_PAGES);
+    std::vector<LiveSpan> live;
+    using Clock = std::chrono::steady_clock;
+    auto nsSince = [](Clock::time_point begin) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+    };
+
+    // grow：只申请地址空间，不触碰页，测的是元数据路径
+    size_t bytes = 0;
+    auto begin = Clock::now();
+    while(bytes < heapBytes) {
+        size_t pages = pagesDist(gen);
+        void* ptr = pageCache.allocateSpan(pages);
+        if(!ptr) break;
+        live.push_back({ptr, pages});
+        bytes += pages * PageCache::PAGE_SIZE;
+    }
+    results.push_back({"page", "grow", heapBytes, live.size(), live.size(), nsSince(begin) / live.size()});
+
+    // churn：先释放一半制造空洞，然后在半满状态下随机释放 + 申请
+    std::shuffle(live.begin(), live.end(), gen);
+    size_t half = live.size() / 2;
+    for(size_t i = half; i < live.size(); ++i) pageCache.deallocateSpan(live[i].ptr, live[i].pages);
+    live.resize(half);
+    if(!live.empty()) {
+        begin = Clock::now();
+        for(size_t i = 0; i < churnOps; ++i) {
+            LiveSpan& victim = live[gen() % live.size()];
+            pageCache.deallocateSpan(victim.ptr, victim.pages);
+            victim.pages = pagesDist(gen);
+            victim.ptr = pageCache.allocateSpan(victim.pages);
+        }
+        results.push_back({"page", "churn", heapBytes, live.size(), churnOps, nsSince(begin) / churnOps});
+    }
+
+    // coalesce：按地址排序后先放偶数位，再放奇数位
+    std::sort(live.begin(), live.end(), [](const LiveSpan& a, const LiveSpan& b) { return a.ptr < b.ptr; });
+    size_t count = live.size();
+    begin = Clock::now();
+    for(size_t i = 0; i < count; i += 2) pageCache.deallocateSpan(live[i].ptr, live[i].pages);
+    for(size_t i = 1; i < count; i += 2) pageCache.deallocateSpan(live[i].ptr, live[i].pages);
+    if(count) results.push_back({"page", "coalesce", heapBytes, count, count, nsSince(begin) / count});
+}
+
+// ---------------- 输出 ----------------
+
+void printResults(const std::vector<Result>& results, const std::string& format)
+{
+    if(format == "csv") {
+        std::cout << "tier,scenario,size_or_heap_bytes,threads_or_spans,ops,ns_per_op\n";
+        for(const auto& r : results) {
+            std::cout << r.tier << ',' << r.scenario << ',' << r.param1 << ',' << r.param2 << ','
+                      << r.ops << ',' << std::fixed << std::setprecision(1) << r.nsPerOp << '\n';
+        }
+    } else if(format == "json") {
+        std::cout << "[\n";
+        for(size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            bool central = r.tier == "central";
+            std::cout << "  {\"tier\": \"" << r.tier << "\", \"scenario\": \"" << r.scenario << "\", \""
+                      << (central ? "size" : "heap_bytes") << "\": " << r.param1 << ", \""
+                      << (central ? "threads" : "spans") << "\": " << r.param2 << ", \"ops\": " << r.ops
+                      << ", \"ns_per_op\": " << std::fixed << std::setprecision(1) << r.nsPerOp << "}"
+                      << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "]\n";
+    } else {
+        for(const auto& r : results) {
+            if(r.tier == "central") {
+                std::cout << "[central] size " << std::setw(5) << r.param1 << "  threads " << std::setw(3) << r.param2;
+            } else {
+                std::cout << "[page]    " << std::left << std::setw(9) << r.scenario << std::right
+                          << " heap " << std::setw(6) << (r.param1 >> 20) << " MB  spans " << std::setw(7) << r.param2;
+            }
+            std::cout << "  " << std::fixed << std::setprecision(1) << std::setw(10) << r.nsPerOp << " ns/op\n";
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    size_t maxThreads = 2 * cores;
+    size_t maxHeapMb = 10240;
+    size_t ops = 20000;
+    std::string tier = "both";
+    std::string format = "text";
+    for(int i = 1; i < argc; ++i) {
+        if(std::strncmp(argv[i], "--tier=", 7) == 0) tier = argv[i] + 7;
+        else if(std::strncmp(argv[i], "--max-threads=", 14) == 0) maxThreads = std::stoul(argv[i] + 14);
+        else if(std::strncmp(argv[i], "--max-heap-mb=", 14) == 0) maxHeapMb = std::stoul(argv[i] + 14);
+        else if(std::strncmp(argv[i], "--ops=", 6) == 0) ops = std::stoul(argv[i] + 6);
+        else if(std::strncmp(argv[i], "--format=", 9) == 0) format = argv[i] + 9;
+        else {
+            std::cerr << "usage: " << argv[0] << " [--tier=central|page|both] [--max-threads=N] "
+                      << "[--max-heap-mb=N] [--ops=N] [--format=text|csv|json]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    if(tier == "central" || tier == "both") {
+        std::vector<size_t> threadCounts;
+        for(size_t t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+        threadCounts.push_back(std::max<size_t>(maxThreads, 1));
+        for(size_t size : {8, 64, 512, 4096}) {
+            for(size_t threads : threadCounts) {
+                results.push_back({"central", "fetch_return", size, threads, ops, runCentral(size, threads, ops)});
+            }
+        }
+    }
+    if(tier == "page" || tier == "both") {
+        for(size_t heapMb : {1, 16, 256, 1024, 10240}) {
+            if(heapMb > maxHeapMb) break;
+            runPage(heapMb << 20, ops, results);
+        }
+    }
+    printResults(results, format);
+    return 0;
+}
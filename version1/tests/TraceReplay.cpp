@@ -0,0 +1,264 @@
+// 分配轨迹回放：按原始线程结构将 AllocTrace 录制的轨迹分别回放到内存池与 glibc malloc，
+// 输出吞吐、逐次延迟分位数与峰值 RSS
+// 用法：trace_replay <trace-file> [--allocator=pool|malloc|both] [--format=text|csv|json]
+#include "../include/MemoryPool.h"
+#include "LatencyHistogram.h"
+#include "ProcessStats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace my_memorypool;
+
+// 回放操作：对象按生命周期重新编号（同一地址被复用时视为不同对象）
+struct ReplayOp {
+    uint8_t op;
+    size_t size;
+    size_t object;
+};
+
+struct Trace {
+    std::vector<std::vector<ReplayOp>> threads;
+    size_t objectCount = 0;
+    size_t opCount = 0;
+    size_t skippedFrees = 0; // 录制开始前分配的对象，回放时跳过其释放
+};
+
+struct ReplayResult {
+    double seconds = 0;
+    size_t ops = 0;
+    bench::LatencyHistogram allocHist;
+    bench::LatencyHistogram freeHist;
+    size_t baselineRssKb = 0;
+    size_t peakRssKb = 0;
+};
+
+bool loadTrace(const char* path, Trace& trace)
+{
+    std::ifstream in(path, std::ios::binary);
+    if(!in) {
+        std::cerr << "cannot open " << path << std::endl;
+        return false;
+    }
+    AllocTrace::FileHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if(!in || std::memcmp(header.magic, "MPTRACE1", 8) != 0 ||
+       header.version != AllocTrace::VERSION || header.recordSize != sizeof(AllocTrace::Record)) {
+        std::cerr << path << ": not a memory pool trace" << std::endl;
+        return false;
+    }
+
+    // 读到文件末尾而不是只读 recordCount 条：进程异常退出时文件头未回写，数据仍然可用
+    std::vector<AllocTrace::Record> records;
+    records.reserve(header.recordCount);
+    AllocTrace::Record record{};
+    while(in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        if(record.op == AllocTrace::Allocate || record.op == AllocTrace::Deallocate) {
+            records.push_back(record);
+        }
+    }
+    if(header.dropped > 0) {
+        std::cerr << "warning: trace dropped " << header.dropped << " records (capacity exhausted)" << std::endl;
+    }
+
+    // 按全局时间排序后给每段生命周期编号；线程内顺序与时间顺序一致
+    std::stable_sort(records.begin(), records.end(),
+        [](const AllocTrace::Record& a, const AllocTrace::Record& b) { return a.timestamp < b.timestamp; });
+
+    std::map<uint32_t, size_t> threadIndex;
+    std::unordered_map<uint64_t, size_t> liveObjects;
+    for(const auto& r : records) {
+        auto [it, inserted] = threadIndex.emplace(r.thread, trace.threads.size());
+        if(inserted) trace.threads.emplace_back();
+        auto& ops = trace.threads[it->second];
+
+        if(r.op == AllocTrace::Allocate) {
+            size_t object = trace.objectCount++;
+            liveObjects[r.object] = object;
+            ops.push_back({r.op, static_cast<size_t>(r.size), object});
+        } else {
+            auto live = liveObjects.find(r.object);
+            if(live == liveObjects.end()) {
+                ++trace.skippedFrees;
+                continue;
+            }
+            ops.push_back({r.op, static_cast<size_t>(r.size), live->second});
+            liveObjects.erase(live);
+        }
+        ++trace.opCount;
+    }
+    return true;
+}
+
+template<typename AllocFunc, typename FreeFunc>
+ReplayResult replay(const Trace& trace, AllocFunc allocFunc, FreeFunc freeFunc)
+{
+    ReplayResult result;
+
+    // 重置峰值 RSS（VmHWM），只统计回放期间的峰值
+    bench::resetPeakRss();
+    result.baselineRssKb = bench::readStatusKb("VmRSS:");
+
+    std::unique_ptr<std::atomic<void*>[]> objects(new std::atomic<void*>[trace.objectCount]);
+    for(size_t i = 0; i < trace.objectCount; ++i) objects[i].store(nullptr, std::memory_order_relaxed);
+    std::vector<char> freed(trace.objectCount, 0);
+    std::vector<bench::LatencyHistogram> allocHists(trace.threads.size());
+    std::vector<bench::LatencyHistogram> freeHists(trace.threads.size());
+
+    auto threadFunc = [&](size_t t) {
+        for(const ReplayOp& op : trace.threads[t]) {
+            if(op.op == AllocTrace::Allocate) {
+                uint64_t begin = bench::TickClock::now();
+                void* ptr = allocFunc(op.size);
+                uint64_t end = bench::TickClock::now();
+                allocHists[t].record(end - begin);
+                if(op.size > 0) *static_cast<char*>(ptr) = 1;
+                objects[op.object].store(ptr, std::memory_order_release);
+            } else {
+                // 跨线程释放：等待分配方线程完成分配（原始时间序保证不会形成等待环）
+                void* ptr;
+                while(!(ptr = objects[op.object].load(std::memory_order_acquire))) {
+                    std::this_thread::yield();
+                }
+                uint64_t begin = bench::TickClock::now();
+                freeFunc(ptr, op.size);
+                uint64_t end = bench::TickClock::now();
+                freeHists[t].record(end - begin);
+                freed[op.object] = 1;
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < trace.threads.size(); ++t) threads.emplace_back(threadFunc, t);
+    for(auto& th : threads) th.join();
+    auto end = std::chrono::steady_clock::now();
+
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.ops = trace.opCount;
+    result.peakRssKb = bench::peakRssKb();
+    for(auto& h : allocHists) result.allocHist.merge(h);
+    for(auto& h : freeHists) result.freeHist.merge(h);
+
+    // 录制结束时仍存活的对象，回放后统一释放（不计入统计）
+    for(size_t t = 0; t < trace.threads.size(); ++t) {
+        for(const ReplayOp& op : trace.threads[t]) {
+            if(op.op == AllocTrace::Allocate && !freed[op.object]) {
+                freeFunc(objects[op.object].load(std::memory_order_relaxed), op.size);
+                freed[op.object] = 1;
+            }
+        }
+    }
+    return result;
+}
+
+void printResult(const std::string& allocator, const ReplayResult& r, const std::string& format)
+{
+    auto ns = [](uint64_t ticks) { return bench::TickClock::toNs(ticks); };
+    double opsPerSec = r.seconds > 0 ? r.ops / r.seconds : 0;
+    if(format == "csv") {
+        for(const auto& [op, hist] : {std::make_pair("allocate", &r.allocHist), std::make_pair("deallocate", &r.freeHist)}) {
+            std::cout << allocator << ',' << op << ',' << r.ops << ',' << std::fixed << std::setprecision(0) << opsPerSec << ','
+                      << ns(hist->percentile(50)) << ',' << ns(hist->percentile(99)) << ','
+                      << ns(hist->percentile(99.9)) << ',' << ns(hist->max()) << ','
+                      << r.baselineRssKb << ',' << r.peakRssKb << '\n';
+        }
+    } else if(format == "json") {
+        std::cout << "{\"allocator\": \"" << allocator << "\", \"ops\": " << r.ops
+                  << ", \"ops_per_sec\": " << std::fixed << std::setprecision(0) << opsPerSec;
+        for(const auto& [op, hist] : {std::make_pair("allocate", &r.allocHist), std::make_pair("deallocate", &r.freeHist)}) {
+            std::cout << ", \"" << op << "\": {\"p50_ns\": " << ns(hist->percentile(50))
+                      << ", \"p99_ns\": " << ns(hist->percentile(99))
+                      << ", \"p99_9_ns\": " << ns(hist->percentile(99.9))
+                      << ", \"max_ns\": " << ns(hist->max()) << "}";
+        }
+        std::cout << ", \"baseline_rss_kb\": " << r.baselineRssKb << ", \"peak_rss_kb\": " << r.peakRssKb << "}\n";
+    } else {
+        std::cout << "\n[" << allocator << "]\n"
+                  << "  Ops:        " << r.ops << " in " << std::fixed << std::setprecision(3) << r.seconds << " s ("
+                  << std::setprecision(0) << opsPerSec << " ops/s)\n";
+        for(const auto& [op, hist] : {std::make_pair("allocate", &r.allocHist), std::make_pair("deallocate", &r.freeHist)}) {
+            std::cout << "  " << std::left << std::setw(11) << op << std::right
+                      << " p50 " << ns(hist->percentile(50)) << " ns, p99 " << ns(hist->percentile(99))
+                      << " ns, p99.9 " << ns(hist->percentile(99.9)) << " ns, max " << ns(hist->max()) << " ns\n";
+        }
+        std::cout << "  Peak RSS:   " << r.peakRssKb << " kB (baseline " << r.baselineRssKb << " kB)" << std::endl;
+    }
+}
+
+// 每个分配器在独立子进程中回放，互不影响 RSS 与缓存状态
+void runIsolated(const std::string& allocator, const Trace& trace, const std::string& format)
+{
+    std::cout.flush();
+    pid_t pid = fork();
+    if(pid == 0) {
+        ReplayResult result;
+        if(allocator == "pool") {
+            result = replay(trace,
+                [](size_t n) { return MemoryPool::allocate(n); },
+                [](void* p, size_t n) { MemoryPool::deallocate(p, n); });
+        } else {
+            result = replay(trace,
+                [](size_t n) { return std::malloc(n); },
+                [](void* p, size_t) { std::free(p); });
+        }
+        printResult(allocator, result, format);
+        std::cout.flush();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << allocator << " replay failed" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = nullptr;
+    std::string allocator = "both";
+    std::string format = "text";
+    for(int i = 1; i < argc; ++i) {
+        if(std::strncmp(argv[i], "--allocator=", 12) == 0) allocator = argv[i] + 12;
+        else if(std::strncmp(argv[i], "--format=", 9) == 0) format = argv[i] + 9;
+        else if(!path && argv[i][0] != '-') path = argv[i];
+        else path = nullptr, argc = 0;
+    }
+    if(!path || (allocator != "pool" && allocator != "malloc" && allocator != "both")) {
+        std::cerr << "usage: " << argv[0] << " <trace-file> [--allocator=pool|malloc|both] [--format=text|csv|json]" << std::endl;
+        return 1;
+    }
+    // 回放本身不应再被录制
+    AllocTrace::stop();
+
+    Trace trace;
+    if(!loadTrace(path, trace)) return 1;
+    if(format == "text") {
+        std::cout << "Trace: " << trace.opCount << " ops, " << trace.threads.size() << " threads, "
+                  << trace.objectCount << " objects";
+        if(trace.skippedFrees) std::cout << ", " << trace.skippedFrees << " frees of untraced objects skipped";
+        std::cout << std::endl;
+    } else if(format == "csv") {
+        std::cout << "allocator,op,ops,ops_per_sec,p50_ns,p99_ns,p99_9_ns,max_ns,baseline_rss_kb,peak_rss_kb\n";
+    }
+    bench::TickClock::ticksPerNs(); // 在子进程之前完成校准
+
+    if(allocator == "pool" || allocator == "both") runIsolated("pool", trace, format);
+    if(allocator == "malloc" || allocator == "both") runIsolated("malloc", trace, format);
+    return 0;
+}
@@ -1,16 +1,71 @@
 
 #include "../include/MemoryPool.h"
+#include "../include/CentralCache.h"
+#include "../include/PageCache.h"
+#include "../include/PoolBuffer.h"
+#include "../include/SharedPool.h"
+#include "SizeClassPlanner.h"
 #include <iostream>
 #include <vector>
 #include <thread>
 #include <cassert>
 #include <cstring>
+#include <cmath>
+#include <limits>
 #include <random>
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_set>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace my_memorypool;
 
+// 替换全局 operator new / delete，统计调用次数与未释放的对象数：检查某段代码是否进入 malloc、是否泄漏
+namespace
+{
+std::atomic<uint64_t> newCalls{0};
+std::atomic<int64_t> liveNews{0};
+
+void* countedNew(size_t size, size_t align)
+{
+    newCalls.fetch_add(1, std::memory_order_relaxed);
+    liveNews.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    void* ptr = align > alignof(std::max_align_t)
+        ? std::aligned_alloc(align, (size + align - 1) / align * align)
+        : std::malloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void countedDelete(void* ptr)
+{
+    if (!ptr) return;
+    liveNews.fetch_sub(1, std::memory_order_relaxed);
+    std::free(ptr);
+}
+}
+
+void* operator new(size_t size) { return countedNew(size, 0); }
+void* operator new(size_t size, std::align_val_t align) { return countedNew(size, static_cast<size_t>(align)); }
+void operator delete(void* ptr) noexcept { countedDelete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { countedDelete(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { countedDelete(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { countedDelete(ptr); }
+
 // 基础分配测试
 void testBasicAllocation() 
 {
@@ -183,6 +238,1432 @@ void testStress()
     std::cout << "Stress test passed!" << std::endl;
 }
 
+// 独立堆测试
+void testHeapIsolation()
+{
+    std::cout << "Running heap isolation test..." << std::endl;
+
+    Heap heapA;
+    Heap heapB;
+    assert(heapA.id() != heapB.id());
+    assert(heapA.reservedBytes() == 0 && heapB.reservedBytes() == 0);
+
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 1000; ++i)
+    {
+        void* ptr = heapA.allocate(64);
+        assert(ptr != nullptr);
+        std::memset(ptr, 0xAB, 64);
+        ptrs.push_back(ptr);
+    }
+    void* large = heapA.allocate(MAX_BYTES + 1);
+    assert(large != nullptr);
+    (void)large;
+
+    // heapA 的分配不会占用 heapB 的 span
+    assert(heapA.reservedBytes() > 0);
+    assert(heapB.reservedBytes() == 0);
+
+    // 其他线程在 heapA 上分配，线程退出时缓存归还给 heapA
+    std::thread worker([&heapA]()
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            void* ptr = heapA.allocate(128);
+            assert(ptr != nullptr);
+            heapA.deallocate(ptr, 128);
+        }
+    });
+    worker.join();
+
+    // 整体释放，无需逐个 deallocate
+    uint64_t oldId = heapA.id();
+    heapA.destroy();
+    assert(heapA.reservedBytes() == 0);
+    assert(heapA.id() != oldId);
+    (void)oldId;
+
+    // destroy 后堆可继续使用，且线程缓存中的失效块已被丢弃
+    void* ptr = heapA.allocate(64);
+    assert(ptr != nullptr);
+    std::memset(ptr, 0xCD, 64);
+    heapA.deallocate(ptr, 64);
+
+    // 反复创建、使用、析构堆（放在互不重叠的位置，旧缓存无法按地址复用）：
+    // 本线程的缓存表按 id 清理失效项，缓存对象不随析构的堆数增长
+    constexpr size_t CHURN = 64;
+    std::vector<std::unique_ptr<unsigned char[]>> slots;
+    for (size_t i = 0; i < CHURN; ++i) slots.emplace_back(new unsigned char[sizeof(Heap) + alignof(Heap)]);
+    int64_t liveBefore = liveNews.load();
+    for (size_t i = 0; i < CHURN; ++i)
+    {
+        void* raw = slots[i].get();
+        size_t space = sizeof(Heap) + alignof(Heap);
+        Heap* heap = new (std::align(alignof(Heap), sizeof(Heap), raw, space)) Heap;
+        void* block = heap->allocate(64);
+        assert(block != nullptr);
+        heap->deallocate(block, 64);
+        if (i % 2) heap->destroy();
+        heap->~Heap();
+    }
+    // 最后一个堆的缓存要到下次新建缓存时才清理
+    assert(liveNews.load() - liveBefore <= 4);
+    (void)liveBefore;
+
+    std::cout << "Heap isolation test passed!" << std::endl;
+}
+
+// 编译期策略测试
+void testPolicyPool()
+{
+    std::cout << "Running policy pool test..." << std::endl;
+
+    static_assert(PolicyTraits<TinyObjectPolicy>::FREE_LIST_SIZE == 16 * 1024 / 8, "tiny pool class count");
+    static_assert(BasicPageCache<TinyObjectPolicy>::PAGE_SIZE == 64 * 1024, "tiny pool logical page");
+
+    std::vector<std::pair<void*, size_t>> allocations;
+    for (size_t size = 1; size <= TinyObjectPolicy::MAX_BYTES + 4096; size += 97)
+    {
+        void* ptr = TinyMemoryPool::allocate(size);
+        assert(ptr != nullptr);
+        std::memset(ptr, 0x5A, size);
+        allocations.push_back({ptr, size});
+    }
+    for (const auto& alloc : allocations)
+    {
+        TinyMemoryPool::deallocate(alloc.first, alloc.second);
+    }
+
+    BasicHeap<TinyObjectPolicy> heap;
+    void* ptr = heap.allocate(24);
+    assert(ptr != nullptr);
+    assert(heap.reservedBytes() % TinyObjectPolicy::PAGE_SIZE == 0);
+    heap.deallocate(ptr, 24);
+    heap.destroy();
+    assert(heap.reservedBytes() == 0);
+
+    std::cout << "Policy pool test passed!" << std::endl;
+}
+
+// 运行期参数测试
+void testRuntimeOptions()
+{
+    std::cout << "Running runtime options test..." << std::endl;
+
+    size_t threshold = MemoryPool::getOption(Option::ReturnThreshold);
+    bool ok = MemoryPool::setOption(Option::ReturnThreshold, 32);
+    assert(ok && MemoryPool::getOption(Option::ReturnThreshold) == 32);
+    ok = MemoryPool::setOption(Option::ReturnThreshold, 0);
+    assert(!ok);
+    ok = MemoryPool::setOption(Option::LargeObjectCutoff, MAX_BYTES + 1);
+    assert(!ok);
+    assert(MemoryPool::getOption(Option::ReturnThreshold) == 32);
+
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 100; ++i) ptrs.push_back(MemoryPool::allocate(48));
+    for (void* ptr : ptrs) MemoryPool::deallocate(ptr, 48);
+    MemoryPool::setOption(Option::ReturnThreshold, threshold);
+
+    // 在线调整大对象阈值：调整前后分配的对象都能正确释放
+    size_t cutoff = MemoryPool::getOption(Option::LargeObjectCutoff);
+    void* cached = MemoryPool::allocate(8192);
+    ok = MemoryPool::setOption(Option::LargeObjectCutoff, 4096);
+    assert(ok);
+    void* paged = MemoryPool::allocate(8192);
+    std::memset(cached, 1, 8192);
+    std::memset(paged, 2, 8192);
+    ok = MemoryPool::setOption(Option::LargeObjectCutoff, cutoff);
+    assert(ok);
+    (void)ok;
+    MemoryPool::deallocate(cached, 8192);
+    MemoryPool::deallocate(paged, 8192);
+    void* again = MemoryPool::allocate(8192);
+    assert(again != nullptr);
+    MemoryPool::deallocate(again, 8192);
+
+    // 空闲 span 归还系统后仍可再次分配（内核提供零页）
+    Heap heap;
+    char* large = static_cast<char*>(heap.allocate(MAX_BYTES + 1));
+    std::memset(large, 0x7F, MAX_BYTES + 1);
+    heap.deallocate(large, MAX_BYTES + 1);
+    size_t released = heap.pageCache().scavenge(SIZE_MAX);
+    assert(released >= MAX_BYTES + 1);
+    (void)released;
+    large = static_cast<char*>(heap.allocate(MAX_BYTES + 1));
+    assert(large != nullptr);
+    large[0] = 1;
+    heap.deallocate(large, MAX_BYTES + 1);
+
+    std::cout << "Runtime options test passed!" << std::endl;
+}
+
+// 新 span 按需切分与空闲 span 归还测试
+void testLazyCarving()
+{
+    std::cout << "Running lazy carving test..." << std::endl;
+
+    size_t maxDelay = MemoryPool::getOption(Option::MaxDelayCount);
+    size_t interval = MemoryPool::getOption(Option::DelayIntervalMs);
+    MemoryPool::setOption(Option::MaxDelayCount, 1);
+    MemoryPool::setOption(Option::DelayIntervalMs, 0);
+
+    Heap heap;
+#ifdef __linux__
+    // 只取一个 1KB 对象：span 可容纳 MIN_SPAN_OBJECTS 个，只有交出去的那一批所在的页被触碰
+    void* tiny = heap.allocate(1024);
+    size_t page = sysconf(_SC_PAGESIZE);
+    char* spanStart = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(tiny) & ~(page - 1));
+    size_t spanBytes = DefaultPolicy::MIN_SPAN_OBJECTS * 1024;
+    std::vector<unsigned char> resident(spanBytes / page);
+    if (mincore(spanStart, spanBytes, resident.data()) == 0)
+    {
+        size_t touched = std::count_if(resident.begin(), resident.end(), [](unsigned char r) { return r & 1; });
+        assert(touched < resident.size());
+        (void)touched;
+    }
+    heap.deallocate(tiny, 1024);
+#endif
+
+    // 线程退出时整批归还，切分完毕且全部空闲的 span 回到 PageCache 后可被再次分配
+    for (int round = 0; round < 2; ++round)
+    {
+        std::thread worker([&heap]()
+        {
+            std::vector<void*> ptrs;
+            for (int i = 0; i < 4000; ++i)
+            {
+                void* ptr = heap.allocate(64);
+                std::memset(ptr, i & 0xFF, 64);
+                ptrs.push_back(ptr);
+            }
+            for (void* ptr : ptrs) heap.deallocate(ptr, 64);
+        });
+        worker.join();
+#if ENABLE_SPAN_TRACKING
+        assert(heap.stats().pageFreeBytes > 0);
+#endif
+    }
+
+    MemoryPool::setOption(Option::MaxDelayCount, maxDelay);
+    MemoryPool::setOption(Option::DelayIntervalMs, interval);
+
+    std::cout << "Lazy carving test passed!" << std::endl;
+}
+
+// 小对象位图 slab 测试（需 ENABLE_TINY_SLABS）
+void testTinySlabs()
+{
+#if ENABLE_TINY_SLABS
+    std::cout << "Running tiny slab test..." << std::endl;
+
+    Heap heap;
+    // 释放后总是复用地址最低的空闲槽
+    void* a = heap.allocate(16);
+    void* b = heap.allocate(16);
+    assert(static_cast<char*>(b) == static_cast<char*>(a) + 16);
+    heap.deallocate(a, 16);
+    void* c = heap.allocate(16);
+    assert(c == a);
+    heap.deallocate(b, 16);
+    heap.deallocate(c, 16);
+
+    // 其他线程分配、本线程释放：线程退出后 slab 成为孤儿，最后一次远程释放归还整页
+    std::vector<void*> ptrs;
+    std::thread producer([&heap, &ptrs]()
+    {
+        for (int i = 0; i < 3000; ++i)
+        {
+            size_t size = 8 + (i % 4) * 8;
+            void* ptr = heap.allocate(size);
+            std::memset(ptr, i & 0xFF, size);
+            ptrs.push_back(ptr);
+        }
+    });
+    producer.join();
+
+    size_t before = heap.stats().pageFreeBytes;
+    for (size_t i = 0; i < ptrs.size(); ++i)
+    {
+        size_t size = 8 + (i % 4) * 8;
+        assert(static_cast<unsigned char*>(ptrs[i])[size - 1] == (i & 0xFF));
+        heap.deallocate(ptrs[i], size);
+    }
+    assert(heap.stats().pageFreeBytes > before);
+    (void)before;
+    (void)c;
+
+    std::cout << "Tiny slab test passed!" << std::endl;
+#endif
+}
+
+// CentralCache 按 size-class 惰性创建的桶
+void testCentralBuckets()
+{
+    std::cout << "Running central bucket test..." << std::endl;
+
+    // 构造时不创建任何桶，也不向系统申请内存
+    PageCache pageCache;
+    CentralCache centralCache(pageCache);
+    assert(pageCache.systemBytes() == 0);
+
+    // 相邻 size-class（24/32/40B）在各自线程上反复取还，块不重复且按块大小对齐
+    std::vector<std::thread> workers;
+    std::atomic<bool> failed{false};
+    for (size_t size : {size_t(24), size_t(32), size_t(40)})
+    {
+        workers.emplace_back([&centralCache, &failed, size]()
+        {
+            size_t index = SizeClass::getIndex(size);
+            std::unordered_set<void*> seen;
+            for (int round = 0; round < 200; ++round)
+            {
+                void* start = nullptr;
+                void* end = nullptr;
+                size_t count = centralCache.fetchRange(start, end, 16, index);
+                if (count == 0) { failed = true; return; }
+                size_t walked = 0;
+                for (void* block = start; block; block = *reinterpret_cast<void**>(block)) ++walked;
+                if (walked != count) failed = true;
+                if (round < 20)
+                {
+                    // 前 20 轮不归还：这些块必须互不相同
+                    for (void* block = start; block; block = *reinterpret_cast<void**>(block))
+                    {
+                        if (!seen.insert(block).second) failed = true;
+                    }
+                    continue;
+                }
+                centralCache.returnRange(start, count * size, index);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    assert(!failed);
+
+    // reset 后桶被丢弃，重新取用时再创建
+    centralCache.reset();
+    pageCache.releaseAll();
+    void* start = nullptr;
+    void* end = nullptr;
+    size_t count = centralCache.fetchRange(start, end, 4, SizeClass::getIndex(64));
+    assert(count == 4);
+    centralCache.returnRange(start, count * 64, SizeClass::getIndex(64));
+    (void)count;
+
+    // 同一 size-class 上持锁取块与无锁归还交错：取到、还回的块一个都不能丢。
+    // 暂时关掉延迟归还，避免整 span 被合法地摘走
+    size_t delayInterval = MemoryPool::getOption(Option::DelayIntervalMs);
+    MemoryPool::setOption(Option::DelayIntervalMs, size_t(1) << 40);
+    {
+        const size_t size = 48;
+        const size_t index = SizeClass::getIndex(size);
+        std::vector<std::unordered_set<void*>> handedOut(4);
+        std::vector<std::thread> racers;
+        for (size_t t = 0; t < handedOut.size(); ++t)
+        {
+            racers.emplace_back([&centralCache, &handedOut, &failed, t, size, index]()
+            {
+                for (int round = 0; round < 2000; ++round)
+                {
+                    void* first = nullptr;
+                    void* last = nullptr;
+                    size_t got = centralCache.fetchRange(first, last, 1 + round % 7, index);
+                    if (got == 0) { failed = true; return; }
+                    for (void* block = first; block; block = *reinterpret_cast<void**>(block)) handedOut[t].insert(block);
+                    if (round % 3 == 0) std::this_thread::yield();
+                    centralCache.returnRange(first, got * size, index);
+                }
+            });
+        }
+        for (auto& racer : racers) racer.join();
+        assert(!failed);
+
+        // 全部块都已还回：中心链表中应恰好是各线程取到过的块
+        std::unordered_set<void*> expected;
+        for (const auto& blocks : handedOut) expected.insert(blocks.begin(), blocks.end());
+        void* first = nullptr;
+        void* last = nullptr;
+        size_t listed = centralCache.fetchRange(first, last, expected.size() + 1, index);
+        assert(listed == expected.size());
+        for (void* block = first; block; block = *reinterpret_cast<void**>(block)) assert(expected.count(block) == 1);
+        centralCache.returnRange(first, listed * size, index);
+        (void)listed;
+    }
+
+    // 延迟归还扫描与取还并发：扫描只在摘链时持锁，统计与过滤在私有链表上进行；
+    // 正在使用的块所在的 span 不能被归还（否则会被重新切出、交给第二个使用者）
+    {
+        const size_t size = 48;
+        const size_t index = SizeClass::getIndex(size);
+        std::atomic<bool> stop{false};
+        std::thread trimmer([&centralCache, &stop]()
+        {
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                centralCache.trim();
+                std::this_thread::yield();
+            }
+        });
+        std::vector<std::thread> racers;
+        for (uint64_t t = 0; t < 3; ++t)
+        {
+            racers.emplace_back([&centralCache, &failed, t, size, index]()
+            {
+                for (uint64_t round = 0; round < 2000; ++round)
+                {
+                    void* first = nullptr;
+                    void* last = nullptr;
+                    size_t got = centralCache.fetchRange(first, last, 1 + round % 5, index);
+                    if (got == 0) { failed = true; return; }
+                    uint64_t stamp = (t << 32) | round;
+                    for (void* block = first; block; block = *reinterpret_cast<void**>(block))
+                        static_cast<uint64_t*>(block)[1] = stamp;
+                    std::this_thread::yield();
+                    for (void* block = first; block; block = *reinterpret_cast<void**>(block))
+                        if (static_cast<uint64_t*>(block)[1] != stamp) failed = true;
+                    centralCache.returnRange(first, got * size, index);
+                }
+            });
+        }
+        for (auto& racer : racers) racer.join();
+        stop = true;
+        trimmer.join();
+        assert(!failed);
+        assert(centralCache.threadBytes() == 0);
+    }
+    MemoryPool::setOption(Option::DelayIntervalMs, delayInterval);
+
+    std::cout << "Central bucket test passed!" << std::endl;
+}
+
+// CentralCache 争用统计测试
+void testContentionStats()
+{
+    std::cout << "Running contention stats test..." << std::endl;
+
+    Heap heap;
+    // 超过归还阈值后整批退回 CentralCache，再次分配时持锁从中心链表取出
+    std::vector<void*> ptrs;
+    for (int round = 0; round < 2; ++round)
+    {
+        for (int i = 0; i < 2000; ++i) ptrs.push_back(heap.allocate(64));
+        for (void* ptr : ptrs) heap.deallocate(ptr, 64);
+        ptrs.clear();
+    }
+
+    auto stats = heap.contentionStats();
+#if ENABLE_CENTRAL_STATS
+    auto it = std::find_if(stats.begin(), stats.end(),
+                           [](const CentralClassStats& s) { return s.blockSize == 64; });
+    assert(it != stats.end());
+    assert(it->lockAcquisitions > 0);
+    (void)it;
+    heap.resetContentionStats();
+    assert(heap.contentionStats().empty());
+#else
+    assert(stats.empty());
+#endif
+    (void)stats;
+
+    std::cout << "Contention stats test passed!" << std::endl;
+}
+
+// span 缓存着色测试
+void testCacheColouring()
+{
+    std::cout << "Running cache colouring test..." << std::endl;
+
+    Heap heap;
+    // 256B 对象每个 span 只有一百多个，取几千个会跨越多个 span；
+    // 各 span 首块的偏移依次错开一个缓存行，块地址对 256 取模不再全为 0
+    std::vector<void*> ptrs;
+    std::vector<size_t> offsets;
+    for (int i = 0; i < 2000; ++i)
+    {
+        void* ptr = heap.allocate(256);
+        std::memset(ptr, i & 0xFF, 256);
+        ptrs.push_back(ptr);
+        size_t offset = reinterpret_cast<uintptr_t>(ptr) % 256;
+        assert(offset % DefaultPolicy::CACHE_LINE == 0);
+        if (std::find(offsets.begin(), offsets.end(), offset) == offsets.end()) offsets.push_back(offset);
+    }
+    assert(offsets.size() > 1);
+    for (void* ptr : ptrs) heap.deallocate(ptr, 256);
+
+    std::cout << "Cache colouring test passed!" << std::endl;
+}
+
+// 实时模式测试：预算内分配不缺页、不扩张，耗尽后返回 nullptr
+void testRealtimeMode()
+{
+    std::cout << "Running realtime mode test..." << std::endl;
+
+    Heap heap;
+    const size_t budget = 4 * 1024 * 1024;
+    if (!heap.enableRealtime(budget))
+    {
+        // 容器中 RLIMIT_MEMLOCK 可能很小
+        std::cout << "Realtime mode unavailable (" << std::strerror(errno) << "), skipped" << std::endl;
+        return;
+    }
+    assert(heap.stats().lockedBytes >= budget);
+    size_t reserved = heap.reservedBytes();
+
+    bool prefilled = heap.reserve(64, 200);
+    assert(prefilled);
+    (void)prefilled;
+    void* ptrs[200];
+#ifdef __linux__
+    // 预取之后的分配与首次写入都不应再缺页
+    rusage before, after;
+    getrusage(RUSAGE_THREAD, &before);
+#endif
+    for (int i = 0; i < 200; ++i)
+    {
+        ptrs[i] = heap.allocate(64);
+        std::memset(ptrs[i], i, 64);
+    }
+#ifdef __linux__
+    getrusage(RUSAGE_THREAD, &after);
+    assert(after.ru_minflt == before.ru_minflt && after.ru_majflt == before.ru_majflt);
+#endif
+    for (void* ptr : ptrs) heap.deallocate(ptr, 64);
+
+    // span 元数据已预先备足：按页分配、释放大对象（切分与合并 span）以及之后耗尽预算都不再进入 malloc
+    std::vector<void*> large;
+    large.reserve(budget / 65536 + 1);
+    uint64_t newsBefore = newCalls.load();
+    const size_t hugeSize = MAX_BYTES + 3 * 4096;
+    void* huge[8];
+    for (void*& ptr : huge)
+    {
+        ptr = heap.allocate(hugeSize);
+        assert(ptr != nullptr);
+    }
+    for (size_t i = 0; i < 8; i += 2) heap.deallocate(huge[i], hugeSize);
+    for (size_t i = 1; i < 8; i += 2) heap.deallocate(huge[i], hugeSize);
+
+    // 预算耗尽：明确失败，不再向系统申请
+    while (void* ptr = heap.allocate(65536)) large.push_back(ptr);
+    assert(newCalls.load() == newsBefore);
+    (void)newsBefore;
+    assert(!large.empty() && large.size() <= budget / 65536);
+    assert(heap.reservedBytes() == reserved);
+    assert(heap.stats().budgetFailures > 0);
+    for (void* ptr : large) heap.deallocate(ptr, 65536);
+    void* again = heap.allocate(65536);
+    assert(again != nullptr);
+    heap.deallocate(again, 65536);
+    (void)reserved;
+
+    // destroy 后退出实时模式
+    heap.destroy();
+    assert(heap.stats().lockedBytes == 0);
+    std::vector<void*> more;
+    for (size_t i = 0; i < budget / 65536 * 2; ++i) more.push_back(heap.allocate(65536));
+    assert(std::find(more.begin(), more.end(), nullptr) == more.end());
+    for (void* ptr : more) heap.deallocate(ptr, 65536);
+
+    std::cout << "Realtime mode test passed!" << std::endl;
+}
+
+// 内存上限测试：软上限触发回调，硬上限使分配失败而不是继续增长
+void testMemoryLimit()
+{
+    std::cout << "Running memory limit test..." << std::endl;
+
+    Heap heap;
+    const size_t soft = 8 * 1024 * 1024;
+    const size_t hard = 16 * 1024 * 1024;
+    heap.setMemoryLimit(soft, hard);
+    size_t softEvents = 0;
+    size_t hardEvents = 0;
+    uint64_t id = heap.addPressureCallback([&](const MemoryPressure& pressure)
+    {
+        assert(pressure.softLimit == soft && pressure.hardLimit == hard);
+        ++(pressure.hard ? hardEvents : softEvents);
+    });
+
+    // 大对象（直接按页分配）与小对象（经 CentralCache 切分）两条路径；
+    // 大对象在前：关闭 Span 追踪时小对象占用的 span 不会回到 PageCache
+    for (size_t size : {size_t(1024 * 1024), size_t(65536)})
+    {
+        std::vector<void*> ptrs;
+        while (ptrs.size() < 1024)
+        {
+            void* ptr = heap.allocate(size);
+            if (!ptr) break;
+            ptrs.push_back(ptr);
+        }
+        assert(!ptrs.empty() && ptrs.size() < 1024);
+        assert(heap.stats().committedBytes <= hard);
+        for (void* ptr : ptrs) heap.deallocate(ptr, size);
+
+        // 释放后可以继续分配
+        void* again = heap.allocate(size);
+        assert(again != nullptr);
+        heap.deallocate(again, size);
+    }
+    assert(softEvents > 0 && hardEvents > 0);
+    assert(heap.stats().limitFailures > 0);
+
+    heap.removePressureCallback(id);
+    heap.setMemoryLimit(0, 0);
+    (void)softEvents;
+    (void)hardEvents;
+
+    std::cout << "Memory limit test passed!" << std::endl;
+}
+
+// 线程缓存空闲衰减与显式裁剪测试
+void testThreadCacheTrim()
+{
+    std::cout << "Running thread cache trim test..." << std::endl;
+
+    size_t interval = MemoryPool::getOption(Option::IdleDecayMs);
+    MemoryPool::setOption(Option::IdleDecayMs, 1);
+
+    Heap heap;
+    const size_t trigger = 65536;
+    const size_t batch = MemoryPool::getOption(Option::HugeBatch);
+
+    // 64B 块留在本线程缓存中，之后不再使用
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 200; ++i) ptrs.push_back(heap.allocate(64));
+    for (void* ptr : ptrs) heap.deallocate(ptr, 64);
+    assert(heap.stats().threadBytes > 0);
+
+    // 两个衰减周期：第一次记下低水位，第二次归还整个周期都没被取用的块；
+    // 触发用的 size-class 每次都被取空，不会被归还
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    void* first = heap.allocate(trigger);
+    heap.deallocate(first, trigger);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ptrs.clear();
+    for (size_t i = 0; i <= batch; ++i) ptrs.push_back(heap.allocate(trigger));
+    for (void* ptr : ptrs) heap.deallocate(ptr, trigger);
+    assert(heap.stats().threadBytes == 2 * batch * trigger);
+
+    heap.trimThreadCache();
+    assert(heap.stats().threadBytes == 0);
+    MemoryPool::setOption(Option::IdleDecayMs, 0);
+
+    // trimAll：其他线程在下次进入慢路径时清空自己的缓存
+    std::atomic<int> phase{0};
+    std::thread worker([&heap, &phase, trigger]()
+    {
+        std::vector<void*> blocks;
+        for (int i = 0; i < 100; ++i) blocks.push_back(heap.allocate(256));
+        for (void* ptr : blocks) heap.deallocate(ptr, 256);
+        phase = 1;
+        while (phase.load() != 2) std::this_thread::yield();
+        void* ptr = heap.allocate(trigger);
+        heap.deallocate(ptr, trigger);
+        phase = 3;
+        while (phase.load() != 4) std::this_thread::yield();
+    });
+    while (phase.load() != 1) std::this_thread::yield();
+    assert(heap.stats().threadBytes > 0);
+    heap.trimAll();
+    phase = 2;
+    while (phase.load() != 3) std::this_thread::yield();
+    assert(heap.stats().threadBytes == batch * trigger);
+    phase = 4;
+    worker.join();
+    (void)batch;
+
+    MemoryPool::setOption(Option::IdleDecayMs, interval);
+
+    std::cout << "Thread cache trim test passed!" << std::endl;
+}
+
+// 线程缓存的自由链表组按需申请：只释放不分配的线程、退出的线程都要正确归还
+void testLazyThreadCache()
+{
+    std::cout << "Running lazy thread cache test..." << std::endl;
+
+    Heap heap;
+    std::vector<void*> ptrs;
+    for (int i = 0; i < 300; ++i)
+    {
+        void* ptr = heap.allocate(3000);
+        std::memset(ptr, i & 0xFF, 3000);
+        ptrs.push_back(ptr);
+    }
+    size_t before = heap.stats().threadBytes;
+
+    // 该线程从未分配过这一组的 size-class，释放时才申请组；退出时全部交回 CentralCache
+    std::thread consumer([&heap, &ptrs]()
+    {
+        for (size_t i = 0; i < ptrs.size(); ++i)
+        {
+            assert(static_cast<unsigned char*>(ptrs[i])[2999] == (i & 0xFF));
+            heap.deallocate(ptrs[i], 3000);
+        }
+    });
+    consumer.join();
+    assert(heap.stats().threadBytes == before - ptrs.size() * SizeClass::roundUp(3000));
+    (void)before;
+
+    std::cout << "Lazy thread cache test passed!" << std::endl;
+}
+
+void testEpochReclamation()
+{
+    std::cout << "Running epoch reclamation test..." << std::endl;
+
+    Heap heap;
+    std::atomic<bool> entered{false};
+    std::atomic<bool> leave{false};
+
+    // 读者停留在临界区内：之后 retire 的块不能被释放
+    std::thread reader([&]()
+    {
+        EpochGuard guard(heap);
+        entered = true;
+        while (!leave) std::this_thread::yield();
+    });
+    while (!entered) std::this_thread::yield();
+
+    std::unordered_set<void*> retired;
+    for (int i = 0; i < 200; ++i)
+    {
+        void* ptr = heap.allocate(48);
+        retired.insert(ptr);
+        heap.enter();
+        bool ok = heap.retire(ptr, 48);
+        assert(ok);
+        (void)ok;
+        heap.exit();
+    }
+    for (int i = 0; i < 5; ++i) assert(heap.reclaim() == retired.size());
+
+    leave = true;
+    reader.join();
+    size_t pending = retired.size();
+    for (int i = 0; i < 5 && pending > 0; ++i) pending = heap.reclaim();
+    assert(pending == 0);
+    // 块直接放回本线程的自由链表，下一次分配即可复用
+    void* reused = heap.allocate(48);
+    assert(retired.count(reused) == 1);
+    heap.deallocate(reused, 48);
+
+    // 退出线程的待回收块交给回收域，由其他线程在纪元推进后代为释放
+    std::unordered_set<void*> orphaned;
+    std::thread writer([&]()
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            void* ptr = heap.allocate(112);
+            orphaned.insert(ptr);
+            heap.retire(ptr, 112);
+        }
+    });
+    writer.join();
+    for (int i = 0; i < 5; ++i) heap.reclaim();
+    std::vector<void*> again;
+    for (int i = 0; i < 10; ++i)
+    {
+        again.push_back(heap.allocate(112));
+        assert(orphaned.count(again.back()) == 1);
+    }
+    for (void* ptr : again) heap.deallocate(ptr, 112);
+
+    std::cout << "Epoch reclamation test passed!" << std::endl;
+}
+
+std::string bufferString(const PoolBuffer& buffer)
+{
+    std::string out(buffer.size(), '\0');
+    buffer.copyTo(&out[0], 0, out.size());
+    return out;
+}
+
+void testPoolBuffer()
+{
+    std::cout << "Running pool buffer test..." << std::endl;
+
+    // 尾段有剩余空间时原地追加
+    PoolBuffer message = PoolBuffer::create(64, 16);
+    message.append("hello", 5);
+    message.append(" world", 6);
+    assert(message.segmentCount() == 1);
+    assert(bufferString(message) == "hello world");
+
+    // 首段预留空间：头部原地写入
+    message.prepend("HDR:", 4);
+    assert(message.segmentCount() == 1);
+    assert(bufferString(message) == "HDR:hello world");
+
+    // 共享后存储不再可写，追加改为新建段，原缓冲不受影响
+    PoolBuffer copy = message.share();
+    copy.append("!", 1);
+    assert(copy.segmentCount() == 2);
+    assert(bufferString(copy) == "HDR:hello world!");
+    assert(bufferString(message) == "HDR:hello world");
+
+    PoolBuffer word = message.slice(10, 5);
+    assert(bufferString(word) == "world");
+    PoolBuffer header = message.slice(0, 4);
+    message.trimFront(4);
+    message.trimBack(6);
+    assert(bufferString(message) == "hello");
+
+    // 拼接只移动段节点
+    message.append(std::move(word));
+    message.prepend(std::move(header));
+    assert(word.empty() && header.empty());
+    assert(message.segmentCount() == 3);
+    assert(bufferString(message) == "HDR:helloworld");
+
+    // 链本身被共享：切片只记录视图，共享者各自追加时才复制段节点，互不影响
+    PoolBuffer letters;
+    for (char c = 'a'; c <= 'z'; ++c) letters.append(PoolBuffer::copyOf(&c, 1));
+    assert(letters.segmentCount() == 26);
+    PoolBuffer middle = letters.slice(2, 20);
+    PoolBuffer inner = middle.slice(3, 5);
+    assert(inner.segmentCount() == 5);
+    assert(bufferString(inner) == "fghij");
+    PoolBuffer other = letters.share();
+    letters.append("1", 1);
+    other.append("2", 1);
+    assert(bufferString(letters) == "abcdefghijklmnopqrstuvwxyz1");
+    assert(bufferString(other) == "abcdefghijklmnopqrstuvwxyz2");
+    assert(bufferString(middle) == "cdefghijklmnopqrstuv");
+
+    // 其他视图释放后链变为独占，修改时丢弃视图之外的段
+    letters.clear();
+    other.clear();
+    inner.clear();
+    middle.trimFront(1);
+    assert(middle.segmentCount() == 19);
+    assert(bufferString(middle) == "defghijklmnopqrstuv");
+
+#ifdef __linux__
+    // writev / readv
+    int fds[2];
+    int rc = pipe(fds);
+    assert(rc == 0);
+    iovec iov[8];
+    size_t iovCount = message.fillIovec(iov, 8);
+    assert(iovCount == 3);
+    ssize_t written = writev(fds[1], iov, static_cast<int>(iovCount));
+    assert(written == static_cast<ssize_t>(message.size()));
+
+    std::string payload(5000, 'x');
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>('a' + i % 26);
+    written = write(fds[1], payload.data(), payload.size());
+    assert(written == static_cast<ssize_t>(payload.size()));
+
+    PoolBuffer received;
+    size_t expected = message.size() + payload.size();
+    while (received.size() < expected)
+    {
+        iovCount = received.prepareRead(expected - received.size(), iov, 8);
+        assert(iovCount > 0);
+        ssize_t got = readv(fds[0], iov, static_cast<int>(iovCount));
+        assert(got > 0);
+        received.commitRead(static_cast<size_t>(got));
+    }
+    assert(received.segmentCount() == 2);
+    assert(bufferString(received) == "HDR:helloworld" + payload);
+    close(fds[0]);
+    close(fds[1]);
+    (void)rc;
+    (void)written;
+#endif
+
+    // 最后一个引用可以在其他线程释放
+    Heap heap;
+    std::string blob(5000, 'y');
+    PoolBuffer local = PoolBuffer::copyOf(blob.data(), blob.size(), heap);
+    PoolBuffer remote = local.slice(100, 200);
+    local.clear();
+    std::thread releaser([&remote]()
+    {
+        assert(remote.size() == 200);
+        remote.clear();
+    });
+    releaser.join();
+
+    std::cout << "Pool buffer test passed!" << std::endl;
+}
+
+void testSharedPool()
+{
+#ifdef __linux__
+    std::cout << "Running shared pool test..." << std::endl;
+
+    auto pool = SharedPool::create(16 * 1024 * 1024);
+    assert(pool);
+
+    // 同一区域的第二个映射：地址不同，句柄相同
+    auto mapped = SharedPool::attach(dup(pool->fd()));
+    assert(mapped);
+    SharedHandle handle = pool->allocate(1000);
+    assert(handle && pool->usableSize(handle) >= 1000);
+    std::strcpy(static_cast<char*>(pool->pointer(handle)), "via handle");
+    assert(mapped->pointer(handle) != pool->pointer(handle));
+    assert(std::strcmp(static_cast<char*>(mapped->pointer(handle)), "via handle") == 0);
+    pool->deallocate(handle);
+    assert(pool->stats().processes == 2);
+    mapped.reset();
+    assert(pool->stats().processes == 1);
+
+    // 父子进程经管道交接句柄，不复制负载
+    int fds[2];
+    int rc = pipe(fds);
+    assert(rc == 0);
+    SharedHandle toChild = pool->allocate(64 * 1024);
+    std::strcpy(static_cast<char*>(pool->pointer(toChild)), "from parent");
+    pool->release(toChild);
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        bool ok = pool->afterFork() && pool->adopt(toChild) &&
+                  std::strcmp(static_cast<char*>(pool->pointer(toChild)), "from parent") == 0;
+        pool->deallocate(toChild);
+        SharedHandle reply = pool->allocate(200);
+        ok = ok && reply;
+        if (reply)
+        {
+            std::strcpy(static_cast<char*>(pool->pointer(reply)), "from child");
+            pool->release(reply);
+        }
+        ok = ok && write(fds[1], &reply, sizeof(reply)) == static_cast<ssize_t>(sizeof(reply));
+        _exit(ok ? 0 : 1);
+    }
+    SharedHandle reply;
+    ssize_t got = read(fds[0], &reply, sizeof(reply));
+    assert(got == static_cast<ssize_t>(sizeof(reply)));
+    int status = 0;
+    waitpid(child, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(pool->adopt(reply));
+    assert(std::strcmp(static_cast<char*>(pool->pointer(reply)), "from child") == 0);
+    pool->deallocate(reply);
+
+    // 子进程持有块时被 SIGKILL：回收后块回到空闲栈，可被其他进程复用
+    child = fork();
+    if (child == 0)
+    {
+        if (!pool->afterFork()) _exit(1);
+        SharedHandle last;
+        for (int i = 0; i < 100; ++i) last = pool->allocate(3000);
+        ssize_t sent = write(fds[1], &last, sizeof(last));
+        (void)sent;
+        kill(getpid(), SIGKILL);
+        _exit(1);
+    }
+    SharedHandle leaked;
+    got = read(fds[0], &leaked, sizeof(leaked));
+    assert(got == static_cast<ssize_t>(sizeof(leaked)));
+    waitpid(child, &status, 0);
+    assert(WIFSIGNALED(status));
+    size_t recovered = pool->recover();
+    assert(recovered == 100);
+    assert(pool->stats().recoveredBlocks == 100);
+    // 回收按地址顺序入栈，空闲栈后进先出：子进程最后分配的块最先被复用
+    SharedHandle reused = pool->allocate(3000);
+    assert(reused.offset == leaked.offset);
+    pool->deallocate(reused);
+
+    // 持有句柄的进程释放已退出进程的块，同时另一线程 recover()：每块只回到空闲栈一次
+    for (int round = 0; round < 8; ++round)
+    {
+        const size_t orphanCount = 256;
+        child = fork();
+        if (child == 0)
+        {
+            if (!pool->afterFork()) _exit(1);
+            SharedHandle orphans[orphanCount];
+            for (size_t i = 0; i < orphanCount; ++i) orphans[i] = pool->allocate(5000);
+            ssize_t sent = write(fds[1], orphans, sizeof(orphans));
+            (void)sent;
+            kill(getpid(), SIGKILL);
+            _exit(1);
+        }
+        std::vector<SharedHandle> orphans(orphanCount);
+        size_t received = 0;
+        while (received < sizeof(SharedHandle) * orphanCount)
+        {
+            got = read(fds[0], reinterpret_cast<char*>(orphans.data()) + received,
+                       sizeof(SharedHandle) * orphanCount - received);
+            assert(got > 0);
+            received += static_cast<size_t>(got);
+        }
+        waitpid(child, &status, 0);
+        assert(WIFSIGNALED(status));
+
+        std::thread freer([&pool, &orphans]()
+        {
+            for (SharedHandle orphan : orphans) pool->deallocate(orphan);
+        });
+        pool->recover();
+        freer.join();
+
+        // 重复入栈会让同一块被分配两次
+        std::vector<SharedHandle> again;
+        std::unordered_set<uint64_t> offsets;
+        for (size_t i = 0; i < 2 * orphanCount; ++i)
+        {
+            again.push_back(pool->allocate(5000));
+            assert(again.back());
+            bool fresh = offsets.insert(again.back().offset).second;
+            assert(fresh);
+            (void)fresh;
+        }
+        for (SharedHandle block : again) pool->deallocate(block);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    (void)rc;
+    (void)got;
+    (void)recovered;
+
+    std::cout << "Shared pool test passed!" << std::endl;
+#endif
+}
+
+void testZeroedAllocation()
+{
+    std::cout << "Running zeroed allocation test..." << std::endl;
+
+    // span 级别的已知为 0 标记：新映射与归还系统后为真，用过归还后为假
+    PageCache pageCache;
+    bool zeroed = false;
+    void* span = pageCache.allocateLargeSpan(64, &zeroed);
+    assert(span && zeroed);
+    std::memset(span, 0xAB, 64 * PageCache::PAGE_SIZE);
+    pageCache.deallocateSpan(span, 64);
+    span = pageCache.allocateLargeSpan(64, &zeroed);
+    assert(!zeroed);
+    pageCache.deallocateSpan(span, 64);
+#ifdef __linux__
+    pageCache.scavenge(SIZE_MAX);
+    span = pageCache.allocateLargeSpan(64, &zeroed);
+    assert(zeroed);
+    assert(static_cast<unsigned char*>(span)[12345] == 0);
+    pageCache.deallocateSpan(span, 64);
+#endif
+
+    // 大块（跳过清零 / 非临时存储清零）与自由链表中的块复用后都必须为 0
+    Heap heap;
+    for (size_t size : {size_t(24), size_t(3000), size_t(200 * 1024), size_t(600 * 1024), size_t(4 * 1024 * 1024)})
+    {
+        for (int round = 0; round < 3; ++round)
+        {
+            unsigned char* ptr = static_cast<unsigned char*>(heap.allocateZeroed(size));
+            assert(ptr);
+            assert(std::all_of(ptr, ptr + size, [](unsigned char c) { return c == 0; }));
+            std::memset(ptr, 0x5A, size);
+            heap.deallocate(ptr, size);
+        }
+    }
+
+    // 小对象：从新 span 切出的一批只清首字。期间交错普通分配（写脏后释放）与跨 size-class 的补货，
+    // 之后 allocateZeroed 取到的每一块仍必须为 0；trim 后留存的已知为 0 的块全部回到中心缓存
+    {
+        Heap fresh;
+        const size_t size = 16 * 1024;
+        std::vector<unsigned char*> blocks;
+        for (int i = 0; i < 12; ++i)
+        {
+            unsigned char* block = static_cast<unsigned char*>(fresh.allocateZeroed(size));
+            assert(block && std::all_of(block, block + size, [](unsigned char c) { return c == 0; }));
+            blocks.push_back(block);
+            if (i % 3 == 1)
+            {
+                unsigned char* dirty = static_cast<unsigned char*>(fresh.allocate(size));
+                std::memset(dirty, 0xC3, size);
+                fresh.deallocate(dirty, size);
+            }
+            if (i == 6)
+            {
+                unsigned char* other = static_cast<unsigned char*>(fresh.allocateZeroed(4096));
+                assert(other && std::all_of(other, other + 4096, [](unsigned char c) { return c == 0; }));
+                fresh.deallocate(other, 4096);
+            }
+        }
+        for (unsigned char* block : blocks)
+        {
+            std::memset(block, 0x7E, size);
+            fresh.deallocate(block, size);
+        }
+        for (int i = 0; i < 12; ++i)
+        {
+            unsigned char* block = static_cast<unsigned char*>(fresh.allocateZeroed(size));
+            assert(block && std::all_of(block, block + size, [](unsigned char c) { return c == 0; }));
+            fresh.deallocate(block, size);
+        }
+        fresh.trimThreadCache();
+        assert(fresh.centralCache().threadBytes() == 0);
+    }
+
+    void* ptr = MemoryPool::allocateZeroed(100);
+    assert(static_cast<unsigned char*>(ptr)[99] == 0);
+    MemoryPool::deallocate(ptr, 100);
+    (void)zeroed;
+    (void)ptr;
+
+    std::cout << "Zeroed allocation test passed!" << std::endl;
+}
+
+// 测试用的 size-class 表：24 / 48 / 96 / 1000 字节
+struct TestSizeClasses
+{
+    static constexpr std::size_t COUNT = 4;
+    static constexpr std::size_t SIZES[COUNT] = {24, 48, 96, 1000};
+};
+
+struct TestSizeClassPolicy : DefaultPolicy
+{
+    using SizeClasses = TestSizeClasses;
+};
+
+void testSizeProfile()
+{
+    std::cout << "Running size profile test..." << std::endl;
+
+    // 按表取整：表内向上取到所属类，超出表中最大值后按 ALIGNMENT 步长
+    using TableClass = BasicSizeClass<TestSizeClassPolicy>;
+    static_assert(PolicyTraits<TestSizeClassPolicy>::FREE_LIST_SIZE == FREE_LIST_SIZE, "table keeps the list layout");
+    assert(TableClass::getIndex(1) == 2 && TableClass::roundUp(1) == 24);
+    assert(TableClass::getIndex(24) == 2 && TableClass::roundUp(25) == 48);
+    assert(TableClass::getIndex(49) == 11 && TableClass::roundUp(96) == 96);
+    assert(TableClass::roundUp(97) == 1000 && TableClass::getIndex(1000) == 124);
+    assert(TableClass::roundUp(1001) == 1008 && TableClass::getIndex(1001) == 125);
+    assert(TableClass::roundUp(0) == 0);
+    size_t lastClass = TableClass::getIndex(1000);
+    (void)lastClass;
+
+#if ENABLE_SIZE_PROFILE
+    // 直方图：各线程的样本在线程退出或 flushThread 时合并
+    bool started = MemoryPool::startSizeProfile();
+    assert(started);
+    (void)started;
+    std::thread worker([] {
+        for (int i = 0; i < 1000; ++i) MemoryPool::deallocate(MemoryPool::allocate(100), 100);
+    });
+    worker.join();
+    for (int i = 0; i < 10; ++i) MemoryPool::deallocate(MemoryPool::allocate(17), 17);
+    void* large = MemoryPool::allocate(MAX_BYTES + 1);
+    MemoryPool::deallocate(large, MAX_BYTES + 1);
+    MemoryPool::stopSizeProfile();
+    MemoryPool::deallocate(MemoryPool::allocate(100), 100); // 停止后不再统计
+    SizeProfile::flushThread();
+
+    SizeProfile::Snapshot snap = SizeProfile::snapshot();
+    assert(snap.samples == 1011 && snap.largeCount == 1);
+    assert(snap.buckets.size() == 2);
+    assert(snap.buckets[0].bytes == 24 && snap.buckets[0].count == 10);
+    assert(snap.buckets[1].bytes == 104 && snap.buckets[1].count == 1000);
+    assert(snap.requestedBytes == 1000 * 100 + 10 * 17);
+
+#ifdef __linux__
+    std::string path = "/tmp/mempool_size_profile_" + std::to_string(getpid()) + ".txt";
+    bool dumped = MemoryPool::dumpSizeProfile(path.c_str());
+    assert(dumped);
+    (void)dumped;
+    std::vector<std::string> lines;
+    if (FILE* file = fopen(path.c_str(), "r"))
+    {
+        char line[128];
+        while (fgets(line, sizeof(line), file)) lines.push_back(line);
+        fclose(file);
+    }
+    unlink(path.c_str());
+    assert(lines.size() == 7 && lines[5] == "24 10\n" && lines[6] == "104 1000\n");
+#endif
+#endif
+
+    std::cout << "Size profile test passed!" << std::endl;
+}
+
+// size_class_gen 的分段求解：与 O(n^2 k) 的朴素 DP 对照，并检查碎片预算与类数上限两种停止条件
+void testSizeClassPlanner()
+{
+    std::cout << "Running size class planner test..." << std::endl;
+
+    const double inf = std::numeric_limits<double>::infinity();
+    // best[k][j]：k 个类覆盖前 j 个大小的最小碎片
+    auto bruteForce = [inf](const sizegen::Profile& profile)
+    {
+        size_t n = profile.sizes.size();
+        auto cost = [&profile](size_t i, size_t j)
+        {
+            double waste = 0;
+            for (size_t t = i; t <= j; ++t)
+                waste += static_cast<double>(profile.counts[t]) * static_cast<double>(profile.sizes[j] - profile.sizes[t]);
+            return waste;
+        };
+        std::vector<std::vector<double>> best(n + 1, std::vector<double>(n + 1, inf));
+        best[0][0] = 0;
+        for (size_t k = 1; k <= n; ++k)
+            for (size_t j = 1; j <= n; ++j)
+                for (size_t i = 1; i <= j; ++i)
+                    if (best[k - 1][i - 1] != inf) best[k][j] = std::min(best[k][j], best[k - 1][i - 1] + cost(i - 1, j - 1));
+        return best;
+    };
+    auto wasteOf = [inf](const sizegen::Profile& profile, const std::vector<size_t>& classes)
+    {
+        double waste = 0;
+        for (size_t t = 0; t < profile.sizes.size(); ++t)
+        {
+            auto it = std::lower_bound(classes.begin(), classes.end(), profile.sizes[t]);
+            assert(it != classes.end());
+            if (it == classes.end()) return inf;
+            waste += static_cast<double>(profile.counts[t]) * static_cast<double>(*it - profile.sizes[t]);
+        }
+        return waste;
+    };
+    auto near = [](double a, double b) { return std::abs(a - b) <= 1e-6 * std::max(1.0, std::abs(b)); };
+    (void)wasteOf;
+    (void)near;
+
+    std::mt19937 rng(20240517);
+    for (int trial = 0; trial < 40; ++trial)
+    {
+        // 随机的升序、去重大小（granule 的倍数）与计数
+        sizegen::Profile profile;
+        size_t n = 1 + rng() % 30;
+        size_t size = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            size += profile.granule * (1 + rng() % 20);
+            profile.sizes.push_back(size);
+            profile.counts.push_back(1 + rng() % (trial % 2 ? 1000 : 5));
+        }
+        auto best = bruteForce(profile);
+
+        // 逐个增加类数：每一步的最小碎片与朴素 DP 一致，回溯出的表确实达到该碎片
+        sizegen::Planner planner(profile);
+        for (size_t k = 1; k <= n; ++k)
+        {
+            double waste = planner.addClass();
+            assert(near(waste, best[k][n]));
+            std::vector<size_t> classes = planner.classSizes();
+            assert(classes.size() == k);
+            assert(std::is_sorted(classes.begin(), classes.end()));
+            assert(classes.back() == profile.sizes.back());
+            assert(near(wasteOf(profile, classes), waste));
+            (void)waste;
+        }
+
+        // 碎片预算：停在满足预算的最少类数
+        double total = planner.totalBytes();
+        double budgetRatio = (rng() % 100) / 1000.0;
+        size_t minimal = 1;
+        while (best[minimal][n] > budgetRatio * total) ++minimal;
+        sizegen::Plan plan = sizegen::planSizeClasses(profile, budgetRatio, 256);
+        assert(plan.budgetMet);
+        assert(plan.classes.size() == minimal);
+        assert(near(plan.waste, best[minimal][n]));
+
+        // 类数上限：预算为 0 时需要 n 个类，上限更小则停在上限、报告未满足预算
+        if (n > 2)
+        {
+            plan = sizegen::planSizeClasses(profile, 0.0, 2);
+            assert(!plan.budgetMet);
+            assert(plan.classes.size() == 2);
+            assert(near(plan.waste, best[2][n]));
+        }
+        plan = sizegen::planSizeClasses(profile, 0.0, 256);
+        assert(plan.budgetMet && plan.classes == profile.sizes);
+        (void)minimal;
+    }
+
+    std::cout << "Size class planner test passed!" << std::endl;
+}
+
+void testSlowPathLog()
+{
+    std::cout << "Running slow path log test..." << std::endl;
+
+#if ENABLE_SLOW_PATH_LOG
+    auto countEvents = [](const std::vector<SlowPathEvent>& events, SlowPathEvent::Type type, uint32_t thread)
+    {
+        return std::count_if(events.begin(), events.end(), [type, thread](const SlowPathEvent& event) {
+            return event.type == type && event.thread == thread;
+        });
+    };
+    (void)countEvents;
+
+#ifdef __linux__
+    std::string path = "/tmp/mempool_slow_path_" + std::to_string(getpid()) + ".log";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+    MemoryPool::setSlowPathTrigger(1, fd); // 任何慢路径都会触发，冷却期内只写一次
+#endif
+    MemoryPool::startSlowPathLog();
+
+    // 新堆：中心缓存取块 -> 申请 span -> mmap；释放超过阈值后归还中心缓存
+    uint32_t thread = 0;
+    {
+        Heap heap;
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 2000; ++i) ptrs.push_back(heap.allocate(48));
+        for (void* ptr : ptrs) heap.deallocate(ptr, 48);
+        std::vector<SlowPathEvent> events = MemoryPool::slowPathEvents();
+        assert(!events.empty());
+        for (const SlowPathEvent& event : events)
+        {
+            if (event.type == SlowPathEvent::CentralFetch && event.sizeClass == SizeClass::getIndex(48)) thread = event.thread;
+        }
+        assert(thread != 0);
+        assert(countEvents(events, SlowPathEvent::SpanAlloc, thread) >= 1);
+        assert(countEvents(events, SlowPathEvent::SystemAlloc, thread) >= 1);
+        assert(countEvents(events, SlowPathEvent::CentralReturn, thread) >= 1);
+        for (const SlowPathEvent& event : events)
+        {
+            assert(event.wait <= event.duration);
+            if (event.type == SlowPathEvent::CentralFetch && event.thread == thread) assert(event.count >= 1);
+        }
+        assert(std::is_sorted(events.begin(), events.end(), [](const SlowPathEvent& a, const SlowPathEvent& b) {
+            return a.timestamp < b.timestamp;
+        }));
+    }
+
+    // 其他线程的事件带各自的编号
+    std::thread worker([] { MemoryPool::deallocate(MemoryPool::allocate(7000), 7000); });
+    worker.join();
+    std::vector<SlowPathEvent> events = MemoryPool::slowPathEvents();
+    assert(std::any_of(events.begin(), events.end(), [thread](const SlowPathEvent& event) {
+        return event.thread != thread && event.type == SlowPathEvent::CentralFetch;
+    }));
+
+    // 停止后不再记录
+    MemoryPool::stopSlowPathLog();
+    size_t before = MemoryPool::slowPathEvents().size();
+    {
+        Heap heap;
+        heap.deallocate(heap.allocate(64), 64);
+    }
+    assert(MemoryPool::slowPathEvents().size() == before);
+    (void)before;
+
+#ifdef __linux__
+    MemoryPool::setSlowPathTrigger(0, -1);
+    std::string triggered;
+    char buffer[4096];
+    ssize_t bytes;
+    lseek(fd, 0, SEEK_SET);
+    while ((bytes = read(fd, buffer, sizeof(buffer))) > 0) triggered.append(buffer, static_cast<size_t>(bytes));
+    close(fd);
+    unlink(path.c_str());
+    assert(SlowPathLog::triggerCount() >= 1);
+    assert(triggered.find("# slow path trigger:") == 0);
+    assert(triggered.find("# timestamp_ns thread type class count duration_ns wait_ns") != std::string::npos);
+    // system_alloc 总在 PageCache 锁内，触发推迟到外层事件结束后写出，不会以它为触发事件
+    assert(triggered.find("# slow path trigger: system_alloc") == std::string::npos);
+#endif
+#endif
+
+    std::cout << "Slow path log test passed!" << std::endl;
+}
+
+// 分配轨迹记录：多次 start / stop 后文件头与记录一致，停止与并发写入交错时不越界
+void testAllocTrace()
+{
+    std::cout << "Running alloc trace test..." << std::endl;
+
+#if ENABLE_ALLOC_TRACE && defined(__linux__)
+    std::string path = "/tmp/mempool_trace_" + std::to_string(getpid()) + ".trace";
+    auto readTrace = [&path](AllocTrace::FileHeader& header, std::vector<AllocTrace::Record>& records)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        assert(fd >= 0);
+        ssize_t bytes = read(fd, &header, sizeof(header));
+        assert(bytes == static_cast<ssize_t>(sizeof(header)));
+        records.resize(header.recordCount);
+        size_t total = records.size() * sizeof(AllocTrace::Record);
+        size_t done = 0;
+        while (done < total)
+        {
+            bytes = read(fd, reinterpret_cast<char*>(records.data()) + done, total - done);
+            assert(bytes > 0);
+            if (bytes <= 0) break;
+            done += static_cast<size_t>(bytes);
+        }
+        // 文件已截到已预留的槽位
+        assert(lseek(fd, 0, SEEK_END) == static_cast<off_t>(sizeof(header) + total));
+        (void)bytes;
+        close(fd);
+    };
+    auto countOps = [](const std::vector<AllocTrace::Record>& records, uint8_t op, size_t size)
+    {
+        return std::count_if(records.begin(), records.end(), [op, size](const AllocTrace::Record& record) {
+            return record.op == op && record.size == size;
+        });
+    };
+    (void)countOps;
+
+    // 两轮 start / record / stop，每轮的文件只含本轮的记录
+    for (size_t round = 0; round < 2; ++round)
+    {
+        size_t size = 700 + round;
+        int ops = 300 + static_cast<int>(round) * 200;
+        bool started = MemoryPool::startTrace(path.c_str(), 8192);
+        assert(started);
+        (void)started;
+        for (int i = 0; i < ops; ++i) MemoryPool::deallocate(MemoryPool::allocate(size), size);
+        MemoryPool::stopTrace();
+
+        AllocTrace::FileHeader header;
+        std::vector<AllocTrace::Record> records;
+        readTrace(header, records);
+        assert(std::memcmp(header.magic, "MPTRACE1", 8) == 0);
+        assert(header.version == AllocTrace::VERSION);
+        assert(header.recordSize == sizeof(AllocTrace::Record));
+        assert(header.dropped == 0);
+        assert(countOps(records, AllocTrace::Allocate, size) == ops);
+        assert(countOps(records, AllocTrace::Deallocate, size) == ops);
+        assert(countOps(records, AllocTrace::Allocate, 700 + (1 - round)) == 0);
+    }
+
+    // 停止后不再记录
+    MemoryPool::deallocate(MemoryPool::allocate(64), 64);
+    assert(!AllocTrace::enabled());
+
+    // 其他线程持续写入时反复 start / stop：stop 等写入者退出后才截断、解除映射；
+    // 同时不断有短命线程写入并退出，写入槽被交还、复用
+    std::atomic<bool> done{false};
+    std::thread writer([&done] {
+        while (!done.load(std::memory_order_relaxed)) MemoryPool::deallocate(MemoryPool::allocate(96), 96);
+    });
+    std::thread spawner([&done] {
+        while (!done.load(std::memory_order_relaxed))
+        {
+            std::thread shortLived([] {
+                for (int i = 0; i < 100; ++i) MemoryPool::deallocate(MemoryPool::allocate(160), 160);
+            });
+            shortLived.join();
+        }
+    });
+    for (int i = 0; i < 20; ++i)
+    {
+        bool started = MemoryPool::startTrace(path.c_str(), 4096);
+        assert(started);
+        (void)started;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        MemoryPool::stopTrace();
+    }
+    done = true;
+    writer.join();
+    spawner.join();
+
+    AllocTrace::FileHeader header;
+    std::vector<AllocTrace::Record> records;
+    readTrace(header, records);
+    assert(header.recordCount <= 4096);
+    unlink(path.c_str());
+#endif
+
+    std::cout << "Alloc trace test passed!" << std::endl;
+}
+
 int main() 
 {
     try 
@@ -194,6 +1675,26 @@ int main()
         testMultiThreading();
         testEdgeCases();
         testStress();
+        testHeapIsolation();
+        testPolicyPool();
+        testRuntimeOptions();
+        testLazyCarving();
+        testTinySlabs();
+        testContentionStats();
+        testCentralBuckets();
+        testCacheColouring();
+        testRealtimeMode();
+        testMemoryLimit();
+        testThreadCacheTrim();
+        testLazyThreadCache();
+        testEpochReclamation();
+        testPoolBuffer();
+        testSharedPool();
+        testZeroedAllocation();
+        testSizeProfile();
+        testSizeClassPlanner();
+        testSlowPathLog();
+        testAllocTrace();
 
         std::cout << "All tests passed successfully!" << std::endl;
         return 0;